@@ -0,0 +1,30 @@
+#include "animation_track.h"
+#include <algorithm>
+
+/// insert a key at time t or replace the value of the key at t
+void animation_track::set_key(double t, double value)
+{
+	auto it = std::lower_bound(keys.begin(), keys.end(), std::make_pair(t, value),
+		[](const std::pair<double, double>& a, const std::pair<double, double>& b) { return a.first < b.first; });
+	if (it != keys.end() && it->first == t)
+		it->second = value;
+	else
+		keys.insert(it, std::make_pair(t, value));
+}
+
+/// return the value at time t
+double animation_track::evaluate(double t) const
+{
+	if (keys.empty())
+		return 0;
+	if (t <= keys.front().first)
+		return keys.front().second;
+	if (t >= keys.back().first)
+		return keys.back().second;
+	auto it = std::upper_bound(keys.begin(), keys.end(), t,
+		[](double t, const std::pair<double, double>& k) { return t < k.first; });
+	const std::pair<double, double>& k0 = *(it - 1);
+	const std::pair<double, double>& k1 = *it;
+	double l = (t - k0.first) / (k1.first - k0.first);
+	return (1 - l)*k0.second + l*k1.second;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+/** piecewise linear animation of a reflected member of type double of a scene node, which
+    is identified by its name. The value is held constant before the first and after the
+    last key. */
+struct animation_track
+{
+	/// name of the animated node
+	std::string node_name;
+	/// name of the animated member as used in the reflection of the node
+	std::string member_name;
+	/// keys as pairs of time and value sorted by time
+	std::vector<std::pair<double, double> > keys;
+
+	/// construct from node and member name
+	animation_track(const std::string& _node_name = "", const std::string& _member_name = "") : node_name(_node_name), member_name(_member_name) {}
+	/// insert a key at time t or replace the value of the key at t
+	void set_key(double t, double value);
+	/// return the value at time t
+	double evaluate(double t) const;
+};
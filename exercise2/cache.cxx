@@ -0,0 +1,263 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cgv/math/fvec.h>
+#include <cgv/gui/trigger.h>
+#include "implicit_group.h"
+#include "sampled_grid.h"
+
+/** bakes its child into a regular grid of samples over a box and answers evaluations
+    inside the box by trilinear or tricubic interpolation of the samples. Baking runs in
+    a background thread and is restarted whenever the child reports a change. The thread
+    samples a detached copy of the child provided by the update handler, such that the gui
+    can change the child during the bake, and the scene is updated once the bake finished.
+    Until a valid grid is available, and outside of the box, the child is evaluated
+    directly. Nodes without update handler, such as those of detached copies, do not bake. */
+template <typename T>
+class cache_node : public implicit_group<T>
+{
+public:
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef sampled_grid<T> grid_type;
+	typedef std::shared_ptr<const grid_type> grid_ptr;
+
+protected:
+	/// proxy installed as update handler of the child to be notified about child changes
+	struct child_update_handler : public scene_update_handler
+	{
+		cache_node<T>* owner;
+		void update_scene() { owner->on_child_changed(); }
+		void update_description() { owner->implicit_base<T>::update_description(); }
+		base_ptr copy_detached(const base_ptr& node) { return owner->implicit_base<T>::update_handler ? owner->implicit_base<T>::update_handler->copy_detached(node) : base_ptr(); }
+	};
+	child_update_handler child_handler;
+	/// number of samples along each axis
+	unsigned res;
+	/// corners of the baked box
+	pnt_type box_min, box_max;
+	/// whether to use tricubic instead of trilinear interpolation
+	bool tricubic;
+	/// currently valid grid or empty pointer if the child changed since the last bake
+	grid_ptr grid;
+	/// incremented for each requested bake, such that a running bake can detect that it is outdated
+	std::atomic<unsigned> generation;
+	/// set on destruction to abort a running bake
+	std::atomic<bool> stop;
+	/// set when the child changed until a bake has been requested from the gui thread
+	bool bake_pending;
+	/// set by the bake thread when a new grid is available until the gui thread updated the scene
+	std::atomic<bool> bake_finished;
+	/// child copy and sampling parameters of the requested bake, which the bake thread copies under bake_mutex
+	struct bake_request
+	{
+		unsigned gen;
+		const implicit_base<T>* child;
+		unsigned res;
+		pnt_type box_min, box_max;
+	};
+	bake_request request;
+	/// references to the child copies of bakes requested since the bake thread was started, which keep them alive until it finished
+	std::vector<base_ptr> baked_children;
+	/// protects the bake thread management and the request
+	std::mutex bake_mutex;
+	/// whether the bake thread is currently working
+	bool bake_running;
+	/// background thread performing the bake
+	std::thread bake_thread;
+
+	/// sample the child of request r into a new grid; returns an empty pointer if the bake has been outdated by a newer request
+	grid_ptr bake(const bake_request& r)
+	{
+		if (!r.child)
+			return grid_ptr();
+		const implicit_base<T>* child_ptr = r.child;
+		std::shared_ptr<grid_type> new_grid(new grid_type());
+		new_grid->resize(typename grid_type::box_type(r.box_min, r.box_max), r.res, r.res, r.res);
+		std::atomic<bool> outdated(false);
+		parallel_for(0, int(r.res), [&](int k) {
+			if (outdated || stop || generation != r.gen) {
+				outdated = true;
+				return;
+			}
+			new_grid->sample_slice(unsigned(k), [child_ptr](const pnt_type& p) { return child_ptr->evaluate(p); });
+		});
+		if (outdated)
+			return grid_ptr();
+		return new_grid;
+	}
+	/// body of the bake thread that bakes until the result is not outdated anymore or the node is destructed
+	void bake_loop()
+	{
+		for (;;) {
+			bake_request r;
+			{
+				std::lock_guard<std::mutex> lock(bake_mutex);
+				r = request;
+			}
+			grid_ptr new_grid = bake(r);
+			std::lock_guard<std::mutex> lock(bake_mutex);
+			// outdated bakes without a newer request end the thread, which start_bake restarts
+			if (stop || r.gen == generation || r.gen == request.gen) {
+				if (!stop && r.gen == generation && new_grid) {
+					std::atomic_store(&grid, new_grid);
+					bake_finished = true;
+				}
+				bake_running = false;
+				return;
+			}
+		}
+	}
+	/// invalidate the current grid and abort a running bake; the next bake is started from the gui thread, as the child may be in construction
+	void schedule_bake()
+	{
+		std::atomic_store(&grid, grid_ptr());
+		++generation;
+		bake_pending = true;
+	}
+	/// (re)start baking a detached copy of the child in the background; returns false if no copy could be made
+	bool start_bake()
+	{
+		if (!implicit_base<T>::update_handler || group::get_nr_children() == 0)
+			return false;
+		base_ptr child_copy = implicit_base<T>::update_handler->copy_detached(group::get_child(0));
+		if (!child_copy)
+			return false;
+		std::lock_guard<std::mutex> lock(bake_mutex);
+		request.gen = generation;
+		request.child = child_copy->get_interface<implicit_base<T> >();
+		request.res = res;
+		request.box_min = box_min;
+		request.box_max = box_max;
+		if (bake_running) {
+			// the running thread may still evaluate previous copies
+			baked_children.push_back(child_copy);
+			return true;
+		}
+		if (bake_thread.joinable())
+			bake_thread.join();
+		baked_children.clear();
+		baked_children.push_back(child_copy);
+		bake_running = true;
+		bake_thread = std::thread(&cache_node<T>::bake_loop, this);
+		return true;
+	}
+	/// start pending bakes and update the scene after finished bakes in the gui thread
+	void timer_event(double t, double dt)
+	{
+		if (bake_pending && start_bake())
+			bake_pending = false;
+		if (bake_finished.exchange(false))
+			implicit_base<T>::update_scene();
+	}
+	/// rebake and pass the change on to the scene
+	void on_child_changed()
+	{
+		schedule_bake();
+		implicit_base<T>::update_scene();
+	}
+
+public:
+	cache_node() : res(64), box_min(-1.2, -1.2, -1.2), box_max(1.2, 1.2, 1.2), tricubic(false), generation(0), stop(false),
+		bake_pending(false), bake_finished(false), bake_running(false)
+	{
+		implicit_base<T>::gui_color = 0x8888FF;
+		child_handler.owner = this;
+		connect(cgv::gui::get_animation_trigger().shoot, this, &cache_node<T>::timer_event);
+	}
+	/// abort a running bake before destruction
+	~cache_node()
+	{
+		stop = true;
+		if (bake_thread.joinable())
+			bake_thread.join();
+	}
+	std::string get_type_name() const { return "cache"; }
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("res", res) &&
+			rh.reflect_member("tricubic", tricubic) &&
+			rh.reflect_member("minx", box_min(0)) &&
+			rh.reflect_member("miny", box_min(1)) &&
+			rh.reflect_member("minz", box_min(2)) &&
+			rh.reflect_member("maxx", box_max(0)) &&
+			rh.reflect_member("maxy", box_max(1)) &&
+			rh.reflect_member("maxz", box_max(2)) &&
+			implicit_group<T>::self_reflect(rh);
+	}
+	void on_set(void* member_ptr)
+	{
+		if (member_ptr == &tricubic) {
+			provider::update_member(member_ptr);
+			implicit_base<T>::update_scene();
+			return;
+		}
+		if (member_ptr == &res ||
+			(member_ptr >= &box_min(0) && member_ptr <= &box_min(2)) ||
+			(member_ptr >= &box_max(0) && member_ptr <= &box_max(2))) {
+			if (res < 2)
+				res = 2;
+			schedule_bake();
+			provider::update_member(member_ptr);
+			implicit_base<T>::update_scene();
+			return;
+		}
+		implicit_group<T>::on_set(member_ptr);
+	}
+	/// the cached grid is rebaked asynchronously after changes of the child, such that they cannot be located
+	bool map_to_children(pnt_type& p) const
+	{
+		return false;
+	}
+	/// install the proxy handler at the child and bake it
+	unsigned int append_child(base_ptr child)
+	{
+		unsigned int i = implicit_group<T>::append_child(child);
+		if (i == 0) {
+			child->get_interface<implicit_base<T> >()->set_update_handler(&child_handler);
+			schedule_bake();
+		}
+		return i;
+	}
+	/// keep the proxy as update handler of the child
+	void set_update_handler(scene_update_handler* uh)
+	{
+		implicit_base<T>::set_update_handler(uh);
+		if (group::get_nr_children() > 0)
+			implicit_group<T>::get_implicit_child(0)->set_update_handler(&child_handler);
+	}
+	T evaluate(const pnt_type& p) const
+	{
+		if (group::get_nr_children() == 0)
+			return 1;
+		grid_ptr g = std::atomic_load(&grid);
+		if (g && g->contains(p))
+			return g->interpolate(p, tricubic);
+		return implicit_group<T>::get_implicit_child(0)->evaluate(p);
+	}
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		if (group::get_nr_children() == 0)
+			return vec_type(0, 0, 0);
+		grid_ptr g = std::atomic_load(&grid);
+		if (g && g->contains(p))
+			return g->interpolate_gradient(p, tricubic);
+		return implicit_group<T>::get_implicit_child(0)->evaluate_gradient(p);
+	}
+	void create_gui()
+	{
+		provider::add_member_control(this, "res", res, "value_slider", "min=2;max=256;log=true;ticks=true");
+		provider::add_member_control(this, "tricubic", tricubic, "check");
+		provider::add_member_control(this, "minx", box_min(0), "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "miny", box_min(1), "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "minz", box_min(2), "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "maxx", box_max(0), "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "maxy", box_max(1), "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "maxz", box_max(2), "value_slider", "min=-10;max=10;ticks=true");
+		implicit_group<T>::create_gui();
+	}
+};
+
+scene_factory_registration<cache_node<double> > sfr_cache("cache");
@@ -0,0 +1,294 @@
+#include "chunked_mesh.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// identification of chunked mesh files
+const char chunked_mesh_magic[8] = { 'C', 'G', '2', 'C', 'H', 'N', 'K', '1' };
+/// file format version
+const uint32_t chunked_mesh_version = 1;
+
+/// file header
+struct chunked_mesh_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t has_normals;
+	uint32_t chunk_cells;
+	uint32_t res;
+	double box[6];
+	uint64_t nr_chunks;
+	uint64_t index_offset;
+};
+
+/// write the contents of a vector in binary form
+template <typename T>
+void write_vector(std::ostream& os, const std::vector<T>& v)
+{
+	if (!v.empty())
+		os.write((const char*)&v.front(), v.size()*sizeof(T));
+}
+
+/// append n elements of type T read from p to v and return the pointer behind them
+template <typename T>
+const unsigned char* read_array(const unsigned char* p, size_t n, std::vector<T>& v)
+{
+	size_t old_size = v.size();
+	v.resize(old_size + n);
+	if (n > 0)
+		memcpy(&v[old_size], p, n*sizeof(T));
+	return p + n*sizeof(T);
+}
+
+}
+
+/// construct with closed file
+chunked_mesh_writer::chunked_mesh_writer() : res(0), chunk_cells(0), has_normals(false), window_begin(0), slab_begin(0), nr_vertices(0), slab(0), open_layer(0)
+{
+}
+
+/// close the file on destruction
+chunked_mesh_writer::~chunked_mesh_writer()
+{
+	if (os.is_open())
+		close();
+}
+
+/// create the file for a streamed extraction of the given box and resolution, returns false if the file could not be created
+bool chunked_mesh_writer::open(const std::string& file_name, const box_type& _box, unsigned _res, unsigned _chunk_cells)
+{
+	os.open(file_name.c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	box = _box;
+	res = _res;
+	chunk_cells = std::max(1u, _chunk_cells);
+	has_normals = false;
+	window_positions.clear();
+	window_normals.clear();
+	window_begin = slab_begin = nr_vertices = 0;
+	slab = 0;
+	open_chunks.clear();
+	open_layer = 0;
+	index.clear();
+	// reserve the header, which is completed on close
+	chunked_mesh_header header;
+	memset(&header, 0, sizeof(header));
+	os.write((const char*)&header, sizeof(header));
+	return !os.fail();
+}
+
+/// keep streamed vertices in the window, colors are not stored in chunks
+void chunked_mesh_writer::add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n)
+{
+	if (ns && nr_vertices == 0)
+		has_normals = true;
+	window_positions.insert(window_positions.end(), ps, ps + n);
+	if (has_normals && ns)
+		window_normals.insert(window_normals.end(), ns, ns + n);
+	nr_vertices += uint32_t(n);
+}
+
+/// add the triangles to the chunks of their centroids
+void chunked_mesh_writer::add_triangles(const uint32_t* vis, size_t n)
+{
+	double chunk_extent[2];
+	for (int c = 0; c < 2; ++c)
+		chunk_extent[c] = chunk_cells*box.get_extent()(c) / (res - 1);
+	for (size_t t = 0; t < n; ++t) {
+		const uint32_t* tri = vis + 3 * t;
+		vtx_type centroid = window_positions[tri[0] - window_begin] + window_positions[tri[1] - window_begin] + window_positions[tri[2] - window_begin];
+		// the layer follows from the slab, which avoids rounding issues of centroids on layer boundaries
+		int32_t coords[3] = { 0, 0, int32_t(slab / chunk_cells) };
+		for (int c = 0; c < 2; ++c)
+			coords[c] = int32_t(floor((centroid(c) / 3 - box.get_min_pnt()(c)) / chunk_extent[c]));
+		// the extractor proceeds along z, so all open chunks of lower layers are complete
+		if (coords[2] != open_layer) {
+			flush();
+			open_layer = coords[2];
+		}
+		chunk_data& cd = open_chunks[std::make_pair(coords[0], coords[1])];
+		if (cd.triangles.empty() && cd.positions.empty())
+			std::copy(coords, coords + 3, cd.coords);
+		for (int c = 0; c < 3; ++c) {
+			auto it = cd.local_index.find(tri[c]);
+			uint32_t li;
+			if (it == cd.local_index.end()) {
+				li = uint32_t(cd.positions.size());
+				cd.local_index[tri[c]] = li;
+				cd.positions.push_back(window_positions[tri[c] - window_begin]);
+				if (has_normals)
+					cd.normals.push_back(window_normals[tri[c] - window_begin]);
+				cd.global_indices.push_back(tri[c]);
+			}
+			else
+				li = it->second;
+			cd.triangles.push_back(li);
+		}
+	}
+}
+
+/// release the vertices that are no longer referenced
+void chunked_mesh_writer::end_slab()
+{
+	// triangles of the next slab reference only vertices of the current slab and later ones
+	size_t nr_dropped = slab_begin - window_begin;
+	window_positions.erase(window_positions.begin(), window_positions.begin() + nr_dropped);
+	if (has_normals)
+		window_normals.erase(window_normals.begin(), window_normals.begin() + nr_dropped);
+	window_begin = slab_begin;
+	slab_begin = nr_vertices;
+	++slab;
+}
+
+/// write a chunk and append it to the index
+void chunked_mesh_writer::write_chunk(const chunk_data& cd)
+{
+	// value initialization also zeroes the padding that is written to the file
+	chunk_info ci = chunk_info();
+	std::copy(cd.coords, cd.coords + 3, ci.coords);
+	ci.nr_vertices = uint32_t(cd.positions.size());
+	ci.nr_triangles = uint32_t(cd.triangles.size() / 3);
+	ci.offset = uint64_t(os.tellp());
+	for (int c = 0; c < 3; ++c) {
+		ci.box[c] = std::numeric_limits<float>::max();
+		ci.box[c + 3] = -std::numeric_limits<float>::max();
+	}
+	for (const vtx_type& p : cd.positions)
+		for (int c = 0; c < 3; ++c) {
+			ci.box[c] = std::min(ci.box[c], p(c));
+			ci.box[c + 3] = std::max(ci.box[c + 3], p(c));
+		}
+	write_vector(os, cd.positions);
+	if (has_normals)
+		write_vector(os, cd.normals);
+	write_vector(os, cd.global_indices);
+	write_vector(os, cd.triangles);
+	index.push_back(ci);
+}
+
+/// write and release all open chunks
+void chunked_mesh_writer::flush()
+{
+	for (auto& oc : open_chunks)
+		write_chunk(oc.second);
+	open_chunks.clear();
+}
+
+/// write the remaining chunks and the index and close the file, returns false on write errors
+bool chunked_mesh_writer::close()
+{
+	flush();
+	chunked_mesh_header header = chunked_mesh_header();
+	memcpy(header.magic, chunked_mesh_magic, 8);
+	header.version = chunked_mesh_version;
+	header.has_normals = has_normals ? 1 : 0;
+	header.chunk_cells = chunk_cells;
+	header.res = res;
+	for (int c = 0; c < 3; ++c) {
+		header.box[c] = box.get_min_pnt()(c);
+		header.box[c + 3] = box.get_max_pnt()(c);
+	}
+	header.nr_chunks = index.size();
+	header.index_offset = uint64_t(os.tellp());
+	write_vector(os, index);
+	os.seekp(0);
+	os.write((const char*)&header, sizeof(header));
+	bool success = !os.fail();
+	os.close();
+	return success;
+}
+
+/// open the file and read its index, returns false if it is not a chunked mesh file or its chunks exceed the file
+bool chunked_mesh_reader::open(const std::string& file_name)
+{
+	close();
+	if (!file.open(file_name))
+		return false;
+	chunked_mesh_header header;
+	if (file.get_size() < sizeof(header)) {
+		close();
+		return false;
+	}
+	memcpy(&header, file.get_data(), sizeof(header));
+	if (memcmp(header.magic, chunked_mesh_magic, 8) != 0 || header.version != chunked_mesh_version ||
+		header.index_offset > file.get_size() || header.nr_chunks > (file.get_size() - header.index_offset) / sizeof(chunk_info)) {
+		close();
+		return false;
+	}
+	has_normals = header.has_normals != 0;
+	box = box_type(surface_extractor::pnt_type(header.box[0], header.box[1], header.box[2]), surface_extractor::pnt_type(header.box[3], header.box[4], header.box[5]));
+	read_array(file.get_data() + header.index_offset, size_t(header.nr_chunks), index);
+	// the chunk data must lie inside the file, such that read_chunk never reads behind the mapping
+	for (const chunk_info& info : index) {
+		uint64_t vertex_size = sizeof(extracted_mesh::vtx_type)*(has_normals ? 2 : 1) + sizeof(uint32_t);
+		uint64_t chunk_size = info.nr_vertices*vertex_size + 3 * sizeof(uint32_t)*uint64_t(info.nr_triangles);
+		if (info.offset > file.get_size() || chunk_size > file.get_size() - info.offset) {
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+/// close the file
+void chunked_mesh_reader::close()
+{
+	file.close();
+	index.clear();
+}
+
+/// append chunk ci to mesh, welding vertices with the same global index through global_to_local, and return false if its triangles reference missing vertices
+bool chunked_mesh_reader::read_chunk(size_t ci, extracted_mesh& mesh, std::unordered_map<uint32_t, uint32_t>& global_to_local) const
+{
+	const chunk_info& info = index[ci];
+	const unsigned char* p = file.get_data() + info.offset;
+	std::vector<extracted_mesh::vtx_type> positions, normals;
+	std::vector<uint32_t> global_indices, triangles;
+	p = read_array(p, info.nr_vertices, positions);
+	if (has_normals)
+		p = read_array(p, info.nr_vertices, normals);
+	p = read_array(p, info.nr_vertices, global_indices);
+	read_array(p, 3 * size_t(info.nr_triangles), triangles);
+	for (uint32_t vi : triangles)
+		if (vi >= info.nr_vertices)
+			return false;
+	std::vector<uint32_t> local_to_mesh(info.nr_vertices);
+	for (uint32_t v = 0; v < info.nr_vertices; ++v) {
+		auto it = global_to_local.find(global_indices[v]);
+		if (it != global_to_local.end()) {
+			local_to_mesh[v] = it->second;
+			continue;
+		}
+		local_to_mesh[v] = uint32_t(mesh.positions.size());
+		global_to_local[global_indices[v]] = local_to_mesh[v];
+		mesh.positions.push_back(positions[v]);
+		if (has_normals)
+			mesh.normals.push_back(normals[v]);
+	}
+	for (uint32_t vi : triangles)
+		mesh.triangles.push_back(local_to_mesh[vi]);
+	return true;
+}
+
+/// read all chunks whose bounding box overlaps the query box into mesh and return their number
+size_t chunked_mesh_reader::read_chunks(const box_type& query, extracted_mesh& mesh) const
+{
+	mesh.clear();
+	std::unordered_map<uint32_t, uint32_t> global_to_local;
+	size_t nr_read = 0;
+	for (size_t ci = 0; ci < index.size(); ++ci) {
+		const float* b = index[ci].box;
+		bool overlap = true;
+		for (int c = 0; c < 3; ++c)
+			overlap = overlap && b[c] <= query.get_max_pnt()(c) && b[c + 3] >= query.get_min_pnt()(c);
+		if (!overlap)
+			continue;
+		if (read_chunk(ci, mesh, global_to_local))
+			++nr_read;
+	}
+	return nr_read;
+}
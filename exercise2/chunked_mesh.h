@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <fstream>
+#include <cstdint>
+#include "surface_extractor.h"
+#include "mapped_file.h"
+
+/** entry of the chunk index of a chunked mesh file */
+struct chunk_info
+{
+	/// chunk coordinates
+	int32_t coords[3];
+	/// number of vertices and triangles of the chunk
+	uint32_t nr_vertices, nr_triangles;
+	/// offset of the chunk data from the beginning of the file
+	uint64_t offset;
+	/// bounding box of the chunk vertices as minimum and maximum point
+	float box[6];
+};
+
+/** mesh sink that partitions a streamed mesh into spatial chunks of chunk_cells^3 grid
+    cells and writes them into a binary container file. Triangles are assigned to chunks
+    by their centroid in x and y and by their slab in z. Each chunk stores its vertices
+    only once together with their global vertex indices, such that vertices on chunk
+    boundaries can be welded when several chunks are loaded. As the streaming extractor
+    proceeds slab by slab along z, the chunks of a layer are written and released as soon
+    as the extractor has passed them, and only the vertices of the last two slabs are kept.
+
+    File layout: header (magic, version, normal flag, chunk_cells, res, box, number of
+    chunks, offset of the index), chunk data (positions, optional normals, global vertex
+    indices, local triangle indices) and the chunk index at the end. */
+class chunked_mesh_writer : public mesh_sink
+{
+public:
+	/// type of the sampling box
+	typedef surface_extractor::box_type box_type;
+protected:
+	/// data of a chunk that is not written yet
+	struct chunk_data
+	{
+		int32_t coords[3];
+		std::vector<vtx_type> positions, normals;
+		std::vector<uint32_t> global_indices, triangles;
+		std::unordered_map<uint32_t, uint32_t> local_index;
+	};
+	/// output file
+	std::ofstream os;
+	/// sampling box and resolution of the extraction
+	box_type box;
+	unsigned res;
+	/// number of grid cells along each chunk edge
+	unsigned chunk_cells;
+	/// whether the streamed vertices carry normals
+	bool has_normals;
+	/// vertices of the last two slabs starting with global index window_begin
+	std::vector<vtx_type> window_positions, window_normals;
+	uint32_t window_begin;
+	/// global index of the first vertex of the current slab
+	uint32_t slab_begin;
+	/// global index of the next vertex
+	uint32_t nr_vertices;
+	/// index of the current slab
+	unsigned slab;
+	/// chunks of the current layer indexed by their x and y coordinates
+	std::map<std::pair<int32_t, int32_t>, chunk_data> open_chunks;
+	/// z coordinate of the open chunks
+	int32_t open_layer;
+	/// index of written chunks
+	std::vector<chunk_info> index;
+	/// write a chunk and append it to the index
+	void write_chunk(const chunk_data& cd);
+	/// write and release all open chunks
+	void flush();
+public:
+	/// construct with closed file
+	chunked_mesh_writer();
+	/// close the file on destruction
+	~chunked_mesh_writer();
+	/// create the file for a streamed extraction of the given box and resolution, returns false if the file could not be created
+	bool open(const std::string& file_name, const box_type& _box, unsigned _res, unsigned _chunk_cells);
+	/// keep streamed vertices in the window, colors are not stored in chunks
+	void add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n);
+	/// add the triangles to the chunks of their centroids
+	void add_triangles(const uint32_t* vis, size_t n);
+	/// release the vertices that are no longer referenced
+	void end_slab();
+	/// write the remaining chunks and the index and close the file, returns false on write errors
+	bool close();
+	/// return the number of written chunks
+	size_t get_nr_chunks() const { return index.size(); }
+};
+
+/** reader of chunked mesh files that maps the file into memory and copies only the
+    selected chunks into a mesh */
+class chunked_mesh_reader
+{
+public:
+	/// type of the query box
+	typedef surface_extractor::box_type box_type;
+protected:
+	/// mapping of the file
+	mapped_file file;
+	/// chunk index
+	std::vector<chunk_info> index;
+	/// whether vertices carry normals
+	bool has_normals;
+	/// box of the extraction
+	box_type box;
+public:
+	/// open the file and read its index, returns false if it is not a chunked mesh file or its chunks exceed the file
+	bool open(const std::string& file_name);
+	/// close the file
+	void close();
+	/// return the number of chunks
+	size_t get_nr_chunks() const { return index.size(); }
+	/// return the index entry of chunk ci
+	const chunk_info& get_chunk_info(size_t ci) const { return index[ci]; }
+	/// return the box of the extraction
+	const box_type& get_box() const { return box; }
+	/// append chunk ci to mesh, welding vertices with the same global index through global_to_local, and return false if its triangles reference missing vertices
+	bool read_chunk(size_t ci, extracted_mesh& mesh, std::unordered_map<uint32_t, uint32_t>& global_to_local) const;
+	/// read all chunks whose bounding box overlaps the query box into mesh and return their number
+	size_t read_chunks(const box_type& query, extracted_mesh& mesh) const;
+};
@@ -3,15 +3,12 @@
 #include "implicit_group.h"
 
 // ======================================================================================
-//  Task 2.1b: GENERAL HINTS
-//
-//  The common super class of all CSG nodes is implicit_group. This class defines a
-//  method ::get_implicit_child(unsigned int), which retrieves a pointer - already
-//  casted to implicit_base<T>* - to the indicated child node, on which you can then call
-//  ::evaluate() and ::evaluate_gradient().
-//  Use the method ::get_nr_children() of the super super class cgv::base::group to query
-//  the number of children registered with your operator.
-//
+//  The CSG operators select for each query point the child that decides the function
+//  value (minimum for union, maximum for intersection and difference). The selection
+//  is done once in ::eval_and_get_index(), which can optionally collect the color of
+//  the deciding child on the way, such that ::evaluate_and_color() costs a single
+//  traversal of the subtree. With GCM_COMPOSE the CSG nodes therefore show the color of
+//  the deciding child instead of the average of all children used by implicit_group.
 // ======================================================================================
 
 template <typename T>
@@ -20,36 +17,77 @@ class union_node : public implicit_group<T>
 public:
 	typedef typename implicit_base<T>::vec_type vec_type;
 	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::clr_type clr_type;
 
 	union_node() { implicit_base<T>::gui_color = 0xffff00; }
 	std::string get_type_name() const { return "union_node"; }
 
-	T eval_and_get_index(const pnt_type& p, unsigned int& selected_i) const
+	/// evaluate the minimum over all children, report the index of the minimal child in selected_i and, if selected_clr is given, its color
+	T eval_and_get_index(const pnt_type& p, unsigned int& selected_i, clr_type* selected_clr = 0) const
 	{
-		T value;
-
-		// Task 2.1b: You can outsource logic here that evaluates the operator function
-		//            and reports the index of the relevant child in selected_i
-
+		T value = std::numeric_limits<T>::infinity();
+		selected_i = 0;
+		clr_type child_clr;
+		for (unsigned int i = 0; i < group::get_nr_children(); ++i) {
+			const implicit_base<T>* child_ptr = implicit_group<T>::get_implicit_child(i);
+			T child_value = selected_clr ? child_ptr->evaluate_and_color(p, child_clr) : child_ptr->evaluate(p);
+			if (i == 0 || child_value < value) {
+				value = child_value;
+				selected_i = i;
+				if (selected_clr)
+					*selected_clr = child_clr;
+			}
+		}
 		return value;
 	}
 
 	T evaluate(const pnt_type& p) const
 	{
-		double f_p = std::numeric_limits<double>::infinity();
-
-		// Task 2.1b: Evaluate the union operator at p.
-
-		return f_p;
+		unsigned int selected_i;
+		return eval_and_get_index(p, selected_i);
 	}
 
 	vec_type evaluate_gradient(const pnt_type& p) const
 	{
-		vec_type grad_f_p(0, 0, 0);
+		if (group::get_nr_children() == 0)
+			return vec_type(0, 0, 0);
+		unsigned int selected_i;
+		eval_and_get_index(p, selected_i);
+		return implicit_group<T>::get_implicit_child(selected_i)->evaluate_gradient(p);
+	}
+
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const
+	{
+		if (group::get_nr_children() == 0) {
+			clr = implicit_base<T>::color;
+			return std::numeric_limits<T>::infinity();
+		}
+		unsigned int selected_i;
+		T value = eval_and_get_index(p, selected_i, &clr);
+		clr = implicit_group<T>::select_color(selected_i, clr, p);
+		return value;
+	}
 
-		// Task 2.1b: Return the gradient of the union operator at p
+	/// GLSL translation that folds the children with min
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const
+	{
+		std::string value = glsl_generator::literal(std::numeric_limits<T>::infinity());
+		for (unsigned int i = 0; i < group::get_nr_children(); ++i) {
+			std::string child_value = implicit_group<T>::get_implicit_child(i)->generate_glsl(g, p);
+			if (child_value.empty())
+				return child_value;
+			value = i == 0 ? child_value : g.add_variable("float", "min(" + value + ", " + child_value + ")");
+		}
+		return value;
+	}
 
-		return grad_f_p;
+protected:
+	/// the deciding child determines the composed color
+	clr_type compose_color(const pnt_type& p) const
+	{
+		clr_type clr;
+		evaluate_and_color(p, clr);
+		return clr;
 	}
 };
 
@@ -59,36 +97,77 @@ class intersection_node : public implicit_group<T>
 public:
 	typedef typename implicit_base<T>::vec_type vec_type;
 	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::clr_type clr_type;
 
 	intersection_node() { implicit_base<T>::gui_color = 0xffff00; }
 	std::string get_type_name() const { return "intersection_node"; }
 
-	T eval_and_get_index(const pnt_type& p, unsigned int& selected_i) const
+	/// evaluate the maximum over all children, report the index of the maximal child in selected_i and, if selected_clr is given, its color
+	T eval_and_get_index(const pnt_type& p, unsigned int& selected_i, clr_type* selected_clr = 0) const
 	{
-		T value;
-
-		// Task 2.1b: You can outsource logic here that evaluates the operator function
-		//            and reports the index of the relevant child in selected_i
-
+		T value = std::numeric_limits<T>::infinity();
+		selected_i = 0;
+		clr_type child_clr;
+		for (unsigned int i = 0; i < group::get_nr_children(); ++i) {
+			const implicit_base<T>* child_ptr = implicit_group<T>::get_implicit_child(i);
+			T child_value = selected_clr ? child_ptr->evaluate_and_color(p, child_clr) : child_ptr->evaluate(p);
+			if (i == 0 || child_value > value) {
+				value = child_value;
+				selected_i = i;
+				if (selected_clr)
+					*selected_clr = child_clr;
+			}
+		}
 		return value;
 	}
 
 	T evaluate(const pnt_type& p) const
 	{
-		double f_p = std::numeric_limits<double>::infinity();
-
-		// Task 2.1b: Evaluate the intersection operator at p.
-
-		return f_p;
+		unsigned int selected_i;
+		return eval_and_get_index(p, selected_i);
 	}
 
 	vec_type evaluate_gradient(const pnt_type& p) const
 	{
-		vec_type grad_f_p(0, 0, 0);
+		if (group::get_nr_children() == 0)
+			return vec_type(0, 0, 0);
+		unsigned int selected_i;
+		eval_and_get_index(p, selected_i);
+		return implicit_group<T>::get_implicit_child(selected_i)->evaluate_gradient(p);
+	}
 
-		// Task 2.1b: Return the gradient of the intersection operator at p
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const
+	{
+		if (group::get_nr_children() == 0) {
+			clr = implicit_base<T>::color;
+			return std::numeric_limits<T>::infinity();
+		}
+		unsigned int selected_i;
+		T value = eval_and_get_index(p, selected_i, &clr);
+		clr = implicit_group<T>::select_color(selected_i, clr, p);
+		return value;
+	}
+
+	/// GLSL translation that folds the children with max
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const
+	{
+		std::string value = glsl_generator::literal(std::numeric_limits<T>::infinity());
+		for (unsigned int i = 0; i < group::get_nr_children(); ++i) {
+			std::string child_value = implicit_group<T>::get_implicit_child(i)->generate_glsl(g, p);
+			if (child_value.empty())
+				return child_value;
+			value = i == 0 ? child_value : g.add_variable("float", "max(" + value + ", " + child_value + ")");
+		}
+		return value;
+	}
 
-		return grad_f_p;
+protected:
+	/// the deciding child determines the composed color
+	clr_type compose_color(const pnt_type& p) const
+	{
+		clr_type clr;
+		evaluate_and_color(p, clr);
+		return clr;
 	}
 };
 
@@ -98,36 +177,82 @@ class difference_node : public implicit_group<T>
 public:
 	typedef typename implicit_base<T>::vec_type vec_type;
 	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::clr_type clr_type;
 
 	difference_node() { implicit_base<T>::gui_color = 0xffff00; }
 	std::string get_type_name() const { return "difference_node"; }
 
-	T eval_and_get_index(const pnt_type& p, unsigned int& selected_i) const
+	/// evaluate the maximum of the first child and the negated remaining children, report the index of the deciding child in selected_i and, if selected_clr is given, its color
+	T eval_and_get_index(const pnt_type& p, unsigned int& selected_i, clr_type* selected_clr = 0) const
 	{
-		T value;
-
-		// Task 2.1b: You can outsource logic here that evaluates the operator function
-		//            and reports the index of the relevant child in selected_i
-
+		T value = std::numeric_limits<T>::infinity();
+		selected_i = 0;
+		clr_type child_clr;
+		for (unsigned int i = 0; i < group::get_nr_children(); ++i) {
+			const implicit_base<T>* child_ptr = implicit_group<T>::get_implicit_child(i);
+			T child_value = selected_clr ? child_ptr->evaluate_and_color(p, child_clr) : child_ptr->evaluate(p);
+			if (i > 0)
+				child_value = -child_value;
+			if (i == 0 || child_value > value) {
+				value = child_value;
+				selected_i = i;
+				if (selected_clr)
+					*selected_clr = child_clr;
+			}
+		}
 		return value;
 	}
 
 	T evaluate(const pnt_type& p) const
 	{
-		double f_p = std::numeric_limits<double>::infinity();
-
-		// Task 2.1b: Evaluate the difference operator at p.
-
-		return f_p;
+		unsigned int selected_i;
+		return eval_and_get_index(p, selected_i);
 	}
 
 	vec_type evaluate_gradient(const pnt_type& p) const
 	{
-		vec_type grad_f_p(0, 0, 0);
+		if (group::get_nr_children() == 0)
+			return vec_type(0, 0, 0);
+		unsigned int selected_i;
+		eval_and_get_index(p, selected_i);
+		vec_type grad_f_p = implicit_group<T>::get_implicit_child(selected_i)->evaluate_gradient(p);
+		return selected_i == 0 ? grad_f_p : -grad_f_p;
+	}
 
-		// Task 2.1b: Return the gradient of the difference operator at p
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const
+	{
+		if (group::get_nr_children() == 0) {
+			clr = implicit_base<T>::color;
+			return std::numeric_limits<T>::infinity();
+		}
+		unsigned int selected_i;
+		T value = eval_and_get_index(p, selected_i, &clr);
+		clr = implicit_group<T>::select_color(selected_i, clr, p);
+		return value;
+	}
 
-		return grad_f_p;
+	/// GLSL translation that folds the first child and the negated remaining children with max
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const
+	{
+		std::string value = glsl_generator::literal(std::numeric_limits<T>::infinity());
+		for (unsigned int i = 0; i < group::get_nr_children(); ++i) {
+			std::string child_value = implicit_group<T>::get_implicit_child(i)->generate_glsl(g, p);
+			if (child_value.empty())
+				return child_value;
+			if (i > 0)
+				child_value = "-(" + child_value + ")";
+			value = i == 0 ? child_value : g.add_variable("float", "max(" + value + ", " + child_value + ")");
+		}
+		return value;
+	}
+
+protected:
+	/// the deciding child determines the composed color
+	clr_type compose_color(const pnt_type& p) const
+	{
+		clr_type clr;
+		evaluate_and_color(p, clr);
+		return clr;
 	}
 };
 
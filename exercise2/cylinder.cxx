@@ -33,6 +33,13 @@ struct cylinder :  public implicit_primitive<T>
 		return grad_f_p;
 	}
 
+	/// GLSL translation of evaluate at the point expression p
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const
+	{
+		// Mirrors evaluate, which is left to Task 2.1a. Once it is solved, return the same
+		// function written in GLSL in terms of p, with parameters bound by g.add_uniform.
+		return glsl_generator::literal(std::numeric_limits<double>::infinity());
+	}
 	void create_gui()
 	{
 		implicit_primitive<T>::create_gui();
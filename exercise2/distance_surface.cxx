@@ -55,6 +55,15 @@ typename distance_surface<T>::vec_type distance_surface<T>::evaluate_gradient(co
 	return grad_f_p;
 }
 
+template <typename T>
+std::string distance_surface<T>::generate_glsl(glsl_generator& g, const std::string& p) const
+{
+	// Mirrors evaluate, which is left to Task 2.2. Once it is solved, return the same
+	// function written in GLSL in terms of p, with r and the knot points bound by
+	// g.add_uniform and g.add_uniform3.
+	return glsl_generator::literal(std::numeric_limits<double>::infinity());
+}
+
 /// update helper variables for edge i
 template <typename T>
 void distance_surface<T>::update_edge_precomputations(size_t ei)
@@ -43,6 +43,8 @@ public:
 	T evaluate(const pnt_type& p) const;
 	/// evaluate the gradient of the distance surface function at p
 	vec_type evaluate_gradient(const pnt_type& p) const;
+	/// GLSL translation of the distance surface function at the point expression p
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const;
 
 protected:
 	/// allow derived classes to add the title of the gui
@@ -6,7 +6,12 @@
 #include <cgv/base/register.h>
 #include <cgv/utils/file.h>
 #include <cgv/utils/stopwatch.h>
+#include <cgv_gl/gl/gl.h>
 #include <fstream>
+#include <sstream>
+#include <cctype>
+#include "sparse_brick_volume.h"
+#include "parallel_for.h"
 
 using namespace cgv::gui;
 using namespace cgv::math;
@@ -15,6 +20,17 @@ using namespace cgv::signal;
 using namespace cgv::render::gl;
 using namespace cgv::media;
 
+namespace {
+
+/// vertex of the sampling point buffer
+struct colored_point
+{
+	extracted_mesh::vtx_type p;
+	unsigned char color[4];
+};
+
+}
+
 gl_implicit_surface_drawable::gl_implicit_surface_drawable() 
 {
 #ifdef _DEBUG
@@ -23,6 +39,45 @@ gl_implicit_surface_drawable::gl_implicit_surface_drawable()
 	res = 64;
 #endif
 	box_scale = 1.2f;
+	use_sparse_volume = false;
+	narrow_band_width = 3;
+	auto_fit = false;
+	fit_depth = 6;
+	lipschitz_bound = 1;
+	fit_by_gradient = false;
+	fit_safety = 2;
+	batched_extraction = true;
+	narrow_band_sampling = false;
+	mesh_has_quads = false;
+	reuse_hermite_data = false;
+	incremental_update = false;
+	use_posted_mesh = false;
+	use_mesh_cache = true;
+	mesh_cache_budget = 256;
+	show_preview = false;
+	preview_error_reported = false;
+	streaming_extraction = false;
+	streaming_res = 512;
+	export_colors = false;
+	chunk_cells = 64;
+	show_chunks = false;
+	simplify_mesh = false;
+	target_nr_faces = 10000;
+	simplification_error = 0;
+	use_lod = false;
+	nr_lod_levels = 3;
+	lod_source = LS_EXTRACTION;
+	lod_brick_cells = 16;
+	lod_pixels_per_cell = 4;
+	lod_skirts = true;
+	use_mesh_buffer = true;
+	mesh_in_buffer = false;
+	sampling_slab = SS_NONE;
+	sampling_slab_width = 0;
+	sampling_overlay_outofdate = true;
+	extractor_has_samples = false;
+	sampling_grid_vbo = sampling_points_vbo = 0;
+	nr_sampling_grid_vertices = nr_sampling_points = 0;
 }
 
 std::string gl_implicit_surface_drawable::get_type_name() const
@@ -91,24 +146,40 @@ void gl_implicit_surface_drawable::export_volume()
 	os << "Spacing:   " << scaling(0) << ", " << scaling(1) << ", " << scaling(2) << std::endl;
 	os.close();
 
-	std::vector<unsigned char> data;
 	// prepare private members
 	pnt_type p = box.get_min_pnt();
 	pnt_type d = box.get_extent();
 	d(0) /= (res - 1); d(1) /= (res - 1); d(2) /= (res - 1);
 
+	// in sparse mode sample only the narrow band and use the signed background elsewhere
+	sparse_brick_volume<float> volume;
+	if (use_sparse_volume) {
+		double cell_size = std::max(d(0), std::max(d(1), d(2)));
+		volume.resize(box, res, res, res, float(narrow_band_width*cell_size));
+		volume.build_narrow_band([this](const pnt_type& q) { return func_ptr->evaluate(q.to_vec()); }, narrow_band_width, lipschitz_bound);
+		std::cout << "[VOLUME] narrow band uses " << volume.get_nr_allocated_bricks() << " bricks with "
+			<< volume.get_memory_size() / (1024*1024) << " MB" << std::endl;
+	}
+
+	// the volume is written slice by slice, such that only the bricks of the narrow band are kept for the whole volume
+	std::ofstream vox(fn.c_str(), std::ios::binary);
+	if (vox.fail())
+		return;
+	std::vector<unsigned char> data;
+	data.reserve(size_t(res)*res);
+
 	// prepare progression
 	cgv::utils::progression prog;
 	prog.init("export volume", res, 10);
 
 	// iterate through all slices
-	bool set = false;
 	unsigned int i, j, k;
 	for (k = 0; k < res; ++k, p(2) += d(2)) {
 		prog.step();
+		data.clear();
 		for (j = 0, p(1) = box.get_min_pnt()(1); j < res; ++j, p(1) += d(1)) {
 			for (i = 0, p(0) = box.get_min_pnt()(0); i < res; ++i, p(0) += d(0)) {
-				double v = func_ptr->evaluate(p.to_vec());
+				double v = use_sparse_volume ? volume.get_value(i, j, k) : func_ptr->evaluate(p.to_vec());
 				unsigned char value;
 				if (map_to_zero_value < map_to_one_value) {
 					if (v <= map_to_zero_value)
@@ -129,8 +200,94 @@ void gl_implicit_surface_drawable::export_volume()
 				data.push_back(value);
 			}
 		}
+		vox.write((const char*)&data.front(), data.size());
+	}
+	if (vox.fail())
+		std::cerr << "could not write " << fn << std::endl;
+}
+
+/// fit the box tightly around the zero level set within the cube of half size box_scale; returns false if no surface was found. The sampling stays at res samples per axis, as the contouring of the base class only supports cubic grids
+bool gl_implicit_surface_drawable::fit_box()
+{
+	if (!func_ptr)
+		return false;
+	struct cell { pnt_type center; double half_size; unsigned level; };
+	// check whether a cube can contain the zero level set, bounding the change of the function within
+	// the cube by the Lipschitz bound or, if requested, by the local gradient length scaled with the safety factor
+	auto may_contain_surface = [this](const cell& c) {
+		double v = func_ptr->evaluate(c.center.to_vec());
+		if (!(v == v))
+			return false;
+		double bound = fit_by_gradient ? fit_safety*std::max(func_ptr->evaluate_gradient(c.center.to_vec()).length(), 1e-6) : lipschitz_bound;
+		return std::abs(v) <= bound*c.half_size*sqrt(3.0);
+	};
+	// split the search cube into 4x4x4 start cells that are refined in parallel
+	const unsigned start_level = 2, n = 1 << start_level;
+	double start_half_size = box_scale / n;
+	std::vector<box_type> boxes(n*n*n);
+	std::vector<char> found(n*n*n, 0);
+	parallel_for(0, int(n*n*n), [&](int ci) {
+		std::vector<cell> stack;
+		cell c;
+		c.center = pnt_type(-box_scale + (2 * (ci % n) + 1)*start_half_size, -box_scale + (2 * ((ci / n) % n) + 1)*start_half_size, -box_scale + (2 * (ci / (n*n)) + 1)*start_half_size);
+		c.half_size = start_half_size;
+		c.level = start_level;
+		stack.push_back(c);
+		while (!stack.empty()) {
+			c = stack.back();
+			stack.pop_back();
+			if (!may_contain_surface(c))
+				continue;
+			if (c.level >= fit_depth) {
+				box_type b(c.center - pnt_type(c.half_size, c.half_size, c.half_size), c.center + pnt_type(c.half_size, c.half_size, c.half_size));
+				if (found[ci])
+					boxes[ci].add_axis_aligned_box(b);
+				else
+					boxes[ci] = b;
+				found[ci] = 1;
+				continue;
+			}
+			for (int i = 0; i < 8; ++i) {
+				cell child;
+				child.half_size = 0.5*c.half_size;
+				child.level = c.level + 1;
+				child.center = c.center + pnt_type((i & 1) ? child.half_size : -child.half_size, (i & 2) ? child.half_size : -child.half_size, (i & 4) ? child.half_size : -child.half_size);
+				stack.push_back(child);
+			}
+		}
+	});
+	// unite the boxes of the start cells
+	box_type fitted;
+	bool any = false;
+	for (unsigned i = 0; i < boxes.size(); ++i) {
+		if (!found[i])
+			continue;
+		if (any)
+			fitted.add_axis_aligned_box(boxes[i]);
+		else
+			fitted = boxes[i];
+		any = true;
+	}
+	if (!any)
+		return false;
+	// the leaf cells already enclose the surface with a margin of up to one leaf cell
+	box = fitted;
+	return true;
+}
+
+/// callback of the auto-fit button
+void gl_implicit_surface_drawable::fit_box_interactive()
+{
+	if (!fit_box()) {
+		std::cout << "[AUTO FIT] No surface found within [-" << box_scale << "," << box_scale << "]^3." << std::endl;
+		return;
 	}
-	cgv::utils::file::write(fn, (const char*)&data.front(), data.size());
+	for (int i = 0; i < 3; ++i) {
+		update_member(&box.ref_min_pnt()[i]);
+		update_member(&box.ref_max_pnt()[i]);
+	}
+	reuse_hermite_data = false;
+	post_rebuild();
 }
 
 /// callback used to save to obj file
@@ -152,13 +309,688 @@ void gl_implicit_surface_drawable::surface_extraction()
 {
 	double time;
 	cgv::utils::stopwatch sw(&time);
-	gl_implicit_surface_drawable_base::surface_extraction();
+	// incremental updates and rebuilds start from the samples of the last extraction, which meshes from the cache or a sweep do not provide
+	incremental_update = incremental_update && extractor_has_samples;
+	reuse_hermite_data = reuse_hermite_data && extractor_has_samples;
+	if (auto_fit && !reuse_hermite_data && !use_posted_mesh && fit_box()) {
+		for (int i = 0; i < 3; ++i) {
+			update_member(&box.ref_min_pnt()[i]);
+			update_member(&box.ref_max_pnt()[i]);
+		}
+	}
+	// grid normals and chunked meshes are only provided by the batched extractor
+	extractor_has_samples = false;
+	mesh_in_buffer = false;
+	if (batched_extraction || show_chunks || use_lod || use_posted_mesh || int(normal_computation_type) == ENM_GRID)
+		batched_surface_extraction();
+	else {
+		// the normals drawn on top of the surface belong to the batched mesh
+		mesh.clear();
+		mesh_has_quads = false;
+		gl_implicit_surface_drawable_base::surface_extraction();
+	}
+	reuse_hermite_data = false;
+	incremental_update = false;
+	changed_boxes.clear();
+	use_posted_mesh = false;
+	posted_mesh.clear();
+	sampling_overlay_outofdate = true;
 	time = sw.get_elapsed_time();
 	std::cout << "[CONTOURING] Surface extraction finished in " << time << "s." << std::endl;
 	update_member(&nr_faces);
 	update_member(&nr_vertices);
 }
 
+/// copy the contouring parameters of the base class to the extractor e
+void gl_implicit_surface_drawable::configure_extractor(surface_extractor& e)
+{
+	e.dual_contouring = int(contouring_type) == 1;
+	e.normal_mode = ExtractionNormalMode(int(normal_computation_type));
+	e.normal_threshold = normal_threshold;
+	e.consistency_threshold = consistency_threshold;
+	e.max_nr_iters = max_nr_iters;
+	e.epsilon = epsilon;
+	e.grid_epsilon = grid_epsilon;
+	e.root_method = extractor.root_method;
+	e.max_nr_root_iters = extractor.max_nr_root_iters;
+	e.lipschitz_bound = narrow_band_sampling ? lipschitz_bound : 0;
+	e.extract_colors = export_colors;
+}
+
+/// run the batched extractor with the contouring parameters of the base class and emit the mesh
+void gl_implicit_surface_drawable::batched_surface_extraction()
+{
+	configure_extractor(extractor);
+	// the mesh buffer stores triangles with one normal per vertex, so face normals, the feature handling of corner gradients and quads stay in the display list
+	int mode = int(normal_computation_type);
+	bool quads = extractor.dual_contouring && !triangulate && !simplify_mesh && !use_posted_mesh && !show_chunks;
+	bool buffered = use_mesh_buffer && !obj_out && !use_lod && !quads && mode != ENM_FACE && mode != ENM_CORNER_GRADIENT;
+	bool streamed_to_buffer = false;
+	bool from_cache = false;
+	std::string cache_key;
+	if (use_mesh_cache && !function_key.empty() && !use_posted_mesh && !show_chunks) {
+		cache_key = get_cache_key();
+		from_cache = cache.find(cache_key, mesh);
+	}
+	if (use_posted_mesh)
+		std::swap(mesh, posted_mesh);
+	else if (from_cache)
+		std::cout << "[CONTOURING] Mesh found in cache with " << cache.get_nr_entries() << " meshes using "
+			<< cache.get_memory_size() / (1024 * 1024) << " MB" << std::endl;
+	else if (show_chunks && chunk_reader.get_nr_chunks() > 0) {
+		size_t nr_chunks = chunk_reader.read_chunks(box, mesh);
+		std::cout << "[CONTOURING] Loaded " << nr_chunks << " of " << chunk_reader.get_nr_chunks() << " chunks overlapping the box" << std::endl;
+	}
+	else if (streaming_extraction && !extractor.dual_contouring && buffered && !simplify_mesh && mode == ENM_GRADIENT &&
+		!show_gradient_normals && !show_mesh_normals) {
+		// the extractor writes its output directly into the mapped buffers, such that no mesh remains to draw normals from
+		mesh.clear();
+		mesh_buffer.begin();
+		extractor.extract_streaming(func_ptr, box, res, mesh_buffer);
+		mesh_buffer.end();
+		streamed_to_buffer = true;
+		std::cout << "[CONTOURING] Streamed " << mesh_buffer.get_nr_vertices() << " vertices slice by slice into "
+			<< (mesh_buffer.is_persistent() ? "persistently mapped" : "uploaded") << " buffers" << std::endl;
+	}
+	else if (streaming_extraction && !extractor.dual_contouring) {
+		extracted_mesh_sink sink(mesh);
+		extractor.extract_streaming(func_ptr, box, res, sink);
+		std::cout << "[CONTOURING] Streamed " << mesh.positions.size() << " vertices slice by slice" << std::endl;
+	}
+	else if (incremental_update) {
+		extractor.extract_incremental(func_ptr, box, res, changed_boxes, mesh);
+		extractor_has_samples = true;
+		std::cout << "[CONTOURING] Resampled " << changed_boxes.size() << " changed boxes, "
+			<< extractor.get_nr_crossings() << " edge crossings" << std::endl;
+	}
+	else if (reuse_hermite_data && extractor.rebuild_mesh(mesh)) {
+		extractor_has_samples = true;
+		std::cout << "[CONTOURING] Mesh rebuilt from " << extractor.get_nr_crossings() << " cached edge crossings" << std::endl;
+	}
+	else {
+		extractor.extract(func_ptr, box, res, mesh);
+		extractor_has_samples = true;
+		std::cout << "[CONTOURING] " << extractor.get_nr_crossings() << " edge crossings refined in batches, "
+			<< extractor.get_memory_size() / (1024 * 1024) << " MB of samples" << std::endl;
+	}
+	mesh_has_quads = quads && !streamed_to_buffer;
+	if (streamed_to_buffer) {
+		nr_vertices = (unsigned)mesh_buffer.get_nr_vertices();
+		nr_faces = (unsigned)mesh_buffer.get_nr_triangles();
+		clear_lod();
+		mesh_in_buffer = true;
+		return;
+	}
+	// cached meshes are stored after simplification
+	if (simplify_mesh && !from_cache && !use_posted_mesh)
+		simplify_extracted_mesh();
+	if (!cache_key.empty() && !from_cache)
+		cache.insert(cache_key, mesh);
+	nr_vertices = (unsigned)mesh.positions.size();
+	nr_faces = (unsigned)mesh.get_nr_triangles();
+	if (obj_out) {
+		mesh.write_obj(*obj_out, normal_index, get_export_colors());
+		normal_index += (unsigned)mesh.positions.size();
+	}
+	else if (use_lod)
+		build_lod();
+	else if (buffered) {
+		clear_lod();
+		mesh_buffer.upload(mesh);
+		mesh_in_buffer = true;
+	}
+	else {
+		clear_lod();
+		draw_mesh();
+	}
+}
+
+/// schedule an extraction that only resamples the given boxes, as the function changed only inside of them
+void gl_implicit_surface_drawable::post_incremental_rebuild(const std::vector<surface_extractor::box_type>& boxes)
+{
+	// boxes of several updates before the next extraction accumulate
+	if (!incremental_update)
+		changed_boxes.clear();
+	changed_boxes.insert(changed_boxes.end(), boxes.begin(), boxes.end());
+	incremental_update = true;
+	post_rebuild();
+}
+
+/// set a description that identifies the current function for the mesh cache together with the stamps of the files it reads
+void gl_implicit_surface_drawable::set_function_key(const std::string& description, const std::string& file_stamps)
+{
+	function_key = mesh_cache::normalize_description(description);
+	if (!file_stamps.empty())
+		function_key += "|files=" + file_stamps;
+}
+
+/// return the cache key of the current function and extraction parameters
+std::string gl_implicit_surface_drawable::get_cache_key() const
+{
+	std::ostringstream os;
+	os.precision(17);
+	os << function_key << "|res=" << res << "|box=";
+	for (int c = 0; c < 3; ++c)
+		os << box.get_min_pnt()(c) << "," << box.get_max_pnt()(c) << ",";
+	os << "|contouring=" << int(contouring_type) << "|normals=" << int(normal_computation_type)
+		<< "|normal_threshold=" << normal_threshold << "|consistency_threshold=" << consistency_threshold
+		<< "|max_nr_iters=" << max_nr_iters << "|epsilon=" << epsilon << "|grid_epsilon=" << grid_epsilon
+		<< "|root=" << int(extractor.root_method) << "," << extractor.max_nr_root_iters
+		<< "|streaming=" << streaming_extraction << "|band=" << narrow_band_sampling;
+	if (simplify_mesh)
+		os << "|simplify=" << target_nr_faces << "," << simplification_error;
+	return os.str();
+}
+
+/// remove all meshes from the cache
+void gl_implicit_surface_drawable::clear_mesh_cache()
+{
+	cache.clear();
+	std::cout << "[CONTOURING] Mesh cache cleared" << std::endl;
+}
+
+/// schedule a rebuild that shows mesh, which is swapped out, instead of extracting the surface
+void gl_implicit_surface_drawable::post_mesh(extracted_mesh& m)
+{
+	std::swap(posted_mesh, m);
+	use_posted_mesh = true;
+	incremental_update = false;
+	changed_boxes.clear();
+	post_rebuild();
+}
+
+/// schedule an extraction from scratch that drops the boxes of pending incremental updates
+void gl_implicit_surface_drawable::post_full_rebuild()
+{
+	use_posted_mesh = false;
+	incremental_update = false;
+	changed_boxes.clear();
+	post_rebuild();
+}
+
+/** extract the current function into the obj file fn with the frame extractor. Without
+    changed boxes the frame is extracted from scratch, otherwise the frame extractor
+    resamples only the boxes and keeps the remaining samples and edge crossings of the
+    previous frame. */
+size_t gl_implicit_surface_drawable::extract_frame(const std::string& fn, const std::vector<surface_extractor::box_type>* changed_boxes)
+{
+	if (!func_ptr)
+		return 0;
+	configure_extractor(frame_extractor);
+	extracted_mesh frame;
+	if (changed_boxes)
+		frame_extractor.extract_incremental(func_ptr, box, res, *changed_boxes, frame);
+	else
+		frame_extractor.extract(func_ptr, box, res, frame);
+	std::ofstream os(fn.c_str());
+	if (os.fail())
+		return 0;
+	frame.write_obj(os);
+	return frame.get_nr_triangles();
+}
+
+/// build the levels of detail from the extracted mesh
+void gl_implicit_surface_drawable::build_lod()
+{
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	std::vector<extracted_mesh> levels(1, mesh);
+	configure_extractor(lod_extractor);
+	for (unsigned li = 1; li < nr_lod_levels; ++li) {
+		// halving the number of cells keeps the grid points of coarser levels on the finer grids
+		unsigned level_res = ((res - 1) >> li) + 1;
+		if (level_res < 4)
+			break;
+		levels.push_back(extracted_mesh());
+		// a loaded chunked mesh has no function to extract from
+		if (lod_source == LS_SIMPLIFICATION || show_chunks) {
+			levels.back() = mesh;
+			simplifier.target_nr_triangles = std::max(size_t(1), mesh.get_nr_triangles() >> (2 * li));
+			simplifier.max_error = -1;
+			simplifier.simplify(levels.back());
+		}
+		else
+			lod_extractor.extract(func_ptr, box, level_res, levels.back());
+	}
+	lod.build(box, res, lod_brick_cells, levels, lod_skirts ? 1 : 0);
+	upload_lod();
+	time = sw.get_elapsed_time();
+	std::cout << "[LOD] " << lod.get_nr_levels() << " levels in " << lod.get_nr_bricks() << " bricks built in " << time << "s." << std::endl;
+}
+
+/// upload the vertices and triangles of all levels of detail into their buffers
+void gl_implicit_surface_drawable::upload_lod()
+{
+	// buffers of previous builds are reused
+	size_t nr_buffers = lod_vbos.size();
+	if (nr_buffers < lod.get_nr_levels()) {
+		lod_vbos.resize(lod.get_nr_levels());
+		lod_ibos.resize(lod.get_nr_levels());
+		glGenBuffers(GLsizei(lod_vbos.size() - nr_buffers), &lod_vbos[nr_buffers]);
+		glGenBuffers(GLsizei(lod_ibos.size() - nr_buffers), &lod_ibos[nr_buffers]);
+	}
+	typedef lod_mesh::vtx_type vtx_type;
+	for (size_t li = 0; li < lod.get_nr_levels(); ++li) {
+		const lod_mesh::level& l = lod.get_level(li);
+		size_t positions_size = l.positions.size()*sizeof(vtx_type);
+		glBindBuffer(GL_ARRAY_BUFFER, lod_vbos[li]);
+		glBufferData(GL_ARRAY_BUFFER, 2 * positions_size, 0, GL_STATIC_DRAW);
+		if (positions_size > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, positions_size, &l.positions.front());
+			glBufferSubData(GL_ARRAY_BUFFER, positions_size, positions_size, &l.normals.front());
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod_ibos[li]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, l.triangles.size()*sizeof(uint32_t), l.triangles.empty() ? 0 : &l.triangles.front(), GL_STATIC_DRAW);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/// remove the levels of detail and release their buffers
+void gl_implicit_surface_drawable::clear_lod()
+{
+	lod.clear();
+	if (!lod_vbos.empty()) {
+		glDeleteBuffers(GLsizei(lod_vbos.size()), &lod_vbos.front());
+		glDeleteBuffers(GLsizei(lod_ibos.size()), &lod_ibos.front());
+		lod_vbos.clear();
+		lod_ibos.clear();
+	}
+}
+
+/// draw the base class visualization followed by the levels of detail
+void gl_implicit_surface_drawable::draw(cgv::render::context& ctx)
+{
+	// the base class extracts pending rebuilds when drawing, such that meshing waits while the preview is shown
+	if (show_preview && draw_preview(ctx))
+		return;
+	// the sampling grid and points are drawn from vertex buffers instead of the immediate mode of the base class
+	bool show_grid = show_sampling_grid, show_points = show_sampling_locations;
+	show_sampling_grid = show_sampling_locations = false;
+	gl_implicit_surface_drawable_base::draw(ctx);
+	show_sampling_grid = show_grid;
+	show_sampling_locations = show_points;
+	if (mesh_in_buffer)
+		draw_mesh_buffer(ctx);
+	if (show_gradient_normals || show_mesh_normals)
+		draw_mesh_normals();
+	if (use_lod && lod.get_nr_levels() > 0)
+		draw_lod(ctx);
+	if (show_sampling_grid || show_sampling_locations) {
+		if (sampling_overlay_outofdate)
+			build_sampling_overlay();
+		draw_sampling_overlay();
+	}
+}
+
+/// draw the preview and return false if it could not be drawn
+bool gl_implicit_surface_drawable::draw_preview(cgv::render::context& ctx)
+{
+	if (!preview.has_function())
+		return false;
+	cgv::render::render_types::dmat4 modelview = ctx.get_modelview_matrix();
+	cgv::render::render_types::dmat4 projection = ctx.get_projection_matrix();
+	const auto& diffuse = material.ref_diffuse_reflectance();
+	float color[3] = { diffuse[0], diffuse[1], diffuse[2] };
+	pnt_type p0 = box.get_min_pnt(), p1 = box.get_max_pnt();
+	if (preview.draw(&modelview(0, 0), &projection(0, 0), &p0(0), &p1(0), color))
+		return true;
+	if (!preview_error_reported) {
+		std::cout << "[PREVIEW] Could not build the ray marching program, showing the extracted mesh:\n" << preview.get_log() << std::endl;
+		preview_error_reported = true;
+	}
+	return false;
+}
+
+/// set the GLSL translation of the function, whose value is the expression result in g; its uniforms are read from the members bound in g in every frame
+void gl_implicit_surface_drawable::set_preview_function(const glsl_generator& g, const std::string& result)
+{
+	preview.set_function(g, result);
+	preview.set_lipschitz_bound(lipschitz_bound);
+	preview_error_reported = false;
+	post_redraw();
+}
+
+/// set the Lipschitz bound of the function after parameter changes, which is used by the box fitting and the preview
+void gl_implicit_surface_drawable::set_lipschitz_bound(double bound)
+{
+	lipschitz_bound = bound;
+	preview.set_lipschitz_bound(bound);
+}
+
+/// remove the GLSL translation, which has to be done before the members bound to its uniforms are destructed
+void gl_implicit_surface_drawable::clear_preview_function()
+{
+	preview.clear_function();
+	post_redraw();
+}
+
+/// draw the front mesh of the mesh buffer
+void gl_implicit_surface_drawable::draw_mesh_buffer(cgv::render::context& ctx)
+{
+	cgv::render::shader_program& prog = ctx.ref_surface_shader_program();
+	prog.enable(ctx);
+	ctx.set_material(material);
+	if (show_wireframe)
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	mesh_buffer.draw(prog.get_position_index(), prog.get_normal_index());
+	if (show_wireframe)
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	prog.disable(ctx);
+}
+
+/// release the vertex buffers
+void gl_implicit_surface_drawable::clear(cgv::render::context& ctx)
+{
+	mesh_buffer.destruct();
+	mesh_in_buffer = false;
+	clear_lod();
+	preview.destruct();
+	if (sampling_grid_vbo != 0) {
+		glDeleteBuffers(1, &sampling_grid_vbo);
+		glDeleteBuffers(1, &sampling_points_vbo);
+		sampling_grid_vbo = sampling_points_vbo = 0;
+	}
+	sampling_overlay_outofdate = true;
+	gl_implicit_surface_drawable_base::clear(ctx);
+}
+
+/// fill the vertex buffers of the sampling grid and the sampling points colored by the sign of the function
+void gl_implicit_surface_drawable::build_sampling_overlay()
+{
+	typedef extracted_mesh::vtx_type vtx_type;
+	pnt_type p0 = box.get_min_pnt();
+	pnt_type p1 = box.get_max_pnt();
+	vec_type d = box.get_extent() / double(res - 1);
+	// one line per grid row along each axis
+	std::vector<vtx_type> lines;
+	lines.reserve(6 * size_t(res)*res);
+	for (int a = 0; a < 3; ++a) {
+		int b = (a + 1) % 3, c = (a + 2) % 3;
+		vtx_type p;
+		for (unsigned v = 0; v < res; ++v)
+			for (unsigned u = 0; u < res; ++u) {
+				p(b) = float(p0(b) + u*d(b));
+				p(c) = float(p0(c) + v*d(c));
+				p(a) = float(p0(a));
+				lines.push_back(p);
+				p(a) = float(p1(a));
+				lines.push_back(p);
+			}
+	}
+	// points with the color of their sign, taken from the samples of the extractor if available
+	size_t nr_points = size_t(res)*res*res;
+	const std::vector<float>& values = extractor.get_values();
+	bool use_samples = extractor_has_samples && values.size() == nr_points;
+	std::vector<colored_point> points(func_ptr || use_samples ? nr_points : 0);
+	parallel_for(0, points.empty() ? 0 : int(res), [&](int k) {
+		for (unsigned j = 0; j < res; ++j)
+			for (unsigned i = 0; i < res; ++i) {
+				size_t idx = i + size_t(res)*(j + size_t(res)*k);
+				pnt_type p(p0(0) + i*d(0), p0(1) + j*d(1), p0(2) + k*d(2));
+				bool inside = use_samples ? values[idx] < 0 : func_ptr->evaluate(p.to_vec()) < 0;
+				colored_point& cp = points[idx];
+				cp.p = vtx_type(float(p(0)), float(p(1)), float(p(2)));
+				cp.color[0] = inside ? 255 : 64;
+				cp.color[1] = 64;
+				cp.color[2] = inside ? 64 : 255;
+				cp.color[3] = 255;
+			}
+	});
+	if (sampling_grid_vbo == 0) {
+		glGenBuffers(1, &sampling_grid_vbo);
+		glGenBuffers(1, &sampling_points_vbo);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, sampling_grid_vbo);
+	glBufferData(GL_ARRAY_BUFFER, lines.size()*sizeof(vtx_type), lines.empty() ? 0 : &lines.front(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, sampling_points_vbo);
+	glBufferData(GL_ARRAY_BUFFER, points.size()*sizeof(colored_point), points.empty() ? 0 : &points.front(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	nr_sampling_grid_vertices = lines.size();
+	nr_sampling_points = points.size();
+	sampling_overlay_outofdate = false;
+}
+
+/// draw the sampling grid and sampling points from their vertex buffers, clipped to the sampling slab
+void gl_implicit_surface_drawable::draw_sampling_overlay()
+{
+	// fixed function vertex arrays and clip planes as in the visualization of the base class
+	glDisable(GL_LIGHTING);
+	if (sampling_slab != SS_NONE) {
+		int a = int(sampling_slab) - 1;
+		int center[3] = { ix, iy, iz };
+		double d = box.get_extent()(a) / (res - 1);
+		// keep half a cell of margin so that the bounding grid layers are not clipped away
+		double lo = box.get_min_pnt()(a) + (center[a] - int(sampling_slab_width) - 0.5)*d;
+		double hi = box.get_min_pnt()(a) + (center[a] + int(sampling_slab_width) + 0.5)*d;
+		GLdouble lower[4] = { 0, 0, 0, -lo }, upper[4] = { 0, 0, 0, hi };
+		lower[a] = 1;
+		upper[a] = -1;
+		glClipPlane(GL_CLIP_PLANE0, lower);
+		glClipPlane(GL_CLIP_PLANE1, upper);
+		glEnable(GL_CLIP_PLANE0);
+		glEnable(GL_CLIP_PLANE1);
+	}
+	glEnableClientState(GL_VERTEX_ARRAY);
+	if (show_sampling_grid && nr_sampling_grid_vertices > 0) {
+		glColor3d(0.5, 0.5, 0.5);
+		glBindBuffer(GL_ARRAY_BUFFER, sampling_grid_vbo);
+		glVertexPointer(3, GL_FLOAT, 0, 0);
+		glDrawArrays(GL_LINES, 0, GLsizei(nr_sampling_grid_vertices));
+	}
+	if (show_sampling_locations && nr_sampling_points > 0) {
+		GLsizei stride = GLsizei(sizeof(colored_point));
+		glBindBuffer(GL_ARRAY_BUFFER, sampling_points_vbo);
+		glVertexPointer(3, GL_FLOAT, stride, 0);
+		glColorPointer(4, GL_UNSIGNED_BYTE, stride, (const void*)sizeof(extracted_mesh::vtx_type));
+		glEnableClientState(GL_COLOR_ARRAY);
+		glPointSize(3);
+		glDrawArrays(GL_POINTS, 0, GLsizei(nr_sampling_points));
+		glPointSize(1);
+		glDisableClientState(GL_COLOR_ARRAY);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	if (sampling_slab != SS_NONE) {
+		glDisable(GL_CLIP_PLANE0);
+		glDisable(GL_CLIP_PLANE1);
+	}
+	glEnable(GL_LIGHTING);
+}
+
+/// draw the bricks at their selected levels of detail
+void gl_implicit_surface_drawable::draw_lod(cgv::render::context& ctx)
+{
+	cgv::render::render_types::dmat4 modelview = ctx.get_modelview_matrix();
+	cgv::render::render_types::dmat4 projection = ctx.get_projection_matrix();
+	lod.select_levels(&modelview(0, 0), &projection(0, 0), ctx.get_height(), lod_pixels_per_cell, brick_levels);
+
+	cgv::render::shader_program& prog = ctx.ref_surface_shader_program();
+	prog.enable(ctx);
+	ctx.set_material(material);
+	int position_location = prog.get_position_index();
+	int normal_location = prog.get_normal_index();
+	glEnableVertexAttribArray(position_location);
+	glEnableVertexAttribArray(normal_location);
+	std::vector<GLsizei> counts;
+	std::vector<const void*> offsets;
+	for (size_t li = 0; li < lod.get_nr_levels() && li < lod_vbos.size(); ++li) {
+		const lod_mesh::level& l = lod.get_level(li);
+		// collect the index ranges of all bricks of this level as byte offsets into its index buffer for one draw call
+		counts.clear();
+		offsets.clear();
+		for (size_t bi = 0; bi < brick_levels.size(); ++bi) {
+			if (brick_levels[bi] != int(li) || l.brick_begin[bi + 1] == l.brick_begin[bi])
+				continue;
+			counts.push_back(GLsizei(l.brick_begin[bi + 1] - l.brick_begin[bi]));
+			offsets.push_back((const void*)(l.brick_begin[bi] * sizeof(uint32_t)));
+		}
+		if (counts.empty())
+			continue;
+		glBindBuffer(GL_ARRAY_BUFFER, lod_vbos[li]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod_ibos[li]);
+		glVertexAttribPointer(position_location, 3, GL_FLOAT, GL_FALSE, 0, 0);
+		glVertexAttribPointer(normal_location, 3, GL_FLOAT, GL_FALSE, 0, (const void*)(l.positions.size()*sizeof(lod_mesh::vtx_type)));
+		glMultiDrawElements(GL_TRIANGLES, &counts.front(), GL_UNSIGNED_INT, &offsets.front(), GLsizei(counts.size()));
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDisableVertexAttribArray(normal_location);
+	glDisableVertexAttribArray(position_location);
+	prog.disable(ctx);
+}
+
+/// simplify the extracted mesh according to target_nr_faces and simplification_error
+void gl_implicit_surface_drawable::simplify_extracted_mesh()
+{
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	size_t nr_faces_before = mesh.get_nr_triangles();
+	simplifier.target_nr_triangles = target_nr_faces;
+	simplifier.max_error = simplification_error > 0 ? simplification_error : -1;
+	simplifier.simplify(mesh);
+	time = sw.get_elapsed_time();
+	std::cout << "[SIMPLIFICATION] " << nr_faces_before << " -> " << mesh.get_nr_triangles() << " faces in " << time << "s." << std::endl;
+}
+
+/// return the color interface of the function if colors are exported, otherwise 0
+const color_evaluation_interface* gl_implicit_surface_drawable::get_export_colors() const
+{
+	return export_colors ? dynamic_cast<const color_evaluation_interface*>(func_ptr) : 0;
+}
+
+/// stream a marching cubes mesh of resolution streaming_res directly to an obj file
+void gl_implicit_surface_drawable::stream_to_obj()
+{
+	if (!func_ptr)
+		return;
+	std::string fn = file_save_dialog("choose obj output file", "Obj Files (obj):*.obj|All Files:*.*");
+	if (fn.empty())
+		return;
+	std::ofstream os(fn.c_str());
+	if (os.fail())
+		return;
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	configure_extractor(extractor);
+	obj_mesh_sink sink(os);
+	size_t nr_triangles = extractor.extract_streaming(func_ptr, box, streaming_res, sink);
+	time = sw.get_elapsed_time();
+	std::cout << "[CONTOURING] Streamed " << nr_triangles << " triangles at resolution " << streaming_res << " to " << fn << " in " << time << "s." << std::endl;
+}
+
+/// stream a marching cubes mesh of resolution streaming_res to a chunked mesh file
+void gl_implicit_surface_drawable::stream_to_chunks()
+{
+	if (!func_ptr)
+		return;
+	std::string fn = file_save_dialog("choose chunked mesh output file", "Chunked Meshes (chk):*.chk|All Files:*.*");
+	if (fn.empty())
+		return;
+	chunked_mesh_writer writer;
+	if (!writer.open(fn, box, streaming_res, chunk_cells)) {
+		std::cout << "[CONTOURING] Could not create " << fn << std::endl;
+		return;
+	}
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	configure_extractor(extractor);
+	size_t nr_triangles = extractor.extract_streaming(func_ptr, box, streaming_res, writer);
+	if (!writer.close())
+		std::cout << "[CONTOURING] Error writing " << fn << std::endl;
+	time = sw.get_elapsed_time();
+	std::cout << "[CONTOURING] Streamed " << nr_triangles << " triangles in " << writer.get_nr_chunks() << " chunks to " << fn << " in " << time << "s." << std::endl;
+}
+
+/// open a chunked mesh file for viewing
+void gl_implicit_surface_drawable::load_chunks()
+{
+	std::string fn = file_open_dialog("choose chunked mesh file", "Chunked Meshes (chk):*.chk|All Files:*.*");
+	if (fn.empty())
+		return;
+	if (!chunk_reader.open(fn)) {
+		std::cout << "[CONTOURING] " << fn << " is not a chunked mesh file" << std::endl;
+		return;
+	}
+	show_chunks = true;
+	update_member(&show_chunks);
+	post_rebuild();
+}
+
+/// emit the extracted mesh as OpenGL triangles, or as quads for dual contouring without triangulation
+void gl_implicit_surface_drawable::draw_mesh() const
+{
+	bool corner_gradient = int(normal_computation_type) == ENM_CORNER_GRADIENT;
+	// the triangle pair {q0,q1,q2}, {q0,q2,q3} of a quad is drawn as q0,q1,q2,q3
+	size_t nr_faces = mesh_has_quads ? mesh.get_nr_triangles() / 2 : mesh.get_nr_triangles();
+	static const int quad_corners[4][2] = { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 2 } };
+	static const int triangle_corners[3][2] = { { 0, 0 }, { 0, 1 }, { 0, 2 } };
+	const int (*corners)[2] = mesh_has_quads ? quad_corners : triangle_corners;
+	int nr_corners = mesh_has_quads ? 4 : 3;
+	glBegin(mesh_has_quads ? GL_QUADS : GL_TRIANGLES);
+	for (size_t f = 0; f < nr_faces; ++f) {
+		size_t t = mesh_has_quads ? 2 * f : f;
+		extracted_mesh::vtx_type fn = mesh.compute_face_normal(t);
+		if (mesh_has_quads)
+			fn += mesh.compute_face_normal(t + 1);
+		fn.normalize();
+		if (mesh.normals.empty())
+			glNormal3fv(&fn(0));
+		for (int c = 0; c < nr_corners; ++c) {
+			uint32_t vi = mesh.triangles[3 * (t + corners[c][0]) + corners[c][1]];
+			if (!mesh.normals.empty()) {
+				// at sharp features the gradient normal is replaced by the face normal
+				if (corner_gradient && dot(fn, mesh.normals[vi]) < normal_threshold)
+					glNormal3fv(&fn(0));
+				else
+					glNormal3fv(&mesh.normals[vi](0));
+			}
+			glVertex3fv(&mesh.positions[vi](0));
+		}
+	}
+	glEnd();
+}
+
+/// draw the gradient normals at the vertices and the face normals at the face centers of the extracted mesh as lines
+void gl_implicit_surface_drawable::draw_mesh_normals() const
+{
+	if (mesh.positions.empty())
+		return;
+	// lines of half a cell length
+	float length = float(0.5*box.get_extent()(0) / (res - 1));
+	glDisable(GL_LIGHTING);
+	glBegin(GL_LINES);
+	if (show_gradient_normals && !mesh.normals.empty()) {
+		glColor3d(1, 0.5, 0);
+		for (size_t vi = 0; vi < mesh.positions.size(); ++vi) {
+			glVertex3fv(&mesh.positions[vi](0));
+			extracted_mesh::vtx_type q = mesh.positions[vi] + length*mesh.normals[vi];
+			glVertex3fv(&q(0));
+		}
+	}
+	if (show_mesh_normals) {
+		glColor3d(0, 0.5, 1);
+		size_t step = mesh_has_quads ? 2 : 1;
+		for (size_t t = 0; t + step <= mesh.get_nr_triangles(); t += step) {
+			// the center of a quad is the mean of its four corners
+			extracted_mesh::vtx_type c(0, 0, 0), fn(0, 0, 0);
+			for (size_t s = 0; s < step; ++s) {
+				for (int k = 0; k < 3; ++k)
+					if (s == 0 || k == 2)
+						c += mesh.positions[mesh.triangles[3 * (t + s) + k]];
+				fn += mesh.compute_face_normal(t + s);
+			}
+			c /= float(step + 2);
+			fn.normalize();
+			glVertex3fv(&c(0));
+			extracted_mesh::vtx_type q = c + length*fn;
+			glVertex3fv(&q(0));
+		}
+	}
+	glEnd();
+	glEnable(GL_LIGHTING);
+}
+
 void gl_implicit_surface_drawable::build_display_list()
 {
 	if (find_view(nr_faces)) {
@@ -174,6 +1006,7 @@ void gl_implicit_surface_drawable::resolution_change()
 		find_control(iy)->set("max",res-1);
 		find_control(iz)->set("max",res-1);
 	}
+	reuse_hermite_data = false;
 	post_rebuild();
 }
 
@@ -183,7 +1016,23 @@ void gl_implicit_surface_drawable::create_gui()
 	if (begin_tree_node("Tesselation", triangulate)) {
 		align("\a");
 		connect_copy(add_button("save to obj")->click, rebind(this, &gl_implicit_surface_drawable::save_interactive));
+		add_member_control(this, "export colors", export_colors, "check");
+		add_member_control(this, "stream res", streaming_res, "value_slider", "min=16;max=4096;log=true;ticks=true");
+		connect_copy(add_button("stream to obj")->click, rebind(this, &gl_implicit_surface_drawable::stream_to_obj));
+		add_member_control(this, "chunk cells", chunk_cells, "value_slider", "min=8;max=512;log=true;ticks=true");
+		connect_copy(add_button("stream to chunks")->click, rebind(this, &gl_implicit_surface_drawable::stream_to_chunks));
+		connect_copy(add_button("load chunks")->click, rebind(this, &gl_implicit_surface_drawable::load_chunks));
+		add_member_control(this, "show chunks", show_chunks, "check");
 		add_member_control(this, "triangulate", triangulate, "check");
+		add_member_control(this, "simplify", simplify_mesh, "check");
+		add_member_control(this, "target faces", target_nr_faces, "value_slider", "min=0;max=1000000;log=true;ticks=true");
+		add_member_control(this, "max error", simplification_error, "value_slider", "min=0;max=0.01;log=true;ticks=true");
+		add_member_control(this, "lod", use_lod, "check");
+		add_member_control(this, "lod levels", nr_lod_levels, "value_slider", "min=1;max=6;ticks=true");
+		add_member_control(this, "lod source", (cgv::type::DummyEnum&)lod_source, "dropdown", "enums='extraction,simplification'");
+		add_member_control(this, "brick cells", lod_brick_cells, "value_slider", "min=4;max=128;log=true;ticks=true");
+		add_member_control(this, "pixels per cell", lod_pixels_per_cell, "value_slider", "min=0.5;max=32;log=true;ticks=true");
+		add_member_control(this, "skirts", lod_skirts, "check");
 		add_view("nr_vertices", nr_vertices);
 		add_view("nr_faces", nr_faces);
 		end_tree_node(triangulate);
@@ -196,6 +1045,8 @@ void gl_implicit_surface_drawable::create_gui()
 		connect_copy(add_button("adjust range")->click, rebind(this, &gl_implicit_surface_drawable::adjust_range));
 		add_member_control(this, "map to zero", map_to_zero_value, "value_slider");
 		add_member_control(this, "map to one", map_to_one_value, "value_slider");
+		add_member_control(this, "sparse volume", use_sparse_volume, "check");
+		add_member_control(this, "narrow band", narrow_band_width, "value_slider", "min=1;max=16;ticks=true");
 		connect_copy(add_button("save to vox")->click, rebind(this, &gl_implicit_surface_drawable::export_volume));
 		end_tree_node(map_to_zero_value);
 		align("\b");
@@ -203,11 +1054,21 @@ void gl_implicit_surface_drawable::create_gui()
 
 	if (begin_tree_node("Contouring", contouring_type)) {
 		align("\a");
-		add_member_control(this, "normal computation", normal_computation_type, "gradient,face,corner,corner_gradient");
+		add_member_control(this, "normal computation", normal_computation_type, "gradient,face,corner,corner_gradient,grid");
 		add_member_control(this, "gradient normals", show_gradient_normals, "check");
 		add_member_control(this, "mesh normals", show_mesh_normals, "check");
 		add_member_control(this, "threshold", normal_threshold, "value_slider", "min=-1;max=1;ticks=true");
 		add_member_control(this, "contouring", contouring_type, "dropdown", "enums='marching cubes,dual contouring'");
+		add_member_control(this, "batched extraction", batched_extraction, "check");
+		add_member_control(this, "narrow band sampling", narrow_band_sampling, "check");
+		add_member_control(this, "streaming", streaming_extraction, "check");
+		add_member_control(this, "mapped upload", use_mesh_buffer, "check");
+		add_member_control(this, "mesh cache", use_mesh_cache, "check");
+		add_member_control(this, "cache budget MB", mesh_cache_budget, "value_slider", "min=1;max=16384;log=true;ticks=true");
+		add_member_control(this, "cache directory", cache.directory);
+		connect_copy(add_button("clear cache")->click, rebind(this, &gl_implicit_surface_drawable::clear_mesh_cache));
+		add_member_control(this, "root refinement", (cgv::type::DummyEnum&)extractor.root_method, "dropdown", "enums='bisection,secant,newton'");
+		add_member_control(this, "root iterations", extractor.max_nr_root_iters, "value_slider", "min=0;max=32;ticks=true");
 		add_member_control(this, "consistency_threshold", consistency_threshold, "value_slider", "min=0.00001;max=1;log=true;ticks=true");
 		add_member_control(this, "max_nr_iters", max_nr_iters, "value_slider", "min=1;max=20;ticks=true");
 		add_member_control(this, "res", res, "value_slider", "min=4;max=100;log=true;ticks=true");
@@ -220,6 +1081,9 @@ void gl_implicit_surface_drawable::create_gui()
 	if (begin_tree_node("Visualization", show_wireframe)) {
 		align("\a");
 		add_member_control(this, "show_&wireframe", show_wireframe, "check", "shortcut='W'");
+		add_member_control(this, "ray marched preview", show_preview, "check");
+		add_member_control(this, "preview steps", preview.max_nr_steps, "value_slider", "min=16;max=1024;log=true;ticks=true");
+		add_member_control(this, "preview tolerance", preview.pixel_tolerance, "value_slider", "min=0.05;max=4;log=true;ticks=true");
 		//add_member_control(this, "ambient", material.ref_ambient(), "color<float,RGBA>");
 		add_member_control(this, "diffuse", material.ref_diffuse_reflectance(), "color<float,RGBA>");
 		add_member_control(this, "specular", material.ref_specular_reflectance(), "color<float,RGBA>");
@@ -228,8 +1092,15 @@ void gl_implicit_surface_drawable::create_gui()
 		add_member_control(this, "&box", show_box, "check", "w=50;shortcut='b'", " ");
 		add_member_control(this, "scale", box_scale, "value_slider", "w=120;min=0.01;max=100;ticks=true;log=true");
 		add_gui("box", box, "",	"options='w=100;min=-10;max=10;step=0.01;ticks=true;align=\"BL\"';align_col=' '"); align("\n");
+		connect_copy(add_button("auto-fit box")->click, rebind(this, &gl_implicit_surface_drawable::fit_box_interactive));
+		add_member_control(this, "auto fit", auto_fit, "check");
+		add_member_control(this, "fit depth", fit_depth, "value_slider", "min=2;max=10;ticks=true");
+		add_member_control(this, "fit by gradient", fit_by_gradient, "check");
+		add_member_control(this, "fit safety", fit_safety, "value_slider", "min=1;max=10;log=true;ticks=true");
 		add_member_control(this, "sampling_&grid", show_sampling_grid, "check", "shortcut='g'");
 		add_member_control(this, "sampling_&points", show_sampling_locations, "check", "shortcut='p'");
+		add_member_control(this, "slab", (cgv::type::DummyEnum&)sampling_slab, "dropdown", "enums='none,x,y,z'");
+		add_member_control(this, "slab width", sampling_slab_width, "value_slider", "min=0;max=16;ticks=true");
 		add_member_control(this, "mini_box", show_mini_box, "check");
 		add_member_control(this, "ix",ix,"value_slider", "min=0;max=10;ticks=true");
 		add_member_control(this, "iy",iy,"value_slider", "min=0;max=10;ticks=true");
@@ -260,6 +1131,9 @@ bool gl_implicit_surface_drawable::self_reflect(cgv::reflect::reflection_handler
 		rh.reflect_member("show_mesh_normals", show_mesh_normals) &&
 		rh.reflect_member("epsilon", epsilon) &&
 		rh.reflect_member("grid_epsilon", grid_epsilon) &&
+		rh.reflect_member("batched_extraction", batched_extraction) &&
+		rh.reflect_member("use_lod", use_lod) &&
+		rh.reflect_member("lod_pixels_per_cell", lod_pixels_per_cell) &&
 		rh.reflect_member("material_roughness", material.ref_roughness());
 }
 
@@ -275,15 +1149,36 @@ void gl_implicit_surface_drawable::on_set(void* p)
 			}
 		}
 	}
+	if (p == &auto_fit && auto_fit) {
+		reuse_hermite_data = false;
+		post_rebuild();
+	}
 	if (p == &res)
 		resolution_change();
-	else if (p == &contouring_type || p == &res || p == &normal_threshold || p == &consistency_threshold || 
-		 p == &max_nr_iters || p == &normal_computation_type || p == &epsilon ||
-		 p == &grid_epsilon || (p >= &box && p < &box+1) )
-		   post_rebuild();
+	else if (p == &contouring_type || p == &normal_threshold || p == &consistency_threshold || p == &max_nr_iters ||
+		 p == &triangulate || p == &simplify_mesh || p == &target_nr_faces || p == &simplification_error ||
+		 p == &use_lod || p == &nr_lod_levels || p == &lod_source || p == &lod_brick_cells || p == &lod_skirts) {
+		// samples, edge crossings and their normals stay valid
+		reuse_hermite_data = true;
+		post_rebuild();
+	}
+	else if (p == &normal_computation_type || p == &epsilon || p == &grid_epsilon || p == &batched_extraction || p == &narrow_band_sampling || p == &streaming_extraction || p == &show_chunks || p == &use_mesh_buffer ||
+		 p == &extractor.root_method || p == &extractor.max_nr_root_iters || (p >= &box && p < &box+1) ) {
+		reuse_hermite_data = false;
+		post_rebuild();
+	}
+	else if ((p == &show_gradient_normals || p == &show_mesh_normals) && mesh_in_buffer && mesh.positions.empty()) {
+		// meshes streamed into the mesh buffer are not kept in memory, so normals need another extraction
+		reuse_hermite_data = false;
+		post_rebuild();
+	}
 	else if (p == &ix || p == &iy || p == &iz || p == &show_wireframe || p == &show_sampling_grid ||
 	    p == &show_sampling_locations || p == &show_box || p == &show_mini_box || 
-		 p == &show_gradient_normals || p == &show_mesh_normals)
+		 p == &show_gradient_normals || p == &show_mesh_normals || p == &lod_pixels_per_cell ||
+		 p == &sampling_slab || p == &sampling_slab_width ||
+		 p == &show_preview || p == &preview.max_nr_steps || p == &preview.pixel_tolerance)
 			post_redraw();
+	else if (p == &mesh_cache_budget)
+		cache.memory_budget = size_t(mesh_cache_budget) << 20;
 	update_member(p);
 }
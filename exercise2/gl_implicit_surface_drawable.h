@@ -3,6 +3,29 @@
 #include <cgv_gl/gl/gl_implicit_surface_drawable_base.h>
 #include <cgv/base/base.h>
 #include <cgv/gui/provider.h>
+#include "surface_extractor.h"
+#include "chunked_mesh.h"
+#include "mesh_simplifier.h"
+#include "lod_mesh.h"
+#include "gl_mesh_buffer.h"
+#include "mesh_cache.h"
+#include "gl_ray_marcher.h"
+
+/// sources of the coarser levels of detail
+enum LodSource
+{
+	LS_EXTRACTION,
+	LS_SIMPLIFICATION
+};
+
+/// axis of the slab around ix, iy or iz to which the sampling grid and sampling points are clipped
+enum SamplingSlab
+{
+	SS_NONE,
+	SS_X,
+	SS_Y,
+	SS_Z
+};
 
 /** drawable that visualizes implicit surfaces by contouring them with marching cubes or
     dual contouring. */
@@ -19,6 +42,154 @@ private:
 protected:
 	double map_to_zero_value;
 	double map_to_one_value;
+	/// whether to sample the volume only in a narrow band around the surface before export
+	bool use_sparse_volume;
+	/// width of the narrow band in cells
+	double narrow_band_width;
+	/// whether to fit the box, but not the resolution, to the surface before each extraction
+	bool auto_fit;
+	/// number of subdivision levels used to fit the box
+	unsigned fit_depth;
+	/// upper bound on the gradient length of the function, which bounds the change of the function within a cell when fitting the box
+	double lipschitz_bound;
+	/// whether to bound the change of the function within a cell by the local gradient length scaled with fit_safety instead of the Lipschitz bound, which is faster to converge but may miss thin parts of the surface
+	bool fit_by_gradient;
+	/// factor applied to the local gradient length if fit_by_gradient is set
+	double fit_safety;
+	/// whether to contour with the batched surface extractor instead of the point wise contouring of the base class
+	bool batched_extraction;
+	/// whether the batched extractor samples only the bricks of the grid that may contain the surface according to the Lipschitz bound
+	bool narrow_band_sampling;
+	/// extractor that refines all edge crossings together
+	surface_extractor extractor;
+	/// mesh of the last batched extraction
+	extracted_mesh mesh;
+	/// whether consecutive triangle pairs of mesh form the quads of dual contouring
+	bool mesh_has_quads;
+	/// set when only parameters of the mesh construction changed, such that the next extraction reuses the Hermite data of the last one
+	bool reuse_hermite_data;
+	/// whether marching cubes meshes are extracted slice by slice with memory quadratic in the resolution
+	bool streaming_extraction;
+	/// resolution used to stream the surface directly to an obj file
+	unsigned streaming_res;
+	/// whether obj files carry the surface color of the function per vertex if the function provides colors, which the extractor captures at the vertices
+	bool export_colors;
+	/// return the color interface of the function if colors are exported, otherwise 0
+	const color_evaluation_interface* get_export_colors() const;
+	/// whether to simplify extracted meshes by quadric based edge collapses
+	bool simplify_mesh;
+	/// number of faces the simplification aims at, 0 for no target
+	unsigned target_nr_faces;
+	/// bound on the root mean square distance of moved vertices to the planes of their quadrics, 0 for no bound
+	double simplification_error;
+	/// simplifier applied after extraction
+	mesh_simplifier simplifier;
+	/// simplify the extracted mesh according to target_nr_faces and simplification_error
+	void simplify_extracted_mesh();
+	/// whether to draw the extracted mesh with a level of detail per brick chosen from its projected size
+	bool use_lod;
+	/// number of levels of detail including the full resolution
+	unsigned nr_lod_levels;
+	/// whether coarser levels are extracted at halved resolutions or simplified from the full mesh
+	LodSource lod_source;
+	/// number of grid cells along the edges of the bricks
+	unsigned lod_brick_cells;
+	/// maximal projected size of a grid cell in pixels before a finer level is selected
+	double lod_pixels_per_cell;
+	/// whether bricks carry skirts that hide cracks between bricks of different levels
+	bool lod_skirts;
+	/// extractor of the coarser levels, which keeps the Hermite data of the full resolution in extractor intact
+	surface_extractor lod_extractor;
+	/// bricked levels of detail of the last extraction
+	lod_mesh lod;
+	/// per brick the level selected in the last frame
+	std::vector<int> brick_levels;
+	/// per level of detail the vertex buffer holding the positions followed by the normals and the index buffer of the brick sorted triangles
+	std::vector<unsigned> lod_vbos, lod_ibos;
+	/// build the levels of detail from the extracted mesh
+	void build_lod();
+	/// upload the vertices and triangles of all levels of detail into their buffers
+	void upload_lod();
+	/// remove the levels of detail and release their buffers
+	void clear_lod();
+	/// draw the bricks at their selected levels of detail
+	void draw_lod(cgv::render::context& ctx);
+	/// whether meshes with vertex normals are written to mapped buffers instead of being compiled into the display list
+	bool use_mesh_buffer;
+	/// double buffered GPU storage of the extracted mesh
+	gl_mesh_buffer mesh_buffer;
+	/// whether the last extraction went to the mesh buffer
+	bool mesh_in_buffer;
+	/// draw the front mesh of the mesh buffer
+	void draw_mesh_buffer(cgv::render::context& ctx);
+	/// axis of the slab to which the sampling grid and points are clipped
+	SamplingSlab sampling_slab;
+	/// number of grid layers on either side of the clipping slab's center layer
+	unsigned sampling_slab_width;
+	/// set by extractions to rebuild the vertex buffers of the sampling grid and sampling points before the next draw
+	bool sampling_overlay_outofdate;
+	/// whether the samples of the extractor belong to the current extraction
+	bool extractor_has_samples;
+	/// vertex buffers of the sampling grid lines and of the colored sampling points
+	unsigned sampling_grid_vbo, sampling_points_vbo;
+	/// number of vertices in the sampling grid and sampling point buffers
+	size_t nr_sampling_grid_vertices, nr_sampling_points;
+	/// fill the vertex buffers of the sampling grid and the sampling points colored by the sign of the function
+	void build_sampling_overlay();
+	/// draw the sampling grid and sampling points from their vertex buffers, clipped to the sampling slab
+	void draw_sampling_overlay();
+	/// set by post_incremental_rebuild if the function changed only inside of changed_boxes since the last extraction
+	bool incremental_update;
+	/// boxes that contain all changes of the function since the last extraction
+	std::vector<surface_extractor::box_type> changed_boxes;
+	/// extractor of animation frames that keeps the samples of the previous frame
+	surface_extractor frame_extractor;
+	/// set by post_mesh to show posted_mesh instead of extracting the surface in the next rebuild
+	bool use_posted_mesh;
+	/// mesh passed to post_mesh
+	extracted_mesh posted_mesh;
+	/// whether batched extractions are looked up in and stored to the mesh cache
+	bool use_mesh_cache;
+	/// memory budget of the mesh cache in MB
+	unsigned mesh_cache_budget;
+	/// meshes of previous extractions
+	mesh_cache cache;
+	/// normalized description of the function set with set_function_key, empty if unknown
+	std::string function_key;
+	/// return the cache key of the current function and extraction parameters
+	std::string get_cache_key() const;
+	/// remove all meshes from the cache
+	void clear_mesh_cache();
+	/// whether to show the ray marched preview of the GLSL translation of the function instead of the extracted mesh
+	bool show_preview;
+	/// GPU sphere tracer of the GLSL translation
+	gl_ray_marcher preview;
+	/// set once a failed build of the preview program has been reported
+	bool preview_error_reported;
+	/// draw the preview and return false if it could not be drawn
+	bool draw_preview(cgv::render::context& ctx);
+	/// run the batched extractor with the contouring parameters of the base class and emit the mesh
+	void batched_surface_extraction();
+	/// stream a marching cubes mesh of resolution streaming_res directly to an obj file
+	void stream_to_obj();
+	/// number of grid cells along the edges of the chunks written by stream_to_chunks
+	unsigned chunk_cells;
+	/// reader of the chunked mesh file shown instead of the extracted surface
+	chunked_mesh_reader chunk_reader;
+	/// whether to show the chunks of the loaded chunked mesh file that overlap the box instead of extracting the surface
+	bool show_chunks;
+	/// stream a marching cubes mesh of resolution streaming_res to a chunked mesh file
+	void stream_to_chunks();
+	/// open a chunked mesh file for viewing
+	void load_chunks();
+	/// emit the extracted mesh as OpenGL triangles, or as quads for dual contouring without triangulation
+	void draw_mesh() const;
+	/// draw the gradient normals at the vertices and the face normals at the face centers of the extracted mesh as lines
+	void draw_mesh_normals() const;
+	/// fit the box tightly around the zero level set within the cube of half size box_scale; returns false if no surface was found. The sampling stays at res samples per axis, as the contouring of the base class only supports cubic grids
+	bool fit_box();
+	/// callback of the auto-fit button
+	void fit_box_interactive();
 	void toggle_range();
 	void adjust_range();
 	void export_volume();
@@ -31,6 +202,30 @@ public:
 	/// standard constructor does not initialize the function pointer so that nothing is drawn
 	gl_implicit_surface_drawable();
 	void on_set(void* member_ptr);
+	/// draw the base class visualization followed by the levels of detail
+	void draw(cgv::render::context& ctx);
+	/// release the vertex buffers
+	void clear(cgv::render::context& ctx);
+	/// copy the contouring parameters of the base class to the extractor e
+	void configure_extractor(surface_extractor& e);
+	/// schedule a rebuild that shows mesh, which is swapped out, instead of extracting the surface
+	void post_mesh(extracted_mesh& m);
+	/// schedule an extraction that only resamples the given boxes, as the function changed only inside of them
+	void post_incremental_rebuild(const std::vector<surface_extractor::box_type>& boxes);
+	/// schedule an extraction from scratch that drops the boxes of pending incremental updates
+	void post_full_rebuild();
+	/// set the GLSL translation of the function, whose value is the expression result in g; its uniforms are read from the members bound in g in every frame
+	void set_preview_function(const glsl_generator& g, const std::string& result);
+	/// remove the GLSL translation, which has to be done before the members bound to its uniforms are destructed
+	void clear_preview_function();
+	/// set the Lipschitz bound of the function after parameter changes, which is used by the box fitting and the preview
+	void set_lipschitz_bound(double bound);
+	/// set a description that identifies the current function for the mesh cache together with the stamps of the files it reads; comments starting with % are ignored and runs of whitespace count as one space
+	void set_function_key(const std::string& description, const std::string& file_stamps = std::string());
+	/// return the number of samples along each axis
+	unsigned get_sampling_resolution() const { return res; }
+	/// extract the current function into the obj file fn with the frame extractor, resampling only the changed_boxes of the previous frame if given; returns the number of triangles
+	size_t extract_frame(const std::string& fn, const std::vector<surface_extractor::box_type>* changed_boxes);
 	bool self_reflect(cgv::reflect::reflection_handler& rh);
 	std::string get_type_name() const;
 	void create_gui();
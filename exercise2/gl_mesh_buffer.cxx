@@ -0,0 +1,243 @@
+#include "gl_mesh_buffer.h"
+#include <cgv_gl/gl/gl.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/// flags of the persistently mapped buffer storage
+const GLbitfield persistent_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+/// minimal capacity of a buffer in bytes
+const size_t min_capacity = 1 << 16;
+
+}
+
+/// construct without buffers
+gl_mesh_buffer::gl_mesh_buffer() : front(0), initialized(false), persistent(false)
+{
+	for (slot& s : slots) {
+		for (mapped_array& a : s.arrays) {
+			a.buffer = 0;
+			a.capacity = a.size = 0;
+			a.data = 0;
+		}
+		s.nr_vertices = s.nr_indices = 0;
+		s.fence = 0;
+	}
+}
+
+/// create the buffers and detect support for persistent mapping
+void gl_mesh_buffer::init()
+{
+	if (initialized)
+		return;
+	persistent = GLEW_ARB_buffer_storage ? true : false;
+	// with buffer storage the buffers are created on demand in reserve, as their storage is immutable
+	if (!persistent)
+		for (slot& s : slots)
+			for (mapped_array& a : s.arrays)
+				glGenBuffers(1, &a.buffer);
+	initialized = true;
+}
+
+/// unmap and delete all buffers and fences
+void gl_mesh_buffer::destruct()
+{
+	for (slot& s : slots) {
+		for (mapped_array& a : s.arrays) {
+			if (a.data) {
+				glBindBuffer(GL_COPY_WRITE_BUFFER, a.buffer);
+				glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			}
+			if (a.buffer != 0)
+				glDeleteBuffers(1, &a.buffer);
+			a.buffer = 0;
+			a.capacity = a.size = 0;
+			a.data = 0;
+			std::vector<unsigned char>().swap(a.staging);
+		}
+		if (s.fence)
+			glDeleteSync((GLsync)s.fence);
+		s.fence = 0;
+		s.nr_vertices = s.nr_indices = 0;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	initialized = false;
+}
+
+/// make sure that array a can hold nr_bytes, growing its buffer if necessary, and fall back to client memory if it cannot be mapped
+void gl_mesh_buffer::reserve(mapped_array& a, size_t nr_bytes)
+{
+	if (nr_bytes <= a.capacity)
+		return;
+	size_t capacity = std::max(std::max(nr_bytes, 2 * a.capacity), min_capacity);
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, capacity, 0, persistent_flags);
+	unsigned char* data = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacity, persistent_flags);
+	if (!data) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+		fall_back();
+		return;
+	}
+	if (a.buffer != 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, a.buffer);
+		// the written part moves on the GPU, as reading back from the write only mapping is undefined
+		if (a.size > 0) {
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, a.size);
+			glFinish();
+		}
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glDeleteBuffers(1, &a.buffer);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	a.buffer = buffer;
+	a.data = data;
+	a.capacity = capacity;
+}
+
+/// unmap all buffers and continue in the fallback path, keeping the data written into the back slot
+void gl_mesh_buffer::fall_back()
+{
+	persistent = false;
+	slot& b = back();
+	for (slot& s : slots)
+		for (mapped_array& a : s.arrays) {
+			if (!a.data)
+				continue;
+			glBindBuffer(GL_COPY_WRITE_BUFFER, a.buffer);
+			// reading through the write only mapping is undefined, but buffers mapped persistently can be read by GL
+			if (&s == &b) {
+				a.staging.resize(a.size);
+				if (a.size > 0)
+					glGetBufferSubData(GL_COPY_WRITE_BUFFER, 0, a.size, &a.staging.front());
+			}
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			a.data = 0;
+		}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/// append nr_bytes from data to array a
+void gl_mesh_buffer::append(mapped_array& a, const void* data, size_t nr_bytes)
+{
+	if (nr_bytes == 0)
+		return;
+	if (persistent)
+		reserve(a, a.size + nr_bytes);
+	if (persistent) {
+		if (data)
+			memcpy(a.data + a.size, data, nr_bytes);
+		else
+			memset(a.data + a.size, 0, nr_bytes);
+	}
+	else {
+		if (data)
+			a.staging.insert(a.staging.end(), (const unsigned char*)data, (const unsigned char*)data + nr_bytes);
+		else
+			a.staging.resize(a.staging.size() + nr_bytes, 0);
+	}
+	a.size += nr_bytes;
+}
+
+/// block until the GPU finished the last draw call from slot s
+void gl_mesh_buffer::wait(slot& s)
+{
+	if (!s.fence)
+		return;
+	while (glClientWaitSync((GLsync)s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+		;
+	glDeleteSync((GLsync)s.fence);
+	s.fence = 0;
+}
+
+/// start writing a new mesh into the back buffers
+void gl_mesh_buffer::begin()
+{
+	init();
+	slot& s = back();
+	wait(s);
+	for (mapped_array& a : s.arrays) {
+		a.size = 0;
+		a.staging.clear();
+	}
+	s.nr_vertices = s.nr_indices = 0;
+}
+
+/// append vertices, which need normals for shading; missing normals are stored as zero and colors are ignored
+void gl_mesh_buffer::add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n)
+{
+	slot& s = back();
+	append(s.arrays[0], ps, n*sizeof(vtx_type));
+	append(s.arrays[1], ns, n*sizeof(vtx_type));
+	s.nr_vertices += n;
+}
+
+/// append triangles
+void gl_mesh_buffer::add_triangles(const uint32_t* vis, size_t n)
+{
+	slot& s = back();
+	append(s.arrays[2], vis, 3 * n*sizeof(uint32_t));
+	s.nr_indices += 3 * n;
+}
+
+/// finish the mesh of the back buffers and make it the front mesh
+void gl_mesh_buffer::end()
+{
+	slot& s = back();
+	if (!persistent) {
+		for (mapped_array& a : s.arrays) {
+			// the immutable storage of buffers created before a fallback cannot be reallocated
+			if (a.buffer == 0 || a.capacity > 0) {
+				if (a.buffer != 0)
+					glDeleteBuffers(1, &a.buffer);
+				glGenBuffers(1, &a.buffer);
+				a.capacity = 0;
+			}
+			glBindBuffer(GL_COPY_WRITE_BUFFER, a.buffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, a.size, a.staging.empty() ? 0 : &a.staging.front(), GL_STATIC_DRAW);
+			std::vector<unsigned char>().swap(a.staging);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	front = 1 - front;
+}
+
+/// write mesh into the back buffers and make it the front mesh
+void gl_mesh_buffer::upload(const extracted_mesh& mesh)
+{
+	begin();
+	size_t n = mesh.positions.size();
+	add_vertices(n > 0 ? &mesh.positions.front() : 0, mesh.normals.size() == n && n > 0 ? &mesh.normals.front() : 0, 0, n);
+	add_triangles(mesh.triangles.empty() ? 0 : &mesh.triangles.front(), mesh.get_nr_triangles());
+	end();
+}
+
+/// draw the front mesh with the given vertex attribute locations and fence the used buffers
+void gl_mesh_buffer::draw(int position_location, int normal_location)
+{
+	slot& s = slots[front];
+	if (s.nr_indices == 0)
+		return;
+	glBindBuffer(GL_ARRAY_BUFFER, s.arrays[0].buffer);
+	glVertexAttribPointer(position_location, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(position_location);
+	glBindBuffer(GL_ARRAY_BUFFER, s.arrays[1].buffer);
+	glVertexAttribPointer(normal_location, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(normal_location);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.arrays[2].buffer);
+	glDrawElements(GL_TRIANGLES, GLsizei(s.nr_indices), GL_UNSIGNED_INT, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDisableVertexAttribArray(normal_location);
+	glDisableVertexAttribArray(position_location);
+	// the next extraction into these buffers has to wait for the GPU to finish reading them
+	if (persistent) {
+		if (s.fence)
+			glDeleteSync((GLsync)s.fence);
+		s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
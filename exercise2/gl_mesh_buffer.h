@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "surface_extractor.h"
+
+/** GPU storage of an extracted mesh with vertex normals that extractions write into
+    directly. Where buffer storage is supported, positions, normals and triangle indices
+    are written into persistently and coherently mapped buffers, such that the streaming
+    extractor emits its output straight into memory the GPU reads from. The storage is
+    double buffered: an extraction fills the back buffers after waiting for the fence placed
+    behind the last draw call that used them, and end() only swaps the front and back
+    buffers. Without buffer storage the data is collected in client memory and uploaded with
+    glBufferData in end(), which is also used from the first buffer on that cannot be mapped
+    persistently. Buffers keep their capacity across extractions and grow
+    geometrically by GPU side copies. All methods need a current OpenGL context. */
+class gl_mesh_buffer : public mesh_sink
+{
+protected:
+	/// one buffer object that is appended to
+	struct mapped_array
+	{
+		/// OpenGL buffer object
+		unsigned buffer;
+		/// allocated and used number of bytes
+		size_t capacity, size;
+		/// persistent mapping of the buffer or 0 in the fallback path
+		unsigned char* data;
+		/// client side copy collected in the fallback path
+		std::vector<unsigned char> staging;
+	};
+	/// positions, normals and triangle indices of one mesh together with the fence of its last draw
+	struct slot
+	{
+		mapped_array arrays[3];
+		size_t nr_vertices, nr_indices;
+		void* fence;
+	};
+	/// front slot for drawing and back slot for writing
+	slot slots[2];
+	/// index of the front slot
+	int front;
+	/// whether buffers are created
+	bool initialized;
+	/// whether persistent mapping is supported
+	bool persistent;
+	/// make sure that array a can hold nr_bytes, growing its buffer if necessary, and fall back to client memory if it cannot be mapped
+	void reserve(mapped_array& a, size_t nr_bytes);
+	/// unmap all buffers and continue in the fallback path, keeping the data written into the back slot
+	void fall_back();
+	/// append nr_bytes from data to array a
+	void append(mapped_array& a, const void* data, size_t nr_bytes);
+	/// block until the GPU finished the last draw call from slot s
+	void wait(slot& s);
+	/// return the slot that is written
+	slot& back() { return slots[1 - front]; }
+public:
+	/// construct without buffers
+	gl_mesh_buffer();
+	/// create the buffers and detect support for persistent mapping
+	void init();
+	/// unmap and delete all buffers and fences
+	void destruct();
+	/// return whether persistent mapping is used
+	bool is_persistent() const { return persistent; }
+	/// start writing a new mesh into the back buffers
+	void begin();
+	/// append vertices, which need normals for shading; missing normals are stored as zero and colors are ignored
+	void add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n);
+	/// append triangles
+	void add_triangles(const uint32_t* vis, size_t n);
+	/// finish the mesh of the back buffers and make it the front mesh
+	void end();
+	/// write mesh into the back buffers and make it the front mesh
+	void upload(const extracted_mesh& mesh);
+	/// return the number of vertices of the front mesh
+	size_t get_nr_vertices() const { return slots[front].nr_vertices; }
+	/// return the number of triangles of the front mesh
+	size_t get_nr_triangles() const { return slots[front].nr_indices / 3; }
+	/// draw the front mesh with the given vertex attribute locations and fence the used buffers
+	void draw(int position_location, int normal_location);
+};
@@ -0,0 +1,297 @@
+#include "gl_ray_marcher.h"
+#include <cgv_gl/gl/gl.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// full-screen triangle generated from the vertex index
+const char* vertex_source =
+	"#version 330 core\n"
+	"out vec2 ndc;\n"
+	"void main()\n"
+	"{\n"
+	"\tndc = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);\n"
+	"\tgl_Position = vec4(ndc, 0.0, 1.0);\n"
+	"}\n";
+
+/// declarations of the fragment shader preceding the distance function
+const char* fragment_header =
+	"#version 330 core\n"
+	"uniform mat4 inverse_mvp;\n"
+	"uniform mat4 mvp;\n"
+	"uniform vec3 box_min;\n"
+	"uniform vec3 box_max;\n"
+	"uniform float step_scale;\n"
+	"uniform int max_nr_steps;\n"
+	"uniform float pixel_tolerance;\n"
+	"uniform vec3 surface_color;\n"
+	"in vec2 ndc;\n"
+	"out vec4 frag_color;\n";
+
+/// sphere tracing of scene_distance, which follows the distance function
+const char* fragment_main =
+	"void main()\n"
+	"{\n"
+	"\t// ray from the near to the far plane through the pixel\n"
+	"\tvec4 p0 = inverse_mvp*vec4(ndc, -1.0, 1.0);\n"
+	"\tvec4 p1 = inverse_mvp*vec4(ndc, 1.0, 1.0);\n"
+	"\tvec3 o = p0.xyz/p0.w;\n"
+	"\tvec3 d = p1.xyz/p1.w - o;\n"
+	"\tfloat t1 = length(d);\n"
+	"\td /= t1;\n"
+	"\t// the footprint of a pixel at distance t is footprint_0 + t*footprint_1\n"
+	"\tfloat footprint_0 = max(length(dFdx(o)), length(dFdy(o)));\n"
+	"\tfloat footprint_1 = max(length(dFdx(d)), length(dFdy(d)));\n"
+	"\tvec3 inv_d = 1.0/mix(d, vec3(1e-20), equal(d, vec3(0.0)));\n"
+	"\tvec3 ta = (box_min - o)*inv_d;\n"
+	"\tvec3 tb = (box_max - o)*inv_d;\n"
+	"\tvec3 t_near = min(ta, tb);\n"
+	"\tvec3 t_far = max(ta, tb);\n"
+	"\tfloat t = max(0.0, max(t_near.x, max(t_near.y, t_near.z)));\n"
+	"\tt1 = min(t1, min(t_far.x, min(t_far.y, t_far.z)));\n"
+	"\tif (t > t1)\n"
+	"\t\tdiscard;\n"
+	"\tbool hit = false;\n"
+	"\tfor (int i = 0; i < max_nr_steps; ++i) {\n"
+	"\t\tfloat f = abs(scene_distance(o + t*d));\n"
+	"\t\tif (f < pixel_tolerance*(footprint_0 + t*footprint_1)) {\n"
+	"\t\t\thit = true;\n"
+	"\t\t\tbreak;\n"
+	"\t\t}\n"
+	"\t\tt += f*step_scale;\n"
+	"\t\tif (t > t1)\n"
+	"\t\t\tbreak;\n"
+	"\t}\n"
+	"\tif (!hit)\n"
+	"\t\tdiscard;\n"
+	"\tvec3 p = o + t*d;\n"
+	"\t// normal from central differences over the pixel footprint\n"
+	"\tvec2 e = vec2(max(footprint_0 + t*footprint_1, 1e-5), 0.0);\n"
+	"\tvec3 n = vec3(scene_distance(p + e.xyy) - scene_distance(p - e.xyy),\n"
+	"\t              scene_distance(p + e.yxy) - scene_distance(p - e.yxy),\n"
+	"\t              scene_distance(p + e.yyx) - scene_distance(p - e.yyx));\n"
+	"\tfloat len = length(n);\n"
+	"\tfloat cos_angle = len > 0.0 ? abs(dot(n, d))/len : 1.0;\n"
+	"\tfrag_color = vec4(surface_color*(0.15 + 0.85*cos_angle) + vec3(0.3*pow(cos_angle, 40.0)), 1.0);\n"
+	"\tvec4 c = mvp*vec4(p, 1.0);\n"
+	"\tgl_FragDepth = 0.5*c.z/c.w + 0.5;\n"
+	"}\n";
+
+/// compute the column major product A*B of 4x4 matrices
+void multiply(const double* A, const double* B, double* C)
+{
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c) {
+			C[4 * c + r] = 0;
+			for (int k = 0; k < 4; ++k)
+				C[4 * c + r] += A[4 * k + r] * B[4 * c + k];
+		}
+}
+
+/// invert the 4x4 matrix M into I by Gauss-Jordan elimination with partial pivoting; returns false for singular matrices
+bool invert(const double* M, double* I)
+{
+	double A[16];
+	for (int i = 0; i < 16; ++i) {
+		A[i] = M[i];
+		I[i] = (i % 5 == 0) ? 1 : 0;
+	}
+	for (int c = 0; c < 4; ++c) {
+		int pivot = c;
+		for (int r = c + 1; r < 4; ++r)
+			if (std::abs(A[4 * c + r]) > std::abs(A[4 * c + pivot]))
+				pivot = r;
+		if (A[4 * c + pivot] == 0)
+			return false;
+		for (int k = 0; k < 4; ++k) {
+			std::swap(A[4 * k + c], A[4 * k + pivot]);
+			std::swap(I[4 * k + c], I[4 * k + pivot]);
+		}
+		double s = 1 / A[4 * c + c];
+		for (int k = 0; k < 4; ++k) {
+			A[4 * k + c] *= s;
+			I[4 * k + c] *= s;
+		}
+		for (int r = 0; r < 4; ++r) {
+			if (r == c)
+				continue;
+			double f = A[4 * c + r];
+			for (int k = 0; k < 4; ++k) {
+				A[4 * k + r] -= f*A[4 * k + c];
+				I[4 * k + r] -= f*I[4 * k + c];
+			}
+		}
+	}
+	return true;
+}
+
+/// convert a column major matrix to float
+void to_float(const double* M, float* F)
+{
+	for (int i = 0; i < 16; ++i)
+		F[i] = float(M[i]);
+}
+
+}
+
+/// construct without function
+gl_ray_marcher::gl_ray_marcher() : max_nr_steps(256), pixel_tolerance(0.5f), step_scale(1)
+{
+	program = vertex_shader = fragment_shader = vertex_array = 0;
+	program_outofdate = false;
+	inverse_mvp_location = mvp_location = box_min_location = box_max_location = step_scale_location =
+		max_nr_steps_location = pixel_tolerance_location = color_location = -1;
+}
+
+/// set the distance function returning result that has been generated into g
+void gl_ray_marcher::set_function(const glsl_generator& g, const std::string& result)
+{
+	function_source = g.get_source(result);
+	bindings = g.get_uniforms();
+	program_outofdate = true;
+}
+
+/// remove the function, which has to be done before the bound members are destructed
+void gl_ray_marcher::clear_function()
+{
+	function_source.clear();
+	bindings.clear();
+	program_outofdate = true;
+}
+
+/// set the Lipschitz bound of the function
+void gl_ray_marcher::set_lipschitz_bound(double bound)
+{
+	step_scale = bound > 0 ? float(1 / bound) : 1.0f;
+}
+
+/// return the fragment shader for the current function
+std::string gl_ray_marcher::get_fragment_source() const
+{
+	return std::string(fragment_header) + function_source + fragment_main;
+}
+
+/// compile source into shader and append errors to the log; returns false on failure
+bool gl_ray_marcher::compile_shader(unsigned type, const std::string& source, unsigned& shader)
+{
+	shader = glCreateShader(type);
+	const char* code = source.c_str();
+	glShaderSource(shader, 1, &code, 0);
+	glCompileShader(shader);
+	GLint status;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status == GL_TRUE)
+		return true;
+	GLint length = 0;
+	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+	std::string info(std::max(length, 1), '\0');
+	glGetShaderInfoLog(shader, GLsizei(info.size()), 0, &info[0]);
+	log += info.c_str();
+	return false;
+}
+
+/// build the program from the current function; returns false on failure
+bool gl_ray_marcher::build_program()
+{
+	log.clear();
+	if (!compile_shader(GL_VERTEX_SHADER, vertex_source, vertex_shader) ||
+		!compile_shader(GL_FRAGMENT_SHADER, get_fragment_source(), fragment_shader))
+		return false;
+	program = glCreateProgram();
+	glAttachShader(program, vertex_shader);
+	glAttachShader(program, fragment_shader);
+	glLinkProgram(program);
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		GLint length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::string info(std::max(length, 1), '\0');
+		glGetProgramInfoLog(program, GLsizei(info.size()), 0, &info[0]);
+		log += info.c_str();
+		return false;
+	}
+	inverse_mvp_location = glGetUniformLocation(program, "inverse_mvp");
+	mvp_location = glGetUniformLocation(program, "mvp");
+	box_min_location = glGetUniformLocation(program, "box_min");
+	box_max_location = glGetUniformLocation(program, "box_max");
+	step_scale_location = glGetUniformLocation(program, "step_scale");
+	max_nr_steps_location = glGetUniformLocation(program, "max_nr_steps");
+	pixel_tolerance_location = glGetUniformLocation(program, "pixel_tolerance");
+	color_location = glGetUniformLocation(program, "surface_color");
+	// uniforms that do not influence the result are optimized away and get location -1, which glUniform ignores
+	binding_locations.resize(bindings.size());
+	for (size_t i = 0; i < bindings.size(); ++i)
+		binding_locations[i] = glGetUniformLocation(program, bindings[i].name.c_str());
+	return true;
+}
+
+/// delete program and shaders
+void gl_ray_marcher::destruct_program()
+{
+	if (program != 0)
+		glDeleteProgram(program);
+	if (vertex_shader != 0)
+		glDeleteShader(vertex_shader);
+	if (fragment_shader != 0)
+		glDeleteShader(fragment_shader);
+	program = vertex_shader = fragment_shader = 0;
+}
+
+/// draw for the column major modelview and projection matrices, where rays are clipped to the box from box_min to box_max; returns false if no function is set or the program could not be built
+bool gl_ray_marcher::draw(const double* modelview, const double* projection, const double* box_min, const double* box_max, const float* color)
+{
+	if (!has_function())
+		return false;
+	if (program_outofdate) {
+		destruct_program();
+		program_outofdate = false;
+		if (!build_program())
+			destruct_program();
+	}
+	if (program == 0)
+		return false;
+	double mvp[16], inverse_mvp[16];
+	multiply(projection, modelview, mvp);
+	if (!invert(mvp, inverse_mvp))
+		return false;
+	if (vertex_array == 0)
+		glGenVertexArrays(1, &vertex_array);
+	glUseProgram(program);
+	float F[16];
+	to_float(mvp, F);
+	glUniformMatrix4fv(mvp_location, 1, GL_FALSE, F);
+	to_float(inverse_mvp, F);
+	glUniformMatrix4fv(inverse_mvp_location, 1, GL_FALSE, F);
+	glUniform3f(box_min_location, float(box_min[0]), float(box_min[1]), float(box_min[2]));
+	glUniform3f(box_max_location, float(box_max[0]), float(box_max[1]), float(box_max[2]));
+	glUniform1f(step_scale_location, step_scale);
+	glUniform1i(max_nr_steps_location, GLint(max_nr_steps));
+	glUniform1f(pixel_tolerance_location, pixel_tolerance);
+	glUniform3fv(color_location, 1, color);
+	// parameters are read from the bound members in every frame
+	for (size_t i = 0; i < bindings.size(); ++i) {
+		const double* v = bindings[i].values;
+		if (bindings[i].nr_components == 1)
+			glUniform1f(binding_locations[i], float(v[0]));
+		else
+			glUniform3f(binding_locations[i], float(v[0]), float(v[1]), float(v[2]));
+	}
+	glBindVertexArray(vertex_array);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glUseProgram(0);
+	return true;
+}
+
+/// delete all OpenGL objects
+void gl_ray_marcher::destruct()
+{
+	destruct_program();
+	if (vertex_array != 0)
+		glDeleteVertexArrays(1, &vertex_array);
+	vertex_array = 0;
+	// the program is rebuilt in the next draw call
+	program_outofdate = has_function();
+}
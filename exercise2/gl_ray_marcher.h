@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "glsl_generator.h"
+
+/** previews an implicit function on the GPU by sphere tracing a generated GLSL distance
+    function in a full-screen pass. The function is set as source from a glsl_generator
+    together with the bindings of its uniforms, and the program is rebuilt lazily in the
+    next draw call. Every draw call reads the current values of the bound members into
+    the uniforms, such that parameter changes show up without regeneration. Rays are
+    clipped to a box and advance by |f|/L with the Lipschitz bound L, a ray hits once |f|
+    falls below a fraction of the pixel footprint. The hit point is shaded with a
+    headlight and written to the depth buffer. Only core OpenGL 3.3 is used, such that the
+    renderer also runs on software implementations like Mesa llvmpipe. All methods
+    except set_function, clear_function and set_lipschitz_bound need a current context. */
+class gl_ray_marcher
+{
+public:
+	/// maximum number of steps per ray
+	unsigned max_nr_steps;
+	/// fraction of the pixel footprint below which a ray counts as hit
+	float pixel_tolerance;
+protected:
+	/// generated distance function
+	std::string function_source;
+	/// uniforms of the distance function
+	std::vector<glsl_generator::uniform_binding> bindings;
+	/// locations of the uniforms of the distance function
+	std::vector<int> binding_locations;
+	/// reciprocal of the Lipschitz bound
+	float step_scale;
+	/// program, shaders and empty vertex array of the full-screen triangle
+	unsigned program, vertex_shader, fragment_shader, vertex_array;
+	/// set when the function changed
+	bool program_outofdate;
+	/// compiler or linker log of the last failed build
+	std::string log;
+	/// locations of the uniforms of the ray marcher
+	int inverse_mvp_location, mvp_location, box_min_location, box_max_location, step_scale_location,
+		max_nr_steps_location, pixel_tolerance_location, color_location;
+	/// compile source into shader and append errors to the log; returns false on failure
+	bool compile_shader(unsigned type, const std::string& source, unsigned& shader);
+	/// build the program from the current function; returns false on failure
+	bool build_program();
+	/// delete program and shaders
+	void destruct_program();
+public:
+	/// construct without function
+	gl_ray_marcher();
+	/// set the distance function returning result that has been generated into g
+	void set_function(const glsl_generator& g, const std::string& result);
+	/// remove the function, which has to be done before the bound members are destructed
+	void clear_function();
+	/// return whether a function is set
+	bool has_function() const { return !function_source.empty(); }
+	/// set the Lipschitz bound of the function
+	void set_lipschitz_bound(double bound);
+	/// return the log of the last failed build
+	const std::string& get_log() const { return log; }
+	/// return the fragment shader for the current function
+	std::string get_fragment_source() const;
+	/// draw for the column major modelview and projection matrices, where rays are clipped to the box from box_min to box_max; returns false if no function is set or the program could not be built
+	bool draw(const double* modelview, const double* projection, const double* box_min, const double* box_max, const float* color);
+	/// delete all OpenGL objects
+	void destruct();
+};
@@ -0,0 +1,75 @@
+#include "glsl_generator.h"
+#include <sstream>
+#include <cmath>
+#include <limits>
+
+/// construct empty
+glsl_generator::glsl_generator()
+{
+}
+
+/// remove all statements and uniforms
+void glsl_generator::clear()
+{
+	statements.clear();
+	uniforms.clear();
+}
+
+/// return a float literal of value, where infinite values are replaced by the largest float
+std::string glsl_generator::literal(double value)
+{
+	if (std::isinf(value))
+		return value > 0 ? "3.4e38" : "-3.4e38";
+	std::ostringstream os;
+	os.precision(9);
+	os << value;
+	// integral values need a decimal point to be float literals
+	std::string s = os.str();
+	if (s.find_first_of(".e") == std::string::npos)
+		s += ".0";
+	return s;
+}
+
+/// bind a uniform with the given number of components to values and return its name
+std::string glsl_generator::add_uniform(const double* values, unsigned nr_components)
+{
+	uniform_binding u;
+	u.name = "u" + std::to_string(uniforms.size());
+	u.values = values;
+	u.nr_components = nr_components;
+	uniforms.push_back(u);
+	return u.name;
+}
+
+/// append a statement that assigns expression to a fresh variable of the given type and return the name of the variable
+std::string glsl_generator::add_variable(const std::string& type, const std::string& expression)
+{
+	statement s;
+	s.type = type;
+	s.name = "v" + std::to_string(statements.size());
+	s.expression = expression;
+	statements.push_back(s);
+	return s.name;
+}
+
+/// return the uniform declarations, the helper functions and the distance function that returns the expression result
+std::string glsl_generator::get_source(const std::string& result) const
+{
+	std::ostringstream os;
+	for (const uniform_binding& u : uniforms)
+		os << "uniform " << (u.nr_components == 1 ? "float " : "vec3 ") << u.name << ";\n";
+	// same rotation as rotation::rotate, which does not normalize the axis
+	os << "vec3 rotate_around_axis(vec3 p, vec3 axis, float angle)\n"
+	   << "{\n"
+	   << "\tvec3 a = dot(p, axis)*axis;\n"
+	   << "\tvec3 x = p - a;\n"
+	   << "\treturn a + cos(angle)*x + sin(angle)*cross(axis, x);\n"
+	   << "}\n"
+	   << "float scene_distance(vec3 " << get_point_name() << ")\n"
+	   << "{\n";
+	for (const statement& s : statements)
+		os << "\t" << s.type << " " << s.name << " = " << s.expression << ";\n";
+	os << "\treturn " << result << ";\n"
+	   << "}\n";
+	return os.str();
+}
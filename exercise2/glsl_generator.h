@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/** collects the GLSL translation of an implicit scene tree into a single distance function
+    float scene_distance(vec3 p). Nodes append statements that assign intermediate results
+    to fresh variables and return the GLSL expression of their value. Parameters are not
+    written as literals but as uniforms bound to the double members of the nodes, such that
+    parameter changes only need new uniform values and no regeneration of the code as long
+    as the structure of the tree stays the same. The collected statements and uniforms are
+    also emitted as C++ by native_scene. */
+class glsl_generator
+{
+public:
+	/// uniform of type float or vec3 together with the members it is bound to
+	struct uniform_binding
+	{
+		/// name in the generated code
+		std::string name;
+		/// first bound value, vec3 uniforms are bound to three consecutive values
+		const double* values;
+		/// 1 for float and 3 for vec3 uniforms
+		unsigned nr_components;
+	};
+	/// assignment of an expression to a fresh variable
+	struct statement
+	{
+		/// GLSL type of the variable, float or vec3
+		std::string type;
+		/// name of the variable
+		std::string name;
+		/// assigned expression
+		std::string expression;
+	};
+protected:
+	/// statements of the distance function
+	std::vector<statement> statements;
+	/// uniforms in the order of their declaration
+	std::vector<uniform_binding> uniforms;
+	/// bind a uniform with the given number of components to values and return its name
+	std::string add_uniform(const double* values, unsigned nr_components);
+public:
+	/// construct empty
+	glsl_generator();
+	/// remove all statements and uniforms
+	void clear();
+	/// return the name of the query point of the distance function
+	static std::string get_point_name() { return "p"; }
+	/// return a float literal of value, where infinite values are replaced by the largest float
+	static std::string literal(double value);
+	/// bind a float uniform to value and return its name
+	std::string add_uniform(const double& value) { return add_uniform(&value, 1); }
+	/// bind a vec3 uniform to the three consecutive values starting at values and return its name
+	std::string add_uniform3(const double* values) { return add_uniform(values, 3); }
+	/// append a statement that assigns expression to a fresh variable of the given type and return the name of the variable
+	std::string add_variable(const std::string& type, const std::string& expression);
+	/// return the uniforms in the order of their declaration
+	const std::vector<uniform_binding>& get_uniforms() const { return uniforms; }
+	/// return the statements in the order of their execution
+	const std::vector<statement>& get_statements() const { return statements; }
+	/// return the uniform declarations, the helper functions and the distance function that returns the expression result
+	std::string get_source(const std::string& result) const;
+};
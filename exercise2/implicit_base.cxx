@@ -1,4 +1,5 @@
 #include "implicit_base.h"
+#include "parallel_for.h"
 
 /// set new scene update handler
 template <typename T>
@@ -65,4 +66,46 @@ typename implicit_base<T>::clr_type implicit_base<T>::evaluate_color(const pnt_t
 	return color;
 }
 
+/// default fused evaluation for primitives whose color does not depend on the location
+template <typename T>
+typename implicit_base<T>::crd_type implicit_base<T>::evaluate_and_color(const pnt_type& p, clr_type& clr) const
+{
+	clr = evaluate_color(p);
+	return evaluate(p);
+}
+
+/// interface for evaluation of a batch of points with a default implementation that distributes the points over all hardware threads
+template <typename T>
+void implicit_base<T>::evaluate_batch(const std::vector<pnt_type>& ps, std::vector<crd_type>& vs) const
+{
+	const int block_size = 256;
+	vs.resize(ps.size());
+	parallel_for(0, int((ps.size() + block_size - 1) / block_size), [&](int b) {
+		size_t end = std::min(ps.size(), size_t(b + 1)*block_size);
+		for (size_t i = size_t(b)*block_size; i < end; ++i)
+			vs[i] = evaluate(ps[i]);
+	});
+}
+
+/// default Lipschitz bound of distance functions
+template <typename T>
+typename implicit_base<T>::crd_type implicit_base<T>::get_lipschitz_bound() const
+{
+	return 1;
+}
+
+/// default mapping to the children for nodes that evaluate their children at the same point
+template <typename T>
+bool implicit_base<T>::map_to_children(pnt_type& p) const
+{
+	return true;
+}
+
+/// nodes without GLSL translation disable the generated code of the whole tree
+template <typename T>
+std::string implicit_base<T>::generate_glsl(glsl_generator& g, const std::string& p) const
+{
+	return std::string();
+}
+
 template class implicit_base<double>;
\ No newline at end of file
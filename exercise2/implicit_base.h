@@ -5,6 +5,7 @@
 #include <cgv/gui/provider.h>
 #include <cgv/render/drawable.h>
 #include <cgv/render/render_types.h>
+#include "glsl_generator.h"
 
 using namespace cgv::base;
 using namespace cgv::math;
@@ -20,6 +21,8 @@ struct scene_update_handler
 {
 	virtual void update_scene() = 0;
 	virtual void update_description() = 0;
+	/// return the copy of node in a copy of the scene tree that shares no state with the tree, or an empty pointer if no copy can be made now
+	virtual base_ptr copy_detached(const base_ptr& node) { return base_ptr(); }
 };
 
 
@@ -67,6 +70,16 @@ public:
 	virtual vec_type evaluate_gradient(const pnt_type& p) const;
 	/// interface for the evaluation of surface color
 	virtual clr_type evaluate_color(const pnt_type& p) const;
+	/// interface for fused evaluation of function value and surface color in a single traversal
+	virtual crd_type evaluate_and_color(const pnt_type& p, clr_type& clr) const;
+	/// interface for evaluation of a batch of points with a default implementation that distributes the points over all hardware threads
+	virtual void evaluate_batch(const std::vector<pnt_type>& ps, std::vector<crd_type>& vs) const;
+	/// return an upper bound on the gradient length, which allows safe steps of |f(p)|/bound along rays; defaults to 1 for distance functions
+	virtual crd_type get_lipschitz_bound() const;
+	/// map p into the coordinates in which the children are evaluated and return false if they are evaluated at several points per p; defaults to the identity
+	virtual bool map_to_children(pnt_type& p) const;
+	/// append the GLSL translation of the function at the point expression p to g and return the expression of its value; the default returns an empty string for nodes without translation
+	virtual std::string generate_glsl(glsl_generator& g, const std::string& p) const;
 };
 
 
@@ -1,6 +1,12 @@
 #include "implicit_group.h"
 #include "implicit_primitive.h"
 
+/// construct with composed child colors
+template <typename T>
+implicit_group<T>::implicit_group() : color_mode(GCM_COMPOSE)
+{
+}
+
 /// passes on the update handler to the children
 template <typename T>
 void implicit_group<T>::set_update_handler(scene_update_handler* uh)
@@ -104,6 +110,34 @@ typename implicit_group<T>::clr_type implicit_group<T>::evaluate_color(const pnt
 	}
 }
 
+/// resolve the group color in fused evaluation from the color of the child that decided the function value
+template <typename T>
+typename implicit_group<T>::clr_type implicit_group<T>::select_color(unsigned selected_i, const clr_type& selected_clr, const pnt_type& p) const
+{
+	switch (color_mode) {
+	case GCM_REPLACE: return implicit_base<T>::color;
+	case GCM_COMPOSE: return selected_clr;
+	default: {
+		unsigned i = color_mode - GCM_CHILD_0;
+		if (i == selected_i)
+			return selected_clr;
+		if (i >= get_nr_children())
+			return implicit_base<T>::color;
+		return get_implicit_child(i)->evaluate_color(p);
+	}
+	}
+}
+
+/// min, max and selection of children do not increase the Lipschitz bound beyond the maximum of the children
+template <typename T>
+T implicit_group<T>::get_lipschitz_bound() const
+{
+	T bound = 0;
+	for (unsigned int i = 0; i < group::get_nr_children(); ++i)
+		bound = std::max(bound, get_implicit_child(i)->get_lipschitz_bound());
+	return group::get_nr_children() == 0 ? T(1) : bound;
+}
+
 template <typename T>
 void implicit_group<T>::create_gui()
 {
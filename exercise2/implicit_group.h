@@ -5,10 +5,14 @@
 
 using namespace cgv::base;
 
+/// ways in which groups determine the surface color from their own and their children's colors
 enum GroupColorMode
 {
+	/// the color of the group
 	GCM_REPLACE,
+	/// the color composed by compose_color, which averages the children unless overloaded; the CSG nodes take the color of the child that decides the function value
 	GCM_COMPOSE,
+	/// the color of the child with the given index
 	GCM_CHILD_0,
 	GCM_CHILD_1,
 	GCM_CHILD_2
@@ -31,9 +35,13 @@ protected:
 	std::vector<int> child_visible_in_gui;
 	/// the way the color is computed
 	GroupColorMode color_mode;
-	/// overload to compose the colors of the function children
+	/// overload to compose the colors of the function children; the default averages them
 	virtual clr_type compose_color(const pnt_type& p) const;
+	/// resolve the group color in fused evaluation from the color of the child that decided the function value
+	clr_type select_color(unsigned selected_i, const clr_type& selected_clr, const pnt_type& p) const;
 public:
+	/// construct with composed child colors
+	implicit_group();
 	/// convert to cgv::base::base pointer
 	cgv::base::base* get_base() { return this; }
 	/// reflect members to expose them to serialization
@@ -44,6 +52,8 @@ public:
 	unsigned int append_child(base_ptr child);
 	/// returns "implicit_group"
 	std::string get_type_name() const;
+	/// return the maximum Lipschitz bound of the children
+	T get_lipschitz_bound() const;
 	/// evaluation of surface color based on color_mode
 	clr_type evaluate_color(const pnt_type& p) const;
 	/// passes on init to the children
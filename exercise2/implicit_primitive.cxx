@@ -2,6 +2,19 @@
 #include <cgv_reflect_types/media/color.h>
 
 
+/// construct with the Lipschitz bound of a distance function
+template <typename T>
+implicit_primitive<T>::implicit_primitive() : lipschitz_bound(1)
+{
+}
+
+/// return the Lipschitz bound set by the user
+template <typename T>
+T implicit_primitive<T>::get_lipschitz_bound() const
+{
+	return lipschitz_bound;
+}
+
 template <typename T>
 void implicit_primitive<T>::on_set(void* member_ptr)
 {
@@ -17,7 +30,8 @@ bool implicit_primitive<T>::self_reflect(cgv::reflect::reflection_handler& rh)
 		rh.reflect_member("cr", implicit_base<T>::color[0]) &&
 		rh.reflect_member("cg", implicit_base<T>::color[1]) &&
 		rh.reflect_member("cb", implicit_base<T>::color[2]) &&
-		rh.reflect_member("ca", implicit_base<T>::color[3]);
+		rh.reflect_member("ca", implicit_base<T>::color[3]) &&
+		rh.reflect_member("lipschitz", lipschitz_bound);
 }
 
 template <typename T>
@@ -29,6 +43,7 @@ std::string implicit_primitive<T>::get_type_name() const
 template <typename T>
 void implicit_primitive<T>::create_gui()
 {
+	provider::add_member_control(this, "lipschitz", lipschitz_bound, "value_slider", "min=0.01;max=100;log=true;ticks=true");
 }
 
 template class implicit_primitive<double>;
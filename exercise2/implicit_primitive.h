@@ -9,9 +9,16 @@ using namespace cgv::base;
 template <typename T>
 class implicit_primitive : public named, public implicit_base<T>
 {
+protected:
+	/// upper bound on the gradient length of the primitive
+	T lipschitz_bound;
 public:
+	/// construct with the Lipschitz bound of a distance function
+	implicit_primitive();
 	/// convert to cgv::base::base pointer
 	cgv::base::base* get_base() { return this; }
+	/// return the Lipschitz bound set by the user
+	T get_lipschitz_bound() const;
 	/// calls the update_scene method of scene_updater
 	void on_set(void* member_ptr);
 	/// reflect members to expose them to serialization
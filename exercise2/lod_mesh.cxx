@@ -0,0 +1,215 @@
+#include "lod_mesh.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+
+namespace {
+
+/// return a key of the undirected edge (a,b)
+uint64_t edge_key(uint32_t a, uint32_t b)
+{
+	return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+}
+
+}
+
+/// construct empty
+lod_mesh::lod_mesh() : brick_cells(0)
+{
+	nr_bricks[0] = nr_bricks[1] = nr_bricks[2] = 0;
+	brick_extent[0] = brick_extent[1] = brick_extent[2] = 0;
+}
+
+/// remove all levels
+void lod_mesh::clear()
+{
+	levels.clear();
+	nr_bricks[0] = nr_bricks[1] = nr_bricks[2] = 0;
+}
+
+/// return the brick containing point p
+unsigned lod_mesh::find_brick(const vtx_type& p) const
+{
+	unsigned b[3];
+	for (int c = 0; c < 3; ++c) {
+		int i = int(floor((p(c) - box.get_min_pnt()(c)) / brick_extent[c]));
+		b[c] = unsigned(std::max(0, std::min(int(nr_bricks[c]) - 1, i)));
+	}
+	return (b[2] * nr_bricks[1] + b[1])*nr_bricks[0] + b[0];
+}
+
+/// return the bounding box of brick bi
+lod_mesh::box_type lod_mesh::get_brick_box(size_t bi) const
+{
+	size_t b[3] = { bi % nr_bricks[0], (bi / nr_bricks[0]) % nr_bricks[1], bi / (size_t(nr_bricks[0])*nr_bricks[1]) };
+	surface_extractor::pnt_type p0, p1;
+	for (int c = 0; c < 3; ++c) {
+		p0(c) = box.get_min_pnt()(c) + b[c] * brick_extent[c];
+		p1(c) = std::min(box.get_max_pnt()(c), p0(c) + brick_extent[c]);
+	}
+	return box_type(p0, p1);
+}
+
+/// sort the triangles of mesh into bricks and add skirts of the given length into l
+void lod_mesh::build_level(const extracted_mesh& mesh, double skirt_length, level& l) const
+{
+	size_t nr_triangles = mesh.get_nr_triangles();
+	l.positions = mesh.positions;
+	l.normals = mesh.normals;
+	// meshes with face normals are shaded with area weighted vertex normals
+	if (l.normals.size() != l.positions.size()) {
+		l.normals.assign(l.positions.size(), vtx_type(0, 0, 0));
+		for (size_t t = 0; t < nr_triangles; ++t) {
+			vtx_type n = mesh.compute_face_normal(t);
+			for (int c = 0; c < 3; ++c)
+				l.normals[mesh.triangles[3 * t + c]] += n;
+		}
+		for (vtx_type& n : l.normals) {
+			float len = n.length();
+			if (len > 0)
+				n /= len;
+		}
+	}
+	// sort triangles by the bricks of their centroids with a counting sort
+	size_t n = get_nr_bricks();
+	std::vector<uint32_t> triangle_brick(nr_triangles);
+	std::vector<uint32_t> brick_offset(n + 1, 0);
+	for (size_t t = 0; t < nr_triangles; ++t) {
+		const uint32_t* tri = &mesh.triangles[3 * t];
+		triangle_brick[t] = find_brick((mesh.positions[tri[0]] + mesh.positions[tri[1]] + mesh.positions[tri[2]]) / 3.0f);
+		++brick_offset[triangle_brick[t] + 1];
+	}
+	for (size_t bi = 0; bi < n; ++bi)
+		brick_offset[bi + 1] += brick_offset[bi];
+	std::vector<uint32_t> order(nr_triangles);
+	{
+		std::vector<uint32_t> next(brick_offset.begin(), brick_offset.end() - 1);
+		for (size_t t = 0; t < nr_triangles; ++t)
+			order[next[triangle_brick[t]]++] = uint32_t(t);
+	}
+	// count the triangles incident to each edge to distinguish brick borders from mesh borders
+	std::unordered_map<uint64_t, uint32_t> edge_count;
+	if (skirt_length > 0) {
+		edge_count.reserve(3 * nr_triangles / 2);
+		for (size_t t = 0; t < nr_triangles; ++t)
+			for (int c = 0; c < 3; ++c)
+				++edge_count[edge_key(mesh.triangles[3 * t + c], mesh.triangles[3 * t + (c + 1) % 3])];
+	}
+	l.triangles.clear();
+	l.triangles.reserve(mesh.triangles.size());
+	l.brick_begin.resize(n + 1);
+	std::unordered_map<uint64_t, uint32_t> brick_edge_count;
+	std::unordered_map<uint32_t, uint32_t> skirt_vertex;
+	for (size_t bi = 0; bi < n; ++bi) {
+		l.brick_begin[bi] = uint32_t(l.triangles.size());
+		for (uint32_t oi = brick_offset[bi]; oi < brick_offset[bi + 1]; ++oi)
+			l.triangles.insert(l.triangles.end(), &mesh.triangles[3 * order[oi]], &mesh.triangles[3 * order[oi]] + 3);
+		if (skirt_length <= 0)
+			continue;
+		brick_edge_count.clear();
+		skirt_vertex.clear();
+		for (uint32_t oi = brick_offset[bi]; oi < brick_offset[bi + 1]; ++oi)
+			for (int c = 0; c < 3; ++c)
+				++brick_edge_count[edge_key(mesh.triangles[3 * order[oi] + c], mesh.triangles[3 * order[oi] + (c + 1) % 3])];
+		// edges with a single triangle in the brick but two in the mesh lie on the brick border
+		for (uint32_t oi = brick_offset[bi]; oi < brick_offset[bi + 1]; ++oi) {
+			const uint32_t* tri = &mesh.triangles[3 * order[oi]];
+			for (int c = 0; c < 3; ++c) {
+				uint32_t vi[2] = { tri[c], tri[(c + 1) % 3] };
+				uint64_t key = edge_key(vi[0], vi[1]);
+				if (brick_edge_count[key] != 1 || edge_count[key] < 2)
+					continue;
+				// move border vertices against their normals to hang the skirt below the surface
+				uint32_t si[2];
+				for (int k = 0; k < 2; ++k) {
+					auto it = skirt_vertex.find(vi[k]);
+					if (it != skirt_vertex.end()) {
+						si[k] = it->second;
+						continue;
+					}
+					si[k] = uint32_t(l.positions.size());
+					skirt_vertex[vi[k]] = si[k];
+					vtx_type p = l.positions[vi[k]], nml = l.normals[vi[k]];
+					l.positions.push_back(p - nml*float(skirt_length));
+					l.normals.push_back(nml);
+				}
+				// orient the skirt away from the brick
+				uint32_t skirt[6] = { vi[1], vi[0], si[0], vi[1], si[0], si[1] };
+				l.triangles.insert(l.triangles.end(), skirt, skirt + 6);
+			}
+		}
+	}
+	l.brick_begin[n] = uint32_t(l.triangles.size());
+	l.nr_surface_triangles = nr_triangles;
+}
+
+/// build the levels from meshes ordered from fine to coarse, where res is the resolution of the finest mesh; skirts are omitted for a zero skirt_factor, otherwise they reach skirt_factor cells of their level into the surface
+void lod_mesh::build(const box_type& _box, unsigned res, unsigned _brick_cells, const std::vector<extracted_mesh>& meshes, double skirt_factor)
+{
+	box = _box;
+	brick_cells = std::max(1u, _brick_cells);
+	double cell_size = 0;
+	for (int c = 0; c < 3; ++c) {
+		double cell_extent = box.get_extent()(c) / (res - 1);
+		nr_bricks[c] = std::max(1u, (res - 2) / brick_cells + 1);
+		brick_extent[c] = brick_cells*cell_extent;
+		cell_size = std::max(cell_size, cell_extent);
+	}
+	levels.resize(meshes.size());
+	for (size_t li = 0; li < meshes.size(); ++li)
+		build_level(meshes[li], skirt_factor*cell_size*(1 << li), levels[li]);
+}
+
+/** select per brick the coarsest level whose cells project to at most pixels_per_cell
+    pixels for the column major modelview and projection matrices and a viewport of the
+    given height. Bricks outside of the view frustum get level -1. */
+void lod_mesh::select_levels(const double* modelview, const double* projection, unsigned viewport_height, double pixels_per_cell, std::vector<int>& brick_levels) const
+{
+	size_t n = get_nr_bricks();
+	brick_levels.assign(n, 0);
+	if (levels.empty())
+		return;
+	// frustum planes from the rows of projection*modelview
+	double M[16], planes[6][4];
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			M[4 * c + r] = projection[r] * modelview[4 * c] + projection[4 + r] * modelview[4 * c + 1] +
+			               projection[8 + r] * modelview[4 * c + 2] + projection[12 + r] * modelview[4 * c + 3];
+	for (int i = 0; i < 6; ++i) {
+		double s = (i & 1) ? -1 : 1, len = 0;
+		for (int c = 0; c < 4; ++c) {
+			planes[i][c] = M[4 * c + 3] + s*M[4 * c + i / 2];
+			if (c < 3)
+				len += planes[i][c] * planes[i][c];
+		}
+		len = sqrt(len);
+		for (int c = 0; c < 4; ++c)
+			planes[i][c] /= len;
+	}
+	double scale = sqrt(modelview[0] * modelview[0] + modelview[1] * modelview[1] + modelview[2] * modelview[2]);
+	bool perspective = projection[15] == 0;
+	double pixel_scale = 0.5*projection[5] * viewport_height;
+	double cell_size = std::max(brick_extent[0], std::max(brick_extent[1], brick_extent[2])) / brick_cells;
+	for (size_t bi = 0; bi < n; ++bi) {
+		box_type bb = get_brick_box(bi);
+		surface_extractor::pnt_type center = bb.get_center();
+		double radius = 0.5*bb.get_extent().length();
+		bool visible = true;
+		for (int i = 0; i < 6 && visible; ++i)
+			visible = planes[i][0] * center(0) + planes[i][1] * center(1) + planes[i][2] * center(2) + planes[i][3] >= -radius;
+		if (!visible) {
+			brick_levels[bi] = -1;
+			continue;
+		}
+		// projected size of a cell of the finest level
+		double pixels = pixel_scale*scale*cell_size;
+		if (perspective) {
+			double depth = -(modelview[2] * center(0) + modelview[6] * center(1) + modelview[10] * center(2) + modelview[14]);
+			if (depth <= scale*radius)
+				continue;
+			pixels /= depth - scale*radius;
+		}
+		int li = pixels > 0 ? int(floor(log2(pixels_per_cell / pixels))) : 0;
+		brick_levels[bi] = std::max(0, std::min(int(levels.size()) - 1, li));
+	}
+}
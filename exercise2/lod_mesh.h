@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "surface_extractor.h"
+
+/** multi resolution representation of an extracted surface for view dependent rendering.
+    The levels are meshes of the same surface with decreasing resolution, such as
+    extractions at res, res/2 and res/4 or simplified versions of the full mesh. The box is
+    split into bricks of brick_cells^3 cells of the finest grid and the triangles of each
+    level are sorted by the brick that contains their centroid, such that every brick can be
+    drawn at its own level. Neighboring bricks of different levels do not share their
+    border vertices, therefore each brick carries a skirt of triangles that hangs from its
+    border edges into the surface and covers the resulting cracks. */
+class lod_mesh
+{
+public:
+	/// vertex type
+	typedef extracted_mesh::vtx_type vtx_type;
+	/// type of the sampling box
+	typedef surface_extractor::box_type box_type;
+	/// vertices and brick sorted triangles of one level
+	struct level
+	{
+		/// vertex locations including the skirt vertices
+		std::vector<vtx_type> positions;
+		/// per vertex normals
+		std::vector<vtx_type> normals;
+		/// triangles sorted by brick, the triangles of each brick are followed by its skirt
+		std::vector<uint32_t> triangles;
+		/// per brick the offset of its first triangle index, followed by the total number of indices
+		std::vector<uint32_t> brick_begin;
+		/// number of triangles without skirts
+		size_t nr_surface_triangles;
+	};
+protected:
+	/// levels from fine to coarse
+	std::vector<level> levels;
+	/// box covered by the bricks
+	box_type box;
+	/// number of bricks along each axis
+	unsigned nr_bricks[3];
+	/// extent of a brick
+	double brick_extent[3];
+	/// number of cells of the finest grid along each brick edge
+	unsigned brick_cells;
+	/// return the brick containing point p
+	unsigned find_brick(const vtx_type& p) const;
+	/// sort the triangles of mesh into bricks and add skirts of the given length into l
+	void build_level(const extracted_mesh& mesh, double skirt_length, level& l) const;
+public:
+	/// construct empty
+	lod_mesh();
+	/// remove all levels
+	void clear();
+	/// build the levels from meshes ordered from fine to coarse, where res is the resolution of the finest mesh; skirts are omitted for a zero skirt_factor, otherwise they reach skirt_factor cells of their level into the surface
+	void build(const box_type& _box, unsigned res, unsigned _brick_cells, const std::vector<extracted_mesh>& meshes, double skirt_factor = 1);
+	/// return the number of levels
+	size_t get_nr_levels() const { return levels.size(); }
+	/// return level li
+	const level& get_level(size_t li) const { return levels[li]; }
+	/// return the number of bricks
+	size_t get_nr_bricks() const { return size_t(nr_bricks[0])*nr_bricks[1] * nr_bricks[2]; }
+	/// return the bounding box of brick bi
+	box_type get_brick_box(size_t bi) const;
+	/** select per brick the coarsest level whose cells project to at most pixels_per_cell
+	    pixels for the column major modelview and projection matrices and a viewport of the
+	    given height. Bricks outside of the view frustum get level -1. */
+	void select_levels(const double* modelview, const double* projection, unsigned viewport_height, double pixels_per_cell, std::vector<int>& brick_levels) const;
+};
@@ -0,0 +1,90 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// construct closed mapping
+mapped_file::mapped_file() : data(0), size(0)
+{
+#ifdef _WIN32
+	file_handle = 0;
+	mapping_handle = 0;
+#endif
+}
+
+/// close mapping on destruction
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+/// map the given file and return whether this succeeded
+bool mapped_file::open(const std::string& file_name)
+{
+	close();
+#ifdef _WIN32
+	HANDLE fh = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (fh == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(fh, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(fh);
+		return false;
+	}
+	HANDLE mh = CreateFileMappingA(fh, 0, PAGE_READONLY, 0, 0, 0);
+	if (!mh) {
+		CloseHandle(fh);
+		return false;
+	}
+	const void* ptr = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+	if (!ptr) {
+		CloseHandle(mh);
+		CloseHandle(fh);
+		return false;
+	}
+	file_handle = fh;
+	mapping_handle = mh;
+	size = size_t(file_size.QuadPart);
+#else
+	int fd = ::open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void* ptr = mmap(0, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping stays valid after closing the descriptor
+	::close(fd);
+	if (ptr == MAP_FAILED)
+		return false;
+	size = size_t(st.st_size);
+#endif
+	data = static_cast<const unsigned char*>(ptr);
+	return true;
+}
+
+/// unmap the file
+void mapped_file::close()
+{
+	if (!data)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+	mapping_handle = 0;
+	file_handle = 0;
+#else
+	munmap(const_cast<unsigned char*>(data), size);
+#endif
+	data = 0;
+	size = 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/** read only memory mapping of a complete file. Pages are loaded by the operating
+    system on first access, such that opening even very large files is instant. */
+class mapped_file
+{
+protected:
+	/// pointer to the mapped file content or 0 if not open
+	const unsigned char* data;
+	/// size of the mapped file in bytes
+	size_t size;
+#ifdef _WIN32
+	/// handles of the opened file and the file mapping object
+	void* file_handle;
+	void* mapping_handle;
+#endif
+	/// prevent copies that would unmap twice
+	mapped_file(const mapped_file&);
+	mapped_file& operator = (const mapped_file&);
+public:
+	/// construct closed mapping
+	mapped_file();
+	/// close mapping on destruction
+	~mapped_file();
+	/// map the given file and return whether this succeeded
+	bool open(const std::string& file_name);
+	/// unmap the file
+	void close();
+	/// return whether a file is mapped
+	bool is_open() const { return data != 0; }
+	/// return the mapped content
+	const unsigned char* get_data() const { return data; }
+	/// return the size of the mapped content in bytes
+	size_t get_size() const { return size; }
+};
@@ -0,0 +1,191 @@
+#include "mesh_cache.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cctype>
+
+namespace {
+
+/// magic number of spilled mesh files
+const char cache_magic[4] = { 'I', 'M', 'C', '2' };
+
+/// return the number of bytes used by mesh
+size_t get_mesh_size(const extracted_mesh& mesh)
+{
+	return (mesh.positions.size() + mesh.normals.size() + mesh.colors.size())*sizeof(extracted_mesh::vtx_type) + mesh.triangles.size()*sizeof(uint32_t);
+}
+
+/// write the size of v followed by its elements
+template <typename T>
+void write_vector(std::ostream& os, const std::vector<T>& v)
+{
+	uint64_t n = v.size();
+	os.write((const char*)&n, sizeof(n));
+	if (n > 0)
+		os.write((const char*)&v.front(), n*sizeof(T));
+}
+
+/// read a vector written by write_vector
+template <typename T>
+bool read_vector(std::istream& is, std::vector<T>& v)
+{
+	uint64_t n;
+	if (!is.read((char*)&n, sizeof(n)))
+		return false;
+	v.resize(size_t(n));
+	return n == 0 || is.read((char*)&v.front(), n*sizeof(T));
+}
+
+}
+
+/// construct with a budget of 256 MB and without spilling
+mesh_cache::mesh_cache() : memory_size(0), memory_budget(size_t(256) << 20)
+{
+}
+
+/// return a 64 bit FNV-1a hash of text
+uint64_t mesh_cache::compute_hash(const std::string& text)
+{
+	uint64_t h = 14695981039346656037ull;
+	for (unsigned char c : text) {
+		h ^= c;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+/// remove comments from a scene description and replace each run of whitespace between tokens by a single space
+std::string mesh_cache::normalize_description(const std::string& description)
+{
+	std::string key;
+	bool separated = false;
+	for (size_t i = 0; i < description.size(); ++i) {
+		// comments separate tokens like whitespace
+		if (description[i] == '%') {
+			while (i + 1 < description.size() && description[i + 1] != '\n')
+				++i;
+			separated = true;
+			continue;
+		}
+		if (isspace((unsigned char)description[i])) {
+			separated = true;
+			continue;
+		}
+		// whitespace between tokens is kept as a single space
+		if (separated && !key.empty())
+			key += ' ';
+		separated = false;
+		key += description[i];
+	}
+	return key;
+}
+
+/// return the file name of the spilled mesh with the given key
+std::string mesh_cache::get_file_name(const std::string& key) const
+{
+	char name[24];
+	snprintf(name, sizeof(name), "%016llx.imc", (unsigned long long)compute_hash(key));
+	return directory + "/" + name;
+}
+
+/// write the entry to its file in the directory
+bool mesh_cache::spill(const entry& e) const
+{
+	std::ofstream os(get_file_name(e.key).c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	os.write(cache_magic, 4);
+	uint64_t key_length = e.key.size();
+	os.write((const char*)&key_length, sizeof(key_length));
+	os.write(e.key.data(), e.key.size());
+	write_vector(os, e.mesh.positions);
+	write_vector(os, e.mesh.normals);
+	write_vector(os, e.mesh.colors);
+	write_vector(os, e.mesh.triangles);
+	return !os.fail();
+}
+
+/// read the mesh with the given key from its file in the directory
+bool mesh_cache::load(const std::string& key, extracted_mesh& mesh) const
+{
+	std::ifstream is(get_file_name(key).c_str(), std::ios::binary);
+	if (is.fail())
+		return false;
+	char magic[4];
+	uint64_t key_length;
+	if (!is.read(magic, 4) || !std::equal(magic, magic + 4, cache_magic) || !is.read((char*)&key_length, sizeof(key_length)) || key_length != key.size())
+		return false;
+	// files of colliding keys are rejected by comparing the full key
+	std::string file_key(size_t(key_length), ' ');
+	if (!is.read(&file_key[0], key_length) || file_key != key)
+		return false;
+	return read_vector(is, mesh.positions) && read_vector(is, mesh.normals) && read_vector(is, mesh.colors) && read_vector(is, mesh.triangles);
+}
+
+/// spill and remove least recently used entries until the memory size fits into the budget
+void mesh_cache::evict()
+{
+	while (memory_size > memory_budget && !entries.empty()) {
+		const entry& e = entries.back();
+		if (!directory.empty() && !e.spilled && !spill(e))
+			std::cerr << "could not spill cached mesh to " << get_file_name(e.key) << std::endl;
+		memory_size -= e.size;
+		index.erase(e.key);
+		entries.pop_back();
+	}
+}
+
+/// look up the mesh with the given key in memory and then on disk
+bool mesh_cache::find(const std::string& key, extracted_mesh& mesh)
+{
+	auto it = index.find(key);
+	if (it != index.end()) {
+		entries.splice(entries.begin(), entries, it->second);
+		mesh = it->second->mesh;
+		return true;
+	}
+	if (directory.empty() || !load(key, mesh))
+		return false;
+	add(key, mesh, true);
+	return true;
+}
+
+/// store a copy of mesh under the given key in memory and in the directory
+void mesh_cache::insert(const std::string& key, const extracted_mesh& mesh)
+{
+	add(key, mesh, false);
+}
+
+/// store a copy of mesh under the given key in memory, writing it to the directory unless it is already spilled
+void mesh_cache::add(const std::string& key, const extracted_mesh& mesh, bool spilled)
+{
+	auto it = index.find(key);
+	if (it != index.end()) {
+		memory_size -= it->second->size;
+		entries.erase(it->second);
+		index.erase(it);
+	}
+	entry e;
+	e.key = key;
+	e.mesh = mesh;
+	e.size = get_mesh_size(mesh) + key.size();
+	e.spilled = spilled;
+	if (!directory.empty() && !e.spilled) {
+		e.spilled = spill(e);
+		if (!e.spilled)
+			std::cerr << "could not spill cached mesh to " << get_file_name(e.key) << std::endl;
+	}
+	memory_size += e.size;
+	entries.push_front(std::move(e));
+	index[key] = entries.begin();
+	evict();
+}
+
+/// remove all meshes from memory, spilled files are kept
+void mesh_cache::clear()
+{
+	entries.clear();
+	index.clear();
+	memory_size = 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+#include "surface_extractor.h"
+
+/** cache of extracted meshes addressed by a key that describes everything the mesh
+    depends on, such as a normalized scene description together with the sampling box,
+    resolution and contouring parameters. Meshes are kept in memory in least recently used
+    order up to a memory budget. If a directory is given, inserted meshes are also written
+    into binary files named by a hash of their key, which store the full key to detect hash
+    collisions, such that they are loaded again on demand after eviction or in a later
+    session. */
+class mesh_cache
+{
+protected:
+	/// cached mesh with its key and memory size
+	struct entry
+	{
+		std::string key;
+		extracted_mesh mesh;
+		size_t size;
+		/// whether the mesh is stored in the directory
+		bool spilled;
+	};
+	/// entries from most to least recently used
+	std::list<entry> entries;
+	/// entries by key
+	std::unordered_map<std::string, std::list<entry>::iterator> index;
+	/// memory used by all entries in bytes
+	size_t memory_size;
+	/// return the file name of the spilled mesh with the given key
+	std::string get_file_name(const std::string& key) const;
+	/// write the entry to its file in the directory
+	bool spill(const entry& e) const;
+	/// read the mesh with the given key from its file in the directory
+	bool load(const std::string& key, extracted_mesh& mesh) const;
+	/// spill and remove least recently used entries until the memory size fits into the budget
+	void evict();
+	/// store a copy of mesh under the given key in memory, writing it to the directory unless it is already spilled
+	void add(const std::string& key, const extracted_mesh& mesh, bool spilled);
+public:
+	/// maximal memory used by the cached meshes in bytes
+	size_t memory_budget;
+	/// directory into which inserted meshes are spilled, empty to keep them in memory only
+	std::string directory;
+	/// construct with a budget of 256 MB and without spilling
+	mesh_cache();
+	/// return a 64 bit FNV-1a hash of text
+	static uint64_t compute_hash(const std::string& text);
+	/// remove comments from a scene description and replace each run of whitespace between tokens by a single space
+	static std::string normalize_description(const std::string& description);
+	/// look up the mesh with the given key in memory and then on disk, copy it to mesh and return whether it was found
+	bool find(const std::string& key, extracted_mesh& mesh);
+	/// store a copy of mesh under the given key in memory and in the directory
+	void insert(const std::string& key, const extracted_mesh& mesh);
+	/// remove all meshes from memory, spilled files are kept
+	void clear();
+	/// return the number of meshes in memory
+	size_t get_nr_entries() const { return entries.size(); }
+	/// return the memory used by the meshes in bytes
+	size_t get_memory_size() const { return memory_size; }
+};
@@ -0,0 +1,166 @@
+#include "mesh_distance_grid.h"
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <cgv/utils/file.h>
+
+/// closest mesh point of a seed sample together with the pseudo normal of its feature
+struct distance_seed
+{
+	cgv::math::fvec<float, 3> closest_point;
+	cgv::math::fvec<float, 3> pseudo_normal;
+};
+
+/// convert a triangle mesh into a signed distance grid
+bool compute_mesh_distance_grid(const triangle_mesh_bvh& mesh, sampled_grid<float>& grid, double seed_band)
+{
+	typedef triangle_mesh_bvh::pnt_type pnt_type;
+	typedef cgv::math::fvec<float, 3> fpnt_type;
+	const uint32_t no_seed = uint32_t(-1);
+	if (mesh.empty() || grid.empty())
+		return false;
+	int res[3];
+	for (int c = 0; c < 3; ++c)
+		res[c] = int(grid.get_resolution(c));
+	const sampled_grid<float>::vec_type& cell = grid.get_cell_extent();
+	const sampled_grid<float>::pnt_type& p0 = grid.get_box().get_min_pnt();
+	double max_cell = std::max(cell(0), std::max(cell(1), cell(2)));
+	double band = seed_band*max_cell;
+	auto location = [&](int i, int j, int k) { return pnt_type(p0(0) + i*cell(0), p0(1) + j*cell(1), p0(2) + k*cell(2)); };
+	auto index = [&](int i, int j, int k) { return size_t(i) + size_t(res[0])*(size_t(j) + size_t(res[1])*size_t(k)); };
+	size_t n = size_t(res[0])*res[1]*res[2];
+
+	// mark candidate samples inside the bounding boxes of the triangles enlarged by the seed band
+	std::vector<char> candidate(n, 0);
+	const std::vector<pnt_type>& P = mesh.get_positions();
+	const std::vector<uint32_t>& F = mesh.get_triangles();
+	for (size_t t = 0; t < F.size(); t += 3) {
+		int lo[3], hi[3];
+		for (int c = 0; c < 3; ++c) {
+			double t0 = std::min(P[F[t]](c), std::min(P[F[t + 1]](c), P[F[t + 2]](c))) - band;
+			double t1 = std::max(P[F[t]](c), std::max(P[F[t + 1]](c), P[F[t + 2]](c))) + band;
+			lo[c] = std::max(0, int(ceil((t0 - p0(c)) / cell(c))));
+			hi[c] = std::min(res[c] - 1, int(floor((t1 - p0(c)) / cell(c))));
+		}
+		for (int k = lo[2]; k <= hi[2]; ++k)
+			for (int j = lo[1]; j <= hi[1]; ++j)
+				for (int i = lo[0]; i <= hi[0]; ++i)
+					candidate[index(i, j, k)] = 1;
+	}
+
+	// compute exact seeds per slice in parallel and concatenate them
+	std::vector<std::vector<std::pair<size_t, distance_seed> > > slice_seeds(res[2]);
+	parallel_for(0, res[2], [&](int k) {
+		triangle_mesh_bvh::query_result r;
+		for (int j = 0; j < res[1]; ++j)
+			for (int i = 0; i < res[0]; ++i) {
+				size_t vi = index(i, j, k);
+				if (!candidate[vi])
+					continue;
+				pnt_type p = location(i, j, k);
+				if (!mesh.find_closest_point(p, r, band*band))
+					continue;
+				distance_seed s;
+				s.closest_point = fpnt_type(float(r.closest_point(0)), float(r.closest_point(1)), float(r.closest_point(2)));
+				s.pseudo_normal = fpnt_type(float(r.pseudo_normal(0)), float(r.pseudo_normal(1)), float(r.pseudo_normal(2)));
+				slice_seeds[k].push_back(std::make_pair(vi, s));
+			}
+	});
+	candidate.clear();
+	std::vector<distance_seed> seeds;
+	std::vector<uint32_t> nearest(n, no_seed), next_nearest(n);
+	for (auto& ss : slice_seeds) {
+		for (auto& s : ss) {
+			nearest[s.first] = uint32_t(seeds.size());
+			seeds.push_back(s.second);
+		}
+		ss.clear();
+	}
+	if (seeds.empty())
+		return false;
+
+	// jump flooding with decreasing step sizes followed by an extra pass of step one
+	auto sqr_dist = [&](const pnt_type& p, uint32_t s) {
+		const fpnt_type& q = seeds[s].closest_point;
+		double dx = p(0) - q(0), dy = p(1) - q(1), dz = p(2) - q(2);
+		return dx*dx + dy*dy + dz*dz;
+	};
+	int max_res = std::max(res[0], std::max(res[1], res[2]));
+	std::vector<int> steps;
+	for (int step = 1; step < max_res; step *= 2)
+		steps.insert(steps.begin(), step);
+	steps.push_back(1);
+	for (int step : steps) {
+		parallel_for(0, res[2], [&](int k) {
+			for (int j = 0; j < res[1]; ++j)
+				for (int i = 0; i < res[0]; ++i) {
+					pnt_type p = location(i, j, k);
+					size_t vi = index(i, j, k);
+					uint32_t best = nearest[vi];
+					double best_d = best == no_seed ? 1e300 : sqr_dist(p, best);
+					for (int dk = -step; dk <= step; dk += step) {
+						int kk = k + dk;
+						if (kk < 0 || kk >= res[2])
+							continue;
+						for (int dj = -step; dj <= step; dj += step) {
+							int jj = j + dj;
+							if (jj < 0 || jj >= res[1])
+								continue;
+							for (int di = -step; di <= step; di += step) {
+								int ii = i + di;
+								if (ii < 0 || ii >= res[0])
+									continue;
+								uint32_t s = nearest[index(ii, jj, kk)];
+								if (s == no_seed || s == best)
+									continue;
+								double d = sqr_dist(p, s);
+								if (d < best_d) {
+									best_d = d;
+									best = s;
+								}
+							}
+						}
+					}
+					next_nearest[vi] = best;
+				}
+		});
+		nearest.swap(next_nearest);
+	}
+
+	// convert nearest seeds into signed distances, where the sign depends on the side of the pseudo normal plane
+	parallel_for(0, res[2], [&](int k) {
+		for (int j = 0; j < res[1]; ++j)
+			for (int i = 0; i < res[0]; ++i) {
+				pnt_type p = location(i, j, k);
+				const distance_seed& s = seeds[nearest[index(i, j, k)]];
+				double side = 0;
+				for (int c = 0; c < 3; ++c)
+					side += (p(c) - s.closest_point(c))*s.pseudo_normal(c);
+				float d = float(sqrt(sqr_dist(p, nearest[index(i, j, k)])));
+				grid.ref_value(i, j, k) = side < 0 ? -d : d;
+			}
+	});
+	return true;
+}
+
+/// write a grid as 8 bit .vox file with a .hd header
+bool write_vox_volume(const std::string& file_name, const sampled_grid<float>& grid, double zero_value, double one_value)
+{
+	std::string hd_fn = cgv::utils::file::drop_extension(file_name) + ".hd";
+	std::ofstream os(hd_fn.c_str());
+	if (os.fail())
+		return false;
+	sampled_grid<float>::vec_type extent = grid.get_box().get_extent();
+	os << "Size:      " << grid.get_resolution(0) << ", " << grid.get_resolution(1) << ", " << grid.get_resolution(2) << std::endl;
+	os << "Spacing:   " << extent(0) << ", " << extent(1) << ", " << extent(2) << std::endl;
+	os.close();
+
+	const std::vector<float>& values = grid.get_values();
+	std::vector<unsigned char> data(values.size());
+	double scale = one_value != zero_value ? 255 / (one_value - zero_value) : 0;
+	for (size_t i = 0; i < values.size(); ++i) {
+		double v = (values[i] - zero_value)*scale;
+		data[i] = (unsigned char)(v <= 0 ? 0 : (v >= 255 ? 255 : int(v)));
+	}
+	return cgv::utils::file::write(file_name, (const char*)&data.front(), data.size());
+}
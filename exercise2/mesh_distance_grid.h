@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include "triangle_mesh_bvh.h"
+#include "sampled_grid.h"
+
+/** convert a triangle mesh into a signed distance grid. The grid needs to be resized to
+    the desired box and resolution beforehand. Samples within seed_band cells of a
+    triangle receive exact distances from bounded bvh queries. These seeds are then
+    propagated to all other samples with parallel jump flooding (including a final pass
+    of step one), where each sample inherits the closest point of the nearest seed and
+    takes its sign from the pseudo normal of the closest feature.
+    Returns false if the mesh is empty or no sample lies close to the mesh. */
+extern bool compute_mesh_distance_grid(const triangle_mesh_bvh& mesh, sampled_grid<float>& grid, double seed_band = 1.5);
+
+/** write a grid as 8 bit .vox file with a .hd header in the format of the volume export
+    of the implicit surface drawable, mapping zero_value to 0 and one_value to 255. */
+extern bool write_vox_volume(const std::string& file_name, const sampled_grid<float>& grid, double zero_value, double one_value);
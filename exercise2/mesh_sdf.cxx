@@ -0,0 +1,213 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <cgv/math/fvec.h>
+#include <cgv/signal/rebind.h>
+#include <cgv/gui/file_dialog.h>
+#include "implicit_primitive.h"
+#include "triangle_mesh_bvh.h"
+#include "mesh_distance_grid.h"
+#include "parallel_for.h"
+
+/** implicit primitive given by the signed distance to a triangle mesh read from an obj
+    file. Distance queries are accelerated with a bounding volume hierarchy and the sign
+    is taken from angle weighted pseudo normals. With normalize enabled the mesh is scaled
+    to fit into [-1,1]^3. The mesh is loaded on first evaluation. If res is positive, a
+    signed distance grid of that resolution is precomputed over the enlarged bounding box
+    of the mesh with jump flooding and interpolated instead of querying the bvh. */
+template <typename T>
+struct mesh_sdf : public implicit_primitive<T>
+{
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+
+	/// name of the obj file
+	std::string file_name;
+	/// whether to fit the mesh into [-1,1]^3
+	bool normalize;
+	/// resolution of the precomputed distance grid or 0 for exact evaluation
+	unsigned res;
+
+protected:
+	/// mesh with bvh and optional distance grid, which are replaced as a whole when the parameters change
+	struct mesh_data
+	{
+		/// mesh with bvh
+		triangle_mesh_bvh mesh;
+		/// precomputed distance grid, empty if res is 0
+		sampled_grid<float> grid;
+	};
+	typedef std::shared_ptr<const mesh_data> data_ptr;
+	/// data built from the current parameters or empty if not loaded, published with atomic stores such that readers keep it alive while they use it
+	mutable data_ptr data;
+	/// whether loading has been tried since the last change
+	mutable std::atomic<bool> load_attempted;
+	/// serializes loading and the reset after parameter changes
+	mutable std::mutex load_mutex;
+
+	/// compute the distance grid of d over the bounding box of the mesh enlarged by 10 percent
+	void build_grid(mesh_data& d) const
+	{
+		if (res < 2)
+			return;
+		triangle_mesh_bvh::box_type b = d.mesh.get_box();
+		triangle_mesh_bvh::vec_type margin = b.get_extent()*0.05 + triangle_mesh_bvh::vec_type(1e-3, 1e-3, 1e-3);
+		typedef typename sampled_grid<float>::pnt_type grid_pnt;
+		d.grid.resize(typename sampled_grid<float>::box_type(
+			grid_pnt(float(b.get_min_pnt()(0) - margin(0)), float(b.get_min_pnt()(1) - margin(1)), float(b.get_min_pnt()(2) - margin(2))),
+			grid_pnt(float(b.get_max_pnt()(0) + margin(0)), float(b.get_max_pnt()(1) + margin(1)), float(b.get_max_pnt()(2) + margin(2)))), res, res, res);
+		if (compute_mesh_distance_grid(d.mesh, d.grid))
+			std::cout << "mesh_sdf: computed " << res << "^3 distance grid" << std::endl;
+		else
+			d.grid = sampled_grid<float>();
+	}
+	/// convert a point to the point type of the grid
+	static typename sampled_grid<float>::pnt_type to_grid_pnt(const pnt_type& p)
+	{
+		return typename sampled_grid<float>::pnt_type(float(p(0)), float(p(1)), float(p(2)));
+	}
+	/// read the mesh and build bvh and grid into new data; returns an empty pointer if no triangles could be read
+	data_ptr load() const
+	{
+		if (file_name.empty())
+			return data_ptr();
+		std::shared_ptr<mesh_data> d(new mesh_data());
+		if (!d->mesh.read_obj(file_name) || d->mesh.empty()) {
+			std::cerr << "mesh_sdf: could not read triangles from " << file_name << std::endl;
+			return data_ptr();
+		}
+		if (normalize)
+			d->mesh.normalize(2.0);
+		d->mesh.build();
+		std::cout << "mesh_sdf: built bvh over " << d->mesh.get_nr_triangles() << " triangles of " << file_name << std::endl;
+		build_grid(*d);
+		return d;
+	}
+	/// return the data of the current parameters, which is loaded on first call; returns an empty pointer if no mesh is available
+	data_ptr get_data() const
+	{
+		data_ptr d = std::atomic_load(&data);
+		if (d || load_attempted)
+			return d;
+		std::lock_guard<std::mutex> lock(load_mutex);
+		d = std::atomic_load(&data);
+		if (d || load_attempted)
+			return d;
+		d = load();
+		std::atomic_store(&data, d);
+		load_attempted = true;
+		return d;
+	}
+
+public:
+	mesh_sdf() : normalize(true), res(0), load_attempted(false) { implicit_base<T>::gui_color = 0xFF8888; }
+	std::string get_type_name() const { return "mesh_sdf"; }
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("file", file_name) &&
+			rh.reflect_member("normalize", normalize) &&
+			rh.reflect_member("res", res) &&
+			implicit_primitive<T>::self_reflect(rh);
+	}
+	void on_set(void* member_ptr)
+	{
+		if (member_ptr == &file_name || member_ptr == &normalize || member_ptr == &res) {
+			// evaluations in other threads keep the previous mesh until they finished
+			std::lock_guard<std::mutex> lock(load_mutex);
+			std::atomic_store(&data, data_ptr());
+			load_attempted = false;
+		}
+		implicit_primitive<T>::on_set(member_ptr);
+	}
+	/// signed distance to the mesh
+	T evaluate(const pnt_type& p) const
+	{
+		data_ptr d = get_data();
+		if (!d)
+			return 1;
+		if (!d->grid.empty() && d->grid.contains(to_grid_pnt(p)))
+			return T(d->grid.interpolate(to_grid_pnt(p)));
+		return T(d->mesh.signed_distance(p));
+	}
+	/// normalized direction from the closest point, oriented outwards
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		data_ptr d = get_data();
+		if (!d)
+			return vec_type(0, 0, 0);
+		if (!d->grid.empty() && d->grid.contains(to_grid_pnt(p))) {
+			typename sampled_grid<float>::vec_type g = d->grid.interpolate_gradient(to_grid_pnt(p));
+			return vec_type(g(0), g(1), g(2));
+		}
+		vec_type g;
+		d->mesh.signed_distance(p, g);
+		return g;
+	}
+	/** batch evaluation in blocks of consecutive points distributed over all hardware threads.
+	    Within a block the closest point of the previous query bounds the search radius of
+	    the next one, which prunes most of the bvh for spatially coherent batches such as
+	    grid slices. */
+	void evaluate_batch(const std::vector<pnt_type>& ps, std::vector<T>& vs) const
+	{
+		vs.resize(ps.size());
+		data_ptr d = get_data();
+		if (!d) {
+			std::fill(vs.begin(), vs.end(), T(1));
+			return;
+		}
+		if (!d->grid.empty()) {
+			implicit_base<T>::evaluate_batch(ps, vs);
+			return;
+		}
+		const triangle_mesh_bvh& mesh = d->mesh;
+		const int block_size = 256;
+		parallel_for(0, int((ps.size() + block_size - 1) / block_size), [&](int b) {
+			size_t end = std::min(ps.size(), size_t(b + 1)*block_size);
+			triangle_mesh_bvh::query_result r;
+			bool has_previous = false;
+			pnt_type q;
+			for (size_t i = size_t(b)*block_size; i < end; ++i) {
+				double bound = has_previous ? (ps[i] - q).sqr_length()*(1 + 1e-9) + 1e-30 : 1e300;
+				if (!mesh.find_closest_point(ps[i], r, bound)) {
+					vs[i] = T(mesh.signed_distance(ps[i]));
+					has_previous = false;
+					continue;
+				}
+				q = r.closest_point;
+				has_previous = true;
+				double d = sqrt(r.sqr_distance);
+				vs[i] = T(dot(ps[i] - q, r.pseudo_normal) < 0 ? -d : d);
+			}
+		});
+	}
+	/// save the distance grid as 8 bit volume mapping the symmetric range of distances to [0,255]
+	void save_grid()
+	{
+		data_ptr d = get_data();
+		if (!d || d->grid.empty()) {
+			std::cerr << "mesh_sdf: set res to compute a distance grid before saving" << std::endl;
+			return;
+		}
+		std::string fn = cgv::gui::file_save_dialog("choose vox output file", "Vox Files (vox):*.vox|All Files:*.*");
+		if (fn.empty())
+			return;
+		float max_abs = 0;
+		for (float v : d->grid.get_values())
+			max_abs = std::max(max_abs, std::abs(v));
+		if (write_vox_volume(fn, d->grid, -max_abs, max_abs))
+			std::cout << "mesh_sdf: saved " << fn << ", use zero=" << -max_abs << " and one=" << max_abs << " in the volume primitive" << std::endl;
+		else
+			std::cerr << "mesh_sdf: could not write " << fn << std::endl;
+	}
+	void create_gui()
+	{
+		provider::add_member_control(this, "file", file_name);
+		provider::add_member_control(this, "normalize", normalize, "check");
+		provider::add_member_control(this, "res", res, "value_slider", "min=0;max=512;log=true;ticks=true");
+		connect_copy(provider::add_button("save grid to vox")->click, cgv::signal::rebind(this, &mesh_sdf<T>::save_grid));
+		implicit_primitive<T>::create_gui();
+	}
+};
+
+scene_factory_registration<mesh_sdf<double> > sfr_mesh_sdf("mesh_sdf");
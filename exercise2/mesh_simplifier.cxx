@@ -0,0 +1,344 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <queue>
+#include <cmath>
+
+namespace {
+
+/// candidate collapse of the edge (u,v) with the versions of both vertices at the time of queueing
+struct collapse_candidate
+{
+	double error;
+	uint32_t u, v, version_u, version_v;
+	bool operator < (const collapse_candidate& c) const { return error > c.error; }
+};
+
+/// compute the cross product of b-a and c-a
+void triangle_normal(const double* a, const double* b, const double* c, double n[3])
+{
+	double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+	n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+	n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+	n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+}
+
+/// add the squared distance to the plane n.x + d = 0 weighted by w
+void mesh_simplifier::quadric::add_plane(const double n[3], double d, double w)
+{
+	q[0] += w*n[0] * n[0]; q[1] += w*n[0] * n[1]; q[2] += w*n[0] * n[2]; q[3] += w*n[0] * d;
+	q[4] += w*n[1] * n[1]; q[5] += w*n[1] * n[2]; q[6] += w*n[1] * d;
+	q[7] += w*n[2] * n[2]; q[8] += w*n[2] * d;
+	q[9] += w*d*d;
+}
+
+/// evaluate the quadric at x
+double mesh_simplifier::quadric::evaluate(const double x[3]) const
+{
+	return q[0] * x[0] * x[0] + 2 * q[1] * x[0] * x[1] + 2 * q[2] * x[0] * x[2] + 2 * q[3] * x[0]
+		+ q[4] * x[1] * x[1] + 2 * q[5] * x[1] * x[2] + 2 * q[6] * x[1]
+		+ q[7] * x[2] * x[2] + 2 * q[8] * x[2] + q[9];
+}
+
+/// compute the minimum into x and return whether the quadric is well conditioned
+bool mesh_simplifier::quadric::compute_minimum(double x[3]) const
+{
+	// solve A x = -b with Cramer's rule
+	double a00 = q[0], a01 = q[1], a02 = q[2], a11 = q[4], a12 = q[5], a22 = q[7];
+	double c00 = a11*a22 - a12*a12, c01 = a02*a12 - a01*a22, c02 = a01*a12 - a02*a11;
+	double det = a00*c00 + a01*c01 + a02*c02;
+	double scale = std::max(std::abs(a00), std::max(std::abs(a11), std::abs(a22)));
+	if (!(std::abs(det) > 1e-10*scale*scale*scale))
+		return false;
+	double c11 = a00*a22 - a02*a02, c12 = a01*a02 - a00*a12, c22 = a00*a11 - a01*a01;
+	double b[3] = { -q[3], -q[6], -q[8] };
+	x[0] = (c00*b[0] + c01*b[1] + c02*b[2]) / det;
+	x[1] = (c01*b[0] + c11*b[1] + c12*b[2]) / det;
+	x[2] = (c02*b[0] + c12*b[1] + c22*b[2]) / det;
+	return true;
+}
+
+/// construct without target and error bound
+mesh_simplifier::mesh_simplifier() : target_nr_triangles(0), max_error(-1), min_normal_cosine(0.2)
+{
+}
+
+/// initialize the connectivity and the quadrics from mesh
+void mesh_simplifier::init(const extracted_mesh& mesh)
+{
+	size_t nv = mesh.positions.size(), nt = mesh.get_nr_triangles();
+	P.resize(3 * nv);
+	for (size_t v = 0; v < nv; ++v)
+		for (int c = 0; c < 3; ++c)
+			P[3 * v + c] = mesh.positions[v](c);
+	T = mesh.triangles;
+	removed.assign(nt, 0);
+	Q.assign(nv, quadric());
+	vertex_triangles.assign(nv, std::vector<uint32_t>());
+	on_boundary.assign(nv, 0);
+	version.assign(nv, 0);
+	parent.resize(nv);
+	for (size_t v = 0; v < nv; ++v)
+		parent[v] = uint32_t(v);
+	// plane quadrics weighted by triangle area
+	for (size_t t = 0; t < nt; ++t) {
+		const uint32_t* vi = &T[3 * t];
+		double n[3];
+		triangle_normal(&P[3 * vi[0]], &P[3 * vi[1]], &P[3 * vi[2]], n);
+		double l = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (l > 0) {
+			for (int c = 0; c < 3; ++c)
+				n[c] /= l;
+			double d = -(n[0] * P[3 * vi[0]] + n[1] * P[3 * vi[0] + 1] + n[2] * P[3 * vi[0] + 2]);
+			quadric Qt;
+			Qt.add_plane(n, d, 0.5*l);
+			for (int c = 0; c < 3; ++c)
+				Q[vi[c]] += Qt;
+		}
+		for (int c = 0; c < 3; ++c)
+			vertex_triangles[vi[c]].push_back(uint32_t(t));
+	}
+	// boundary edges are used by a single triangle, detect them by sorting the directed edges
+	std::vector<std::pair<uint64_t, uint32_t> > edges;
+	edges.reserve(T.size());
+	for (size_t t = 0; t < nt; ++t)
+		for (int c = 0; c < 3; ++c) {
+			uint32_t a = T[3 * t + c], b = T[3 * t + (c + 1) % 3];
+			edges.push_back(std::make_pair((uint64_t(std::min(a, b)) << 32) | std::max(a, b), uint32_t(t)));
+		}
+	std::sort(edges.begin(), edges.end());
+	for (size_t e = 0; e < edges.size(); ) {
+		size_t f = e + 1;
+		while (f < edges.size() && edges[f].first == edges[e].first)
+			++f;
+		if (f - e == 1) {
+			// penalize motion away from the boundary with a plane through the edge perpendicular to its triangle
+			uint32_t a = uint32_t(edges[e].first >> 32), b = uint32_t(edges[e].first & 0xffffffff);
+			const uint32_t* vi = &T[3 * edges[e].second];
+			double n[3], m[3], d[3] = { P[3 * b] - P[3 * a], P[3 * b + 1] - P[3 * a + 1], P[3 * b + 2] - P[3 * a + 2] };
+			triangle_normal(&P[3 * vi[0]], &P[3 * vi[1]], &P[3 * vi[2]], n);
+			m[0] = d[1] * n[2] - d[2] * n[1];
+			m[1] = d[2] * n[0] - d[0] * n[2];
+			m[2] = d[0] * n[1] - d[1] * n[0];
+			double l = sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+			if (l > 0) {
+				for (int c = 0; c < 3; ++c)
+					m[c] /= l;
+				quadric Qb;
+				Qb.add_plane(m, -(m[0] * P[3 * a] + m[1] * P[3 * a + 1] + m[2] * P[3 * a + 2]), d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+				Q[a] += Qb;
+				Q[b] += Qb;
+			}
+			on_boundary[a] = on_boundary[b] = 1;
+		}
+		e = f;
+	}
+}
+
+/// collect the vertices adjacent to v
+void mesh_simplifier::collect_neighbors(uint32_t v, std::vector<uint32_t>& neighbors) const
+{
+	neighbors.clear();
+	for (uint32_t t : vertex_triangles[v]) {
+		if (removed[t])
+			continue;
+		for (int c = 0; c < 3; ++c)
+			if (T[3 * t + c] != v)
+				neighbors.push_back(T[3 * t + c]);
+	}
+	std::sort(neighbors.begin(), neighbors.end());
+	neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+}
+
+/// compute the location x and error of collapsing the edge (u,v)
+double mesh_simplifier::compute_collapse(uint32_t u, uint32_t v, double x[3]) const
+{
+	quadric Quv = Q[u];
+	Quv += Q[v];
+	if (Quv.compute_minimum(x))
+		return std::max(0.0, Quv.evaluate(x));
+	// fall back to the best of the end points and the edge midpoint
+	double candidates[3][3];
+	for (int c = 0; c < 3; ++c) {
+		candidates[0][c] = P[3 * u + c];
+		candidates[1][c] = P[3 * v + c];
+		candidates[2][c] = 0.5*(P[3 * u + c] + P[3 * v + c]);
+	}
+	double best_error = 0;
+	for (int i = 0; i < 3; ++i) {
+		double error = Quv.evaluate(candidates[i]);
+		if (i == 0 || error < best_error) {
+			best_error = error;
+			std::copy(candidates[i], candidates[i] + 3, x);
+		}
+	}
+	return std::max(0.0, best_error);
+}
+
+/// check whether the edge (u,v) can be collapsed to x without topological changes or flipped triangles
+bool mesh_simplifier::is_collapse_valid(uint32_t u, uint32_t v, const double x[3]) const
+{
+	// link condition: the common neighbors of u and v are exactly the opposite vertices of the shared triangles
+	std::vector<uint32_t> nu, nv, common;
+	collect_neighbors(u, nu);
+	collect_neighbors(v, nv);
+	std::set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(), std::back_inserter(common));
+	size_t nr_shared = 0;
+	for (uint32_t t : vertex_triangles[u]) {
+		if (removed[t])
+			continue;
+		if (T[3 * t] == v || T[3 * t + 1] == v || T[3 * t + 2] == v)
+			++nr_shared;
+	}
+	if (nr_shared == 0 || common.size() != nr_shared)
+		return false;
+	// an interior edge between two boundary vertices would pinch the surface
+	if (nr_shared == 2 && on_boundary[u] && on_boundary[v])
+		return false;
+	// no remaining triangle may flip or degenerate
+	for (int s = 0; s < 2; ++s) {
+		uint32_t w = s == 0 ? u : v, o = s == 0 ? v : u;
+		for (uint32_t t : vertex_triangles[w]) {
+			if (removed[t])
+				continue;
+			const uint32_t* vi = &T[3 * t];
+			if (vi[0] == o || vi[1] == o || vi[2] == o)
+				continue;
+			const double* p[3];
+			const double* q[3];
+			for (int c = 0; c < 3; ++c) {
+				p[c] = &P[3 * vi[c]];
+				q[c] = vi[c] == w ? x : p[c];
+			}
+			double n0[3], n1[3];
+			triangle_normal(p[0], p[1], p[2], n0);
+			triangle_normal(q[0], q[1], q[2], n1);
+			double d = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+			double l0 = n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2];
+			double l1 = n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2];
+			if (d <= 0 || d*d < min_normal_cosine*min_normal_cosine*l0*l1)
+				return false;
+		}
+	}
+	return true;
+}
+
+/// collapse v into u at location x and return the number of removed triangles
+size_t mesh_simplifier::collapse(uint32_t u, uint32_t v, const double x[3])
+{
+	size_t nr_removed = 0;
+	for (uint32_t t : vertex_triangles[v]) {
+		if (removed[t])
+			continue;
+		uint32_t* vi = &T[3 * t];
+		if (vi[0] == u || vi[1] == u || vi[2] == u) {
+			removed[t] = 1;
+			++nr_removed;
+			continue;
+		}
+		for (int c = 0; c < 3; ++c)
+			if (vi[c] == v)
+				vi[c] = u;
+		vertex_triangles[u].push_back(t);
+	}
+	std::vector<uint32_t>().swap(vertex_triangles[v]);
+	// drop removed triangles from the list of u
+	std::vector<uint32_t>& vt = vertex_triangles[u];
+	vt.erase(std::remove_if(vt.begin(), vt.end(), [this](uint32_t t) { return removed[t] != 0; }), vt.end());
+	std::copy(x, x + 3, &P[3 * u]);
+	Q[u] += Q[v];
+	on_boundary[u] = on_boundary[u] || on_boundary[v];
+	parent[v] = u;
+	++version[u];
+	++version[v];
+	return nr_removed;
+}
+
+/// write the remaining triangles and vertices back to mesh
+void mesh_simplifier::compact(extracted_mesh& mesh)
+{
+	std::vector<uint32_t> new_index(parent.size(), uint32_t(-1));
+	extracted_mesh::vtx_type zero(0, 0, 0);
+	std::vector<extracted_mesh::vtx_type> positions, normals;
+	bool has_normals = mesh.normals.size() == mesh.positions.size();
+	mesh.triangles.clear();
+	for (size_t t = 0; t < removed.size(); ++t) {
+		if (removed[t])
+			continue;
+		for (int c = 0; c < 3; ++c) {
+			uint32_t v = T[3 * t + c];
+			if (new_index[v] == uint32_t(-1)) {
+				new_index[v] = uint32_t(positions.size());
+				positions.push_back(extracted_mesh::vtx_type(float(P[3 * v]), float(P[3 * v + 1]), float(P[3 * v + 2])));
+				if (has_normals)
+					normals.push_back(zero);
+			}
+			mesh.triangles.push_back(new_index[v]);
+		}
+	}
+	// the normal of a surviving vertex averages the normals of all vertices collapsed into it
+	if (has_normals) {
+		for (size_t v = 0; v < parent.size(); ++v) {
+			uint32_t r = uint32_t(v);
+			while (parent[r] != r)
+				r = parent[r];
+			if (new_index[r] != uint32_t(-1))
+				normals[new_index[r]] += mesh.normals[v];
+		}
+		for (auto& n : normals)
+			n.normalize();
+	}
+	mesh.positions.swap(positions);
+	mesh.normals.swap(normals);
+}
+
+/// simplify mesh in place and return the number of performed collapses
+size_t mesh_simplifier::simplify(extracted_mesh& mesh)
+{
+	if (target_nr_triangles == 0 && max_error < 0)
+		return 0;
+	init(mesh);
+	size_t nr_triangles = mesh.get_nr_triangles();
+	std::priority_queue<collapse_candidate> queue;
+	double x[3];
+	auto push_edge = [&](uint32_t u, uint32_t v) {
+		collapse_candidate cc;
+		cc.error = compute_collapse(u, v, x);
+		cc.u = u;
+		cc.v = v;
+		cc.version_u = version[u];
+		cc.version_v = version[v];
+		queue.push(cc);
+	};
+	for (size_t t = 0; t < nr_triangles; ++t)
+		for (int c = 0; c < 3; ++c) {
+			uint32_t a = T[3 * t + c], b = T[3 * t + (c + 1) % 3];
+			// interior edges appear in both directions, boundary edges only once
+			if (a < b || on_boundary[a] || on_boundary[b])
+				push_edge(a, b);
+		}
+	size_t nr_collapses = 0;
+	std::vector<uint32_t> neighbors;
+	while (!queue.empty() && (target_nr_triangles == 0 || nr_triangles > target_nr_triangles)) {
+		collapse_candidate cc = queue.top();
+		queue.pop();
+		if (cc.version_u != version[cc.u] || cc.version_v != version[cc.v] || parent[cc.u] != cc.u || parent[cc.v] != cc.v)
+			continue;
+		// the quadric error is a weighted sum of squared plane distances, its mean is compared to the distance bound
+		if (max_error >= 0 && cc.error > max_error*max_error*(Q[cc.u].get_weight() + Q[cc.v].get_weight()))
+			continue;
+		compute_collapse(cc.u, cc.v, x);
+		if (!is_collapse_valid(cc.u, cc.v, x))
+			continue;
+		nr_triangles -= collapse(cc.u, cc.v, x);
+		++nr_collapses;
+		// the errors of all edges around the merged vertex changed
+		collect_neighbors(cc.u, neighbors);
+		for (uint32_t w : neighbors)
+			push_edge(cc.u, w);
+	}
+	compact(mesh);
+	return nr_collapses;
+}
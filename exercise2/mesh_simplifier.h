@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "surface_extractor.h"
+
+/** simplifies extracted meshes by edge collapses ordered by quadric error metrics as
+    proposed by Garland and Heckbert. Each vertex accumulates the area weighted quadrics of
+    the planes of its incident triangles, boundary edges contribute perpendicular planes
+    that keep the boundary in place. Candidate collapses are kept in a priority queue
+    with lazy invalidation and moved vertices are placed at the minimum of the summed
+    quadric. Collapses that violate the link condition, would pinch the boundary or flip
+    triangles are rejected. Connectivity is kept as indexed triangles plus per vertex
+    triangle lists. */
+class mesh_simplifier
+{
+public:
+	/// symmetric 4x4 quadric stored as upper triangle
+	struct quadric
+	{
+		double q[10];
+		quadric() { for (int i = 0; i < 10; ++i) q[i] = 0; }
+		/// add the squared distance to the plane n.x + d = 0 weighted by w
+		void add_plane(const double n[3], double d, double w);
+		quadric& operator += (const quadric& Q) { for (int i = 0; i < 10; ++i) q[i] += Q.q[i]; return *this; }
+		/// evaluate the quadric at x
+		double evaluate(const double x[3]) const;
+		/// return the sum of the plane weights, which is the trace of the quadratic part for unit normals
+		double get_weight() const { return q[0] + q[4] + q[7]; }
+		/// compute the minimum into x and return whether the quadric is well conditioned
+		bool compute_minimum(double x[3]) const;
+	};
+	/// stop once the number of triangles reaches this target, 0 switches the target off
+	size_t target_nr_triangles;
+	/// reject collapses that move the vertex further than this root mean square distance from the planes of its quadric, negative values switch the bound off; without target and bound the mesh is not simplified
+	double max_error;
+	/// minimal cosine between triangle normals before and after a collapse
+	double min_normal_cosine;
+
+protected:
+	/// vertex locations
+	std::vector<double> P;
+	/// vertex quadrics
+	std::vector<quadric> Q;
+	/// triangles as vertex index triples
+	std::vector<uint32_t> T;
+	/// per triangle whether it is removed
+	std::vector<char> removed;
+	/// per vertex the list of incident triangles, which may contain removed ones
+	std::vector<std::vector<uint32_t> > vertex_triangles;
+	/// per vertex whether it lies on the boundary
+	std::vector<char> on_boundary;
+	/// per vertex version counter that invalidates queued collapses
+	std::vector<uint32_t> version;
+	/// per vertex the vertex it was collapsed into or itself
+	std::vector<uint32_t> parent;
+
+	/// initialize the connectivity and the quadrics from mesh
+	void init(const extracted_mesh& mesh);
+	/// collect the vertices adjacent to v
+	void collect_neighbors(uint32_t v, std::vector<uint32_t>& neighbors) const;
+	/// compute the location x and error of collapsing the edge (u,v)
+	double compute_collapse(uint32_t u, uint32_t v, double x[3]) const;
+	/// check whether the edge (u,v) can be collapsed to x without topological changes or flipped triangles
+	bool is_collapse_valid(uint32_t u, uint32_t v, const double x[3]) const;
+	/// collapse v into u at location x and return the number of removed triangles
+	size_t collapse(uint32_t u, uint32_t v, const double x[3]);
+	/// write the remaining triangles and vertices back to mesh
+	void compact(extracted_mesh& mesh);
+
+public:
+	/// construct without target and error bound
+	mesh_simplifier();
+	/// simplify mesh in place and return the number of performed collapses
+	size_t simplify(extracted_mesh& mesh);
+};
@@ -0,0 +1,194 @@
+#include "mesh_sweep.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// map a unit vector to octahedral coordinates in [-1,1]^2
+void encode_octahedral(const extracted_mesh::vtx_type& n, float& u, float& v)
+{
+	float l1 = std::abs(n(0)) + std::abs(n(1)) + std::abs(n(2));
+	if (l1 == 0) {
+		u = v = 0;
+		return;
+	}
+	u = n(0) / l1;
+	v = n(1) / l1;
+	// fold the lower hemisphere over the diagonals
+	if (n(2) < 0) {
+		float fu = (1 - std::abs(v))*(u < 0 ? -1.0f : 1.0f);
+		float fv = (1 - std::abs(u))*(v < 0 ? -1.0f : 1.0f);
+		u = fu;
+		v = fv;
+	}
+}
+
+/// map octahedral coordinates back to a unit vector
+extracted_mesh::vtx_type decode_octahedral(float u, float v)
+{
+	extracted_mesh::vtx_type n(u, v, 1 - std::abs(u) - std::abs(v));
+	if (n(2) < 0) {
+		n(0) = (1 - std::abs(v))*(u < 0 ? -1.0f : 1.0f);
+		n(1) = (1 - std::abs(u))*(v < 0 ? -1.0f : 1.0f);
+	}
+	float l = n.length();
+	return l > 0 ? n / l : n;
+}
+
+}
+
+/// quantize mesh within box
+void mesh_sweep::compact_mesh::encode(const extracted_mesh& mesh, const box_type& box)
+{
+	size_t n = mesh.positions.size();
+	positions.resize(3 * n);
+	for (size_t vi = 0; vi < n; ++vi)
+		for (int c = 0; c < 3; ++c) {
+			double x = (mesh.positions[vi](c) - box.get_min_pnt()(c)) / box.get_extent()(c);
+			positions[3 * vi + c] = uint16_t(std::max(0.0, std::min(1.0, x))*65535 + 0.5);
+		}
+	normals.resize(mesh.normals.size() == n ? 2 * n : 0);
+	for (size_t vi = 0; 2 * vi < normals.size(); ++vi) {
+		float u, v;
+		encode_octahedral(mesh.normals[vi], u, v);
+		normals[2 * vi] = int16_t(std::lround(u * 32767));
+		normals[2 * vi + 1] = int16_t(std::lround(v * 32767));
+	}
+	triangles = mesh.triangles;
+}
+
+/// reconstruct the mesh within box
+void mesh_sweep::compact_mesh::decode(const box_type& box, extracted_mesh& mesh) const
+{
+	size_t n = positions.size() / 3;
+	mesh.positions.resize(n);
+	for (size_t vi = 0; vi < n; ++vi)
+		for (int c = 0; c < 3; ++c)
+			mesh.positions[vi](c) = float(box.get_min_pnt()(c) + positions[3 * vi + c] * (box.get_extent()(c) / 65535));
+	mesh.normals.resize(normals.size() / 2);
+	for (size_t vi = 0; vi < mesh.normals.size(); ++vi)
+		mesh.normals[vi] = decode_octahedral(normals[2 * vi] / 32767.0f, normals[2 * vi + 1] / 32767.0f);
+	mesh.triangles = triangles;
+}
+
+/// return the memory used in bytes
+size_t mesh_sweep::compact_mesh::get_memory_size() const
+{
+	return positions.size()*sizeof(uint16_t) + normals.size()*sizeof(int16_t) + triangles.size()*sizeof(uint32_t);
+}
+
+/// construct without samples
+mesh_sweep::mesh_sweep() : res(0), nr_ready(0), cancelled(false)
+{
+}
+
+/// stop the background thread
+mesh_sweep::~mesh_sweep()
+{
+	cancel();
+}
+
+/// extract all samples in coarse to fine order
+void mesh_sweep::run()
+{
+	size_t n = values.size();
+	if (n == 0)
+		return;
+	// end points first, followed by samples at halved spacings
+	std::vector<size_t> order(1, 0);
+	std::vector<char> scheduled(n, 0);
+	scheduled[0] = 1;
+	if (n > 1) {
+		order.push_back(n - 1);
+		scheduled[n - 1] = 1;
+	}
+	size_t step = 1;
+	while (step + 1 < n)
+		step *= 2;
+	for (; step > 0; step /= 2)
+		for (size_t si = 0; si < n; si += step)
+			if (!scheduled[si]) {
+				scheduled[si] = 1;
+				order.push_back(si);
+			}
+	extracted_mesh mesh;
+	compact_mesh cm;
+	for (size_t si : order) {
+		if (cancelled)
+			return;
+		extractor.extract(functions[si], box, res, mesh);
+		// the extractor stops early once cancelled and leaves an empty mesh
+		if (cancelled)
+			return;
+		cm.encode(mesh, box);
+		std::lock_guard<std::mutex> lock(mutex);
+		meshes[si].positions.swap(cm.positions);
+		meshes[si].normals.swap(cm.normals);
+		meshes[si].triangles.swap(cm.triangles);
+		ready[si] = 1;
+		++nr_ready;
+	}
+	extractor.clear();
+}
+
+/// start extracting the functions at the given parameter values with a copy of the configured extractor in the background
+void mesh_sweep::start(const surface_extractor& configured_extractor, const box_type& _box, unsigned _res, const std::vector<double>& _values, const std::vector<const function_type*>& _functions)
+{
+	clear();
+	extractor = configured_extractor;
+	extractor.clear();
+	extractor.cancel_flag = &cancelled;
+	box = _box;
+	res = _res;
+	values = _values;
+	functions = _functions;
+	meshes.resize(values.size());
+	ready.assign(values.size(), 0);
+	cancelled = false;
+	worker = std::thread(&mesh_sweep::run, this);
+}
+
+/// stop the background thread and wait for it
+void mesh_sweep::cancel()
+{
+	cancelled = true;
+	if (worker.joinable())
+		worker.join();
+}
+
+/// stop the background thread and remove all samples
+void mesh_sweep::clear()
+{
+	cancel();
+	values.clear();
+	functions.clear();
+	meshes.clear();
+	ready.clear();
+	nr_ready = 0;
+}
+
+/// decode the extracted mesh whose parameter value is closest to value
+bool mesh_sweep::get_nearest(double value, extracted_mesh& mesh, double* found_value) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t best = values.size();
+	for (size_t si = 0; si < values.size(); ++si)
+		if (ready[si] && (best == values.size() || std::abs(values[si] - value) < std::abs(values[best] - value)))
+			best = si;
+	if (best == values.size())
+		return false;
+	meshes[best].decode(box, mesh);
+	if (found_value)
+		*found_value = values[best];
+	return true;
+}
+
+/// return the memory used by the extracted meshes in bytes
+size_t mesh_sweep::get_memory_size() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t size = 0;
+	for (const compact_mesh& cm : meshes)
+		size += cm.get_memory_size();
+	return size;
+}
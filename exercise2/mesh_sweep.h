@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "surface_extractor.h"
+
+/** meshes of a family of surfaces that depend on one parameter, extracted at sampled
+    parameter values in a background thread. Each sample provides its own function, such
+    that the thread never touches functions used elsewhere. Samples are processed from
+    coarse to fine, the end points first followed by the midpoints of the sampled
+    interval and so on, such that the parameter range is covered early. The meshes are
+    stored with positions quantized to 16 bits per coordinate within the sampling box and
+    normals in 16 bit octahedral coordinates. */
+class mesh_sweep
+{
+public:
+	/// type of the sampling box
+	typedef surface_extractor::box_type box_type;
+	/// type of the implicit function
+	typedef surface_extractor::function_type function_type;
+	/// quantized mesh
+	struct compact_mesh
+	{
+		/// positions as three 16 bit fractions of the box extent per vertex
+		std::vector<uint16_t> positions;
+		/// normals as two 16 bit octahedral coordinates per vertex, empty for meshes without normals
+		std::vector<int16_t> normals;
+		/// three vertex indices per triangle
+		std::vector<uint32_t> triangles;
+		/// quantize mesh within box
+		void encode(const extracted_mesh& mesh, const box_type& box);
+		/// reconstruct the mesh within box
+		void decode(const box_type& box, extracted_mesh& mesh) const;
+		/// return the memory used in bytes
+		size_t get_memory_size() const;
+	};
+protected:
+	/// extractor used by the background thread
+	surface_extractor extractor;
+	/// sampling box and resolution
+	box_type box;
+	unsigned res;
+	/// parameter values and the functions to be extracted for them
+	std::vector<double> values;
+	std::vector<const function_type*> functions;
+	/// meshes of the samples, valid for samples whose ready flag is set
+	std::vector<compact_mesh> meshes;
+	std::vector<char> ready;
+	/// protects meshes and ready flags
+	mutable std::mutex mutex;
+	/// number of extracted samples
+	std::atomic<unsigned> nr_ready;
+	/// set to stop the background thread, which is also checked by the extractor between slabs and refinement rounds
+	std::atomic<bool> cancelled;
+	/// background thread extracting the samples
+	std::thread worker;
+	/// extract all samples in coarse to fine order
+	void run();
+public:
+	/// construct without samples
+	mesh_sweep();
+	/// stop the background thread
+	~mesh_sweep();
+	/// start extracting the functions at the given parameter values with a copy of the configured extractor in the background; the functions need to stay valid until the sweep is cancelled or cleared
+	void start(const surface_extractor& configured_extractor, const box_type& _box, unsigned _res, const std::vector<double>& _values, const std::vector<const function_type*>& _functions);
+	/// stop the background thread and wait for it
+	void cancel();
+	/// stop the background thread and remove all samples
+	void clear();
+	/// return the number of samples
+	size_t get_nr_samples() const { return values.size(); }
+	/// return the number of extracted samples
+	unsigned get_nr_ready() const { return nr_ready; }
+	/// decode the extracted mesh whose parameter value is closest to value and return its parameter value in found_value; returns false if no sample is extracted yet
+	bool get_nearest(double value, extracted_mesh& mesh, double* found_value = 0) const;
+	/// return the memory used by the extracted meshes in bytes
+	size_t get_memory_size() const;
+};
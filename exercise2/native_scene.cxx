@@ -0,0 +1,323 @@
+#include "native_scene.h"
+#include "parallel_for.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+/// C++ counterparts of the GLSL types and functions used by the translations of the nodes
+const char* prelude =
+	"#include <cmath>\n"
+	"#include <cstddef>\n"
+	"namespace {\n"
+	"struct vec3\n"
+	"{\n"
+	"\tdouble x, y, z;\n"
+	"\tvec3(double _x, double _y, double _z) : x(_x), y(_y), z(_z) {}\n"
+	"};\n"
+	"inline vec3 operator + (const vec3& a, const vec3& b) { return vec3(a.x + b.x, a.y + b.y, a.z + b.z); }\n"
+	"inline vec3 operator - (const vec3& a, const vec3& b) { return vec3(a.x - b.x, a.y - b.y, a.z - b.z); }\n"
+	"inline vec3 operator - (const vec3& a) { return vec3(-a.x, -a.y, -a.z); }\n"
+	"inline vec3 operator * (const vec3& a, const vec3& b) { return vec3(a.x*b.x, a.y*b.y, a.z*b.z); }\n"
+	"inline vec3 operator * (double s, const vec3& a) { return vec3(s*a.x, s*a.y, s*a.z); }\n"
+	"inline vec3 operator * (const vec3& a, double s) { return vec3(s*a.x, s*a.y, s*a.z); }\n"
+	"inline double dot(const vec3& a, const vec3& b) { return a.x*b.x + a.y*b.y + a.z*b.z; }\n"
+	"inline double length(const vec3& a) { return std::sqrt(dot(a, a)); }\n"
+	"inline vec3 cross(const vec3& a, const vec3& b) { return vec3(a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x); }\n"
+	"inline double min(double a, double b) { return a < b ? a : b; }\n"
+	"inline double max(double a, double b) { return a > b ? a : b; }\n"
+	"inline double clamp(double x, double a, double b) { return min(max(x, a), b); }\n"
+	"using std::abs;\n"
+	"using std::sqrt;\n"
+	"using std::cos;\n"
+	"using std::sin;\n"
+	"inline vec3 rotate_around_axis(const vec3& p, const vec3& axis, double angle)\n"
+	"{\n"
+	"\tvec3 a = dot(p, axis)*axis;\n"
+	"\tvec3 x = p - a;\n"
+	"\treturn a + cos(angle)*x + sin(angle)*cross(axis, x);\n"
+	"}\n"
+	"}\n";
+
+/// return a 64 bit FNV-1a hash of text, which names the shared objects
+uint64_t compute_hash(const std::string& text)
+{
+	uint64_t h = 14695981039346656037ull;
+	for (unsigned char c : text) {
+		h ^= c;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+#ifndef _WIN32
+/// return whether path is an entry of the given file type owned by the user, which has none of the forbidden mode bits and is no symbolic link
+bool is_private(const std::string& path, mode_t type, mode_t forbidden)
+{
+	struct stat st;
+	return lstat(path.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == type && st.st_uid == getuid() && (st.st_mode & forbidden) == 0;
+}
+
+/// create a new file from the template path ending in XXXXXX, which is replaced by the unique name, and return its descriptor or -1
+int create_unique_file(std::string& path)
+{
+	std::vector<char> name(path.begin(), path.end());
+	name.push_back(0);
+	int fd = mkstemp(&name.front());
+	if (fd >= 0)
+		path = &name.front();
+	return fd;
+}
+
+/// write all of text to the file descriptor fd
+bool write_all(int fd, const std::string& text)
+{
+	size_t written = 0;
+	while (written < text.size()) {
+		ssize_t n = write(fd, text.data() + written, text.size() - written);
+		if (n < 0 && errno != EINTR)
+			return false;
+		if (n > 0)
+			written += size_t(n);
+	}
+	return true;
+}
+
+/// split text at whitespace and append the parts to args
+void split_arguments(const std::string& text, std::vector<std::string>& args)
+{
+	std::istringstream is(text);
+	std::string arg;
+	while (is >> arg)
+		args.push_back(arg);
+}
+
+/// run the program args[0] found in the search path with the arguments args and return whether it exited with status 0
+bool run_program(const std::vector<std::string>& args)
+{
+	if (args.empty())
+		return false;
+	// the argument vector is built before forking, as the child may only call exec
+	std::vector<char*> argv;
+	for (const std::string& arg : args)
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	argv.push_back(0);
+	pid_t pid = fork();
+	if (pid < 0)
+		return false;
+	if (pid == 0) {
+		execvp(argv[0], &argv.front());
+		_exit(127);
+	}
+	int status;
+	while (waitpid(pid, &status, 0) < 0)
+		if (errno != EINTR)
+			return false;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+#endif
+
+/// return a double literal that reproduces value exactly
+std::string exact_literal(double value)
+{
+	if (std::isinf(value))
+		return value > 0 ? "HUGE_VAL" : "-HUGE_VAL";
+	std::ostringstream os;
+	os.precision(17);
+	os << value;
+	return os.str();
+}
+
+}
+
+/// construct unloaded with the default compiler and the user's cache directory
+native_scene::native_scene() : bake_parameters(false), handle(0), evaluate_ptr(0), evaluate_batch_ptr(0)
+{
+	const char* cxx = getenv("CXX");
+	compiler = cxx ? cxx : "c++";
+	flags = "-O3 -march=native -std=c++11 -shared -fPIC";
+	// shared directories such as /tmp would let other users plant objects that are loaded
+	const char* cache = getenv("XDG_CACHE_HOME");
+	const char* home = getenv("HOME");
+	if (cache && *cache)
+		directory = std::string(cache) + "/cg2_native_scenes";
+	else if (home && *home)
+		directory = std::string(home) + "/.cache/cg2_native_scenes";
+}
+
+/// unload on destruction
+native_scene::~native_scene()
+{
+	unload();
+}
+
+/// return the C++ source of the translation with the expression result
+std::string native_scene::generate_source(const glsl_generator& g, const std::string& result) const
+{
+	std::ostringstream os;
+	os << prelude
+	   << "extern \"C\" void evaluate_batch(const double* const* param, const double* ps, double* vs, size_t n)\n"
+	   << "{\n";
+	// the parameters are loaded once per batch
+	const std::vector<glsl_generator::uniform_binding>& uniforms = g.get_uniforms();
+	for (size_t i = 0; i < uniforms.size(); ++i) {
+		const glsl_generator::uniform_binding& u = uniforms[i];
+		if (u.nr_components == 1)
+			os << "\tconst double " << u.name << " = " << (bake_parameters ? exact_literal(u.values[0]) : "*param[" + std::to_string(i) + "]") << ";\n";
+		else {
+			os << "\tconst vec3 " << u.name << "(";
+			for (unsigned c = 0; c < 3; ++c)
+				os << (c > 0 ? ", " : "") << (bake_parameters ? exact_literal(u.values[c]) : "param[" + std::to_string(i) + "][" + std::to_string(c) + "]");
+			os << ");\n";
+		}
+	}
+	os << "\tfor (size_t i = 0; i < n; ++i) {\n"
+	   << "\t\tconst vec3 " << glsl_generator::get_point_name() << "(ps[3*i], ps[3*i+1], ps[3*i+2]);\n";
+	for (const glsl_generator::statement& s : g.get_statements())
+		os << "\t\t" << (s.type == "float" ? "double" : s.type) << " " << s.name << " = " << s.expression << ";\n";
+	os << "\t\tvs[i] = " << result << ";\n"
+	   << "\t}\n"
+	   << "}\n"
+	   << "extern \"C\" double evaluate(const double* const* param, const double* p)\n"
+	   << "{\n"
+	   << "\tdouble v;\n"
+	   << "\tevaluate_batch(param, p, &v, 1);\n"
+	   << "\treturn v;\n"
+	   << "}\n";
+	return os.str();
+}
+
+/// create the directory if missing and return whether it is owned by the user and inaccessible to others
+bool native_scene::prepare_directory() const
+{
+#ifdef _WIN32
+	return false;
+#else
+	if (directory.empty())
+		return false;
+	// the parent of the default directory may be missing as well
+	size_t slash = directory.find_last_of('/');
+	if (slash != std::string::npos && slash > 0)
+		mkdir(directory.substr(0, slash).c_str(), 0700);
+	if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST)
+		return false;
+	return is_private(directory, S_IFDIR, S_IRWXG | S_IRWXO);
+#endif
+}
+
+/// compile source into the shared object library and return whether this succeeded
+bool native_scene::compile(const std::string& source, const std::string& library) const
+{
+#ifdef _WIN32
+	return false;
+#else
+	// source and object get fresh names, such that no existing file is followed or overwritten
+	std::string source_file = directory + "/scene_XXXXXX";
+	int fd = create_unique_file(source_file);
+	if (fd < 0)
+		return false;
+	bool written = write_all(fd, source);
+	close(fd);
+	// the object becomes visible under its final name only once it is complete, as other processes may share the directory
+	std::string temporary = directory + "/scene_XXXXXX";
+	fd = written ? create_unique_file(temporary) : -1;
+	if (fd < 0) {
+		std::remove(source_file.c_str());
+		return false;
+	}
+	close(fd);
+	std::vector<std::string> args;
+	split_arguments(compiler, args);
+	split_arguments(flags, args);
+	args.push_back("-o");
+	args.push_back(temporary);
+	// the source has no extension from which the language could be told
+	args.push_back("-x");
+	args.push_back("c++");
+	args.push_back(source_file);
+	bool success = run_program(args) && chmod(temporary.c_str(), 0700) == 0 && std::rename(temporary.c_str(), library.c_str()) == 0;
+	std::remove(source_file.c_str());
+	if (!success)
+		std::remove(temporary.c_str());
+	return success;
+#endif
+}
+
+/// compile the translation with the expression result unless it is cached and load it; returns false if no native code is available
+bool native_scene::build(const glsl_generator& g, const std::string& result)
+{
+	unload();
+#ifdef _WIN32
+	return false;
+#else
+	if (!prepare_directory()) {
+		std::cerr << "[NATIVE] " << directory << " is no directory of the user that is inaccessible to others" << std::endl;
+		return false;
+	}
+	std::string source = generate_source(g, result);
+	std::ostringstream os;
+	os << directory << "/scene_" << std::hex << compute_hash(compiler + " " + flags + "\n" + source) << ".so";
+	std::string library = os.str();
+	if (access(library.c_str(), F_OK) != 0 && !compile(source, library))
+		return false;
+	// loading runs code of the object, so it has to belong to the user and nobody else may have modified it
+	if (!is_private(library, S_IFREG, S_IWGRP | S_IWOTH)) {
+		std::cerr << "[NATIVE] " << library << " is not loaded, as it is no file of the user or others may write it" << std::endl;
+		return false;
+	}
+	void* h = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!h)
+		return false;
+	evaluate_ptr = (evaluate_func)dlsym(h, "evaluate");
+	evaluate_batch_ptr = (evaluate_batch_func)dlsym(h, "evaluate_batch");
+	if (!evaluate_ptr || !evaluate_batch_ptr) {
+		dlclose(h);
+		evaluate_ptr = 0;
+		evaluate_batch_ptr = 0;
+		return false;
+	}
+	handle = h;
+	for (const glsl_generator::uniform_binding& u : g.get_uniforms())
+		parameters.push_back(u.values);
+	return true;
+#endif
+}
+
+/// unload the shared object, which has to be done before the members bound in the parameter block are destructed
+void native_scene::unload()
+{
+#ifndef _WIN32
+	if (handle)
+		dlclose(handle);
+#endif
+	handle = 0;
+	evaluate_ptr = 0;
+	evaluate_batch_ptr = 0;
+	parameters.clear();
+}
+
+/// evaluate a batch of points distributed over all hardware threads
+void native_scene::evaluate_batch(const std::vector<pnt_type>& ps, std::vector<double>& vs) const
+{
+	static_assert(sizeof(pnt_type) == 3 * sizeof(double), "points are passed to the native code as consecutive coordinates");
+	const int block_size = 1024;
+	vs.resize(ps.size());
+	const double* const* param = parameters.empty() ? 0 : &parameters.front();
+	parallel_for(0, int((ps.size() + block_size - 1) / block_size), [&](int b) {
+		size_t begin = size_t(b)*block_size;
+		size_t end = std::min(ps.size(), begin + block_size);
+		evaluate_batch_ptr(param, &ps[begin](0), &vs[begin], end - begin);
+	});
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cgv/math/fvec.h>
+#include "glsl_generator.h"
+
+/** evaluates the translation of a scene tree collected by a glsl_generator as native
+    code. The statements are emitted as C++, where a small vec3 type provides the GLSL
+    functions used by the nodes, compiled with the system compiler into a shared object
+    and loaded with dlopen. The object exports
+      double evaluate(const double* const* param, const double* p) and
+      void evaluate_batch(const double* const* param, const double* ps, double* vs, size_t n),
+    where param is the parameter block with one pointer to the bound members per uniform,
+    such that parameter changes need no recompilation. Alternatively the parameters are
+    baked into the code as constants, which lets the compiler fold them but needs a new
+    object per parameter set. Objects are named by a hash of their source and the compile
+    command and are reused from the directory if they exist. As loading an object runs its
+    code, the directory has to be owned by the user and inaccessible to others, and only
+    objects owned by the user that nobody else can write are loaded. The compiler is run
+    directly without a shell, with the compiler and flags split at whitespace. If no
+    compiler is available or the platform does not support loading, build fails and the
+    caller keeps using the virtual evaluation of the scene tree. */
+class native_scene
+{
+public:
+	/// type of 3d points
+	typedef cgv::math::fvec<double, 3> pnt_type;
+	/// compiler executable, taken from the CXX environment variable if set
+	std::string compiler;
+	/// flags of the compiler that build a shared object
+	std::string flags;
+	/// private directory of the generated sources and shared objects, created with mode 0700 if missing
+	std::string directory;
+	/// whether parameters are compiled as constants instead of being read through the parameter block
+	bool bake_parameters;
+protected:
+	/// exported evaluation of a single point
+	typedef double (*evaluate_func)(const double* const*, const double*);
+	/// exported evaluation of n consecutive points
+	typedef void (*evaluate_batch_func)(const double* const*, const double*, double*, size_t);
+	/// handle of the loaded shared object or 0
+	void* handle;
+	/// exported functions of the loaded object
+	evaluate_func evaluate_ptr;
+	evaluate_batch_func evaluate_batch_ptr;
+	/// parameter block
+	std::vector<const double*> parameters;
+	/// return the C++ source of the translation with the expression result
+	std::string generate_source(const glsl_generator& g, const std::string& result) const;
+	/// create the directory if missing and return whether it is owned by the user and inaccessible to others
+	bool prepare_directory() const;
+	/// compile source into the shared object library and return whether this succeeded
+	bool compile(const std::string& source, const std::string& library) const;
+public:
+	/// construct unloaded with the default compiler and the user's cache directory
+	native_scene();
+	/// unload on destruction
+	~native_scene();
+	/// compile the translation with the expression result unless it is cached and load it; returns false if no native code is available
+	bool build(const glsl_generator& g, const std::string& result);
+	/// unload the shared object, which has to be done before the members bound in the parameter block are destructed
+	void unload();
+	/// return whether a shared object is loaded
+	bool is_loaded() const { return handle != 0; }
+	/// evaluate at p
+	double evaluate(const pnt_type& p) const { return evaluate_ptr(parameters.empty() ? 0 : &parameters.front(), &p(0)); }
+	/// evaluate a batch of points distributed over all hardware threads
+	void evaluate_batch(const std::vector<pnt_type>& ps, std::vector<double>& vs) const;
+};
@@ -8,6 +8,7 @@ class numeric_gradient : public implicit_group<T>
 public:
 	typedef typename implicit_base<T>::vec_type vec_type;
 	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::clr_type clr_type;
 
 protected:
 	/// store the numeric_gradient
@@ -47,6 +48,21 @@ public:
 		}
 		return implicit_group<T>::get_implicit_child(0)->evaluate_gradient(p);
 	}
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const {
+		if (group::get_nr_children() == 0) {
+			clr = implicit_base<T>::color;
+			return 1;
+		}
+		T value = implicit_group<T>::get_implicit_child(0)->evaluate_and_color(p, clr);
+		clr = implicit_group<T>::select_color(0, clr, p);
+		return value;
+	}
+	/// the numerical gradient does not change the function value
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const {
+		if (group::get_nr_children() == 0)
+			return glsl_generator::literal(1);
+		return implicit_group<T>::get_implicit_child(0)->generate_glsl(g, p);
+	}
 	void create_gui()
 	{
 		provider::add_member_control(this, "epsilon", epsilon, "value_slider", "min=0.000000001;max=0.1;step=0.000000001;ticks=true;log=true");
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// return the number of worker threads used by parallel_for
+inline unsigned get_nr_worker_threads()
+{
+	unsigned n = std::thread::hardware_concurrency();
+	return n == 0 ? 1 : n;
+}
+
+/** call f(i) for all i in [begin, end) and distribute the indices dynamically over
+    nr_threads worker threads (0 selects one thread per hardware thread). The calling
+    thread takes part in the work and the function returns after all calls finished. */
+template <typename F>
+void parallel_for(int begin, int end, const F& f, unsigned nr_threads = 0)
+{
+	if (end <= begin)
+		return;
+	if (nr_threads == 0)
+		nr_threads = get_nr_worker_threads();
+	nr_threads = std::min(nr_threads, unsigned(end - begin));
+	if (nr_threads <= 1) {
+		for (int i = begin; i < end; ++i)
+			f(i);
+		return;
+	}
+	std::atomic<int> next(begin);
+	auto work = [&]() {
+		for (int i = next++; i < end; i = next++)
+			f(i);
+	};
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < nr_threads; ++t)
+		threads.push_back(std::thread(work));
+	work();
+	for (auto& t : threads)
+		t.join();
+}
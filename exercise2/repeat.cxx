@@ -0,0 +1,3 @@
+#include "repeat.h"
+
+scene_factory_registration<repeat_node<double> > sfr_repeat("repeat");
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <cgv/math/fvec.h>
+#include "implicit_group.h"
+
+/** repeats its child along the coordinate axes with the period given by delta. The query
+    point is folded into a single cell by modular arithmetic, such that the child is
+    evaluated only once independent of the number of copies. A positive count restricts
+    the repetition along an axis to that many copies centered around the origin, zero
+    repeats infinitely and a non positive period disables repetition along the axis. If
+    the child reaches beyond half a period, neighbors can be enabled to take the minimum
+    over the adjacent cells as well. */
+template <typename T>
+struct repeat_node : public implicit_group<T>
+{
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::clr_type clr_type;
+
+	/// period along each axis
+	vec_type delta;
+	/// number of copies along each axis or 0 for infinite repetition
+	int count[3];
+	/// whether to evaluate the adjacent cells as well
+	bool neighbors;
+
+	repeat_node() : delta(1, 1, 1), neighbors(false)
+	{
+		count[0] = count[1] = count[2] = 0;
+		implicit_base<T>::gui_color = 0x88FF88;
+	}
+	std::string get_type_name() const { return "repeat"; }
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("dx", delta(0)) &&
+			rh.reflect_member("dy", delta(1)) &&
+			rh.reflect_member("dz", delta(2)) &&
+			rh.reflect_member("nx", count[0]) &&
+			rh.reflect_member("ny", count[1]) &&
+			rh.reflect_member("nz", count[2]) &&
+			rh.reflect_member("neighbors", neighbors) &&
+			implicit_group<T>::self_reflect(rh);
+	}
+	void on_set(void* member_ptr)
+	{
+		for (int c = 0; c < 3; ++c)
+			if (member_ptr == &count[c] && count[c] < 0)
+				count[c] = 0;
+		implicit_group<T>::on_set(member_ptr);
+	}
+	/// return the index of the cell closest to coordinate x along axis c clamped to the copies
+	int get_cell(T x, int c) const
+	{
+		if (delta(c) <= 0)
+			return 0;
+		T offset = count[c] > 0 ? T(0.5)*(count[c] - 1) : 0;
+		int cell = int(floor(x / delta(c) + offset + T(0.5)));
+		if (count[c] > 0)
+			cell = std::max(0, std::min(count[c] - 1, cell));
+		return cell;
+	}
+	/// return the location of x in the local coordinates of the given cell along axis c
+	T to_cell(T x, int cell, int c) const
+	{
+		if (delta(c) <= 0)
+			return x;
+		T offset = count[c] > 0 ? T(0.5)*(count[c] - 1) : 0;
+		return x - (cell - offset)*delta(c);
+	}
+	/// return whether cell is a valid copy along axis c
+	bool is_valid_cell(int cell, int c) const
+	{
+		if (delta(c) <= 0)
+			return cell == 0;
+		return count[c] == 0 || (cell >= 0 && cell < count[c]);
+	}
+	/// fold p into the local coordinates of the closest cell
+	pnt_type fold(const pnt_type& p) const
+	{
+		return pnt_type(to_cell(p(0), get_cell(p(0), 0), 0), to_cell(p(1), get_cell(p(1), 1), 1), to_cell(p(2), get_cell(p(2), 2), 2));
+	}
+	/// evaluate the child in the closest cell, or the minimum over the adjacent cells if neighbors is enabled, and return the local query point
+	T eval_and_get_point(const pnt_type& p, pnt_type& q) const
+	{
+		const implicit_base<T>* child_ptr = implicit_group<T>::get_implicit_child(0);
+		if (!neighbors) {
+			q = fold(p);
+			return child_ptr->evaluate(q);
+		}
+		int cell[3];
+		for (int c = 0; c < 3; ++c)
+			cell[c] = get_cell(p(c), c);
+		T best = std::numeric_limits<T>::infinity();
+		for (int k = cell[2] - 1; k <= cell[2] + 1; ++k) {
+			if (!is_valid_cell(k, 2))
+				continue;
+			for (int j = cell[1] - 1; j <= cell[1] + 1; ++j) {
+				if (!is_valid_cell(j, 1))
+					continue;
+				for (int i = cell[0] - 1; i <= cell[0] + 1; ++i) {
+					if (!is_valid_cell(i, 0))
+						continue;
+					pnt_type r(to_cell(p(0), i, 0), to_cell(p(1), j, 1), to_cell(p(2), k, 2));
+					T v = child_ptr->evaluate(r);
+					if (v < best) {
+						best = v;
+						q = r;
+					}
+				}
+			}
+		}
+		return best;
+	}
+	T evaluate(const pnt_type& p) const
+	{
+		if (group::get_nr_children() == 0)
+			return 1;
+		pnt_type q;
+		return eval_and_get_point(p, q);
+	}
+	/// folding is a translation per cell, such that the gradient is the child gradient in the deciding cell
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		if (group::get_nr_children() == 0)
+			return vec_type(0, 0, 0);
+		pnt_type q = fold(p);
+		if (neighbors)
+			eval_and_get_point(p, q);
+		return implicit_group<T>::get_implicit_child(0)->evaluate_gradient(q);
+	}
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const
+	{
+		if (group::get_nr_children() == 0) {
+			clr = implicit_base<T>::color;
+			return 1;
+		}
+		pnt_type q = fold(p);
+		if (neighbors)
+			eval_and_get_point(p, q);
+		T value = implicit_group<T>::get_implicit_child(0)->evaluate_and_color(q, clr);
+		clr = implicit_group<T>::select_color(0, clr, q);
+		return value;
+	}
+	/// the child is evaluated in all cells, such that changes of the child cannot be located by a single point
+	bool map_to_children(pnt_type& p) const
+	{
+		return false;
+	}
+	void create_gui()
+	{
+		provider::add_member_control(this, "dx", delta(0), "value_slider", "min=0;max=5;ticks=true");
+		provider::add_member_control(this, "dy", delta(1), "value_slider", "min=0;max=5;ticks=true");
+		provider::add_member_control(this, "dz", delta(2), "value_slider", "min=0;max=5;ticks=true");
+		provider::add_member_control(this, "nx", count[0], "value_slider", "min=0;max=100;log=true;ticks=true");
+		provider::add_member_control(this, "ny", count[1], "value_slider", "min=0;max=100;log=true;ticks=true");
+		provider::add_member_control(this, "nz", count[2], "value_slider", "min=0;max=100;log=true;ticks=true");
+		provider::add_member_control(this, "neighbors", neighbors, "check");
+		implicit_group<T>::create_gui();
+	}
+};
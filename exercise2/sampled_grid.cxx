@@ -0,0 +1,164 @@
+#include "sampled_grid.h"
+#include <cmath>
+#include <algorithm>
+
+/// compute Catmull-Rom weights w and their derivatives dw for samples i-1, i, i+1, i+2 at local coordinate t
+template <typename T>
+static void catmull_rom_weights(T t, T* w, T* dw)
+{
+	T t2 = t*t, t3 = t2*t;
+	w[0] = T(0.5)*(-t3 + 2*t2 - t);
+	w[1] = T(0.5)*(3*t3 - 5*t2 + 2);
+	w[2] = T(0.5)*(-3*t3 + 4*t2 + t);
+	w[3] = T(0.5)*(t3 - t2);
+	dw[0] = T(0.5)*(-3*t2 + 4*t - 1);
+	dw[1] = T(0.5)*(9*t2 - 10*t);
+	dw[2] = T(0.5)*(-9*t2 + 8*t + 1);
+	dw[3] = T(0.5)*(3*t2 - 2*t);
+}
+
+/// construct empty grid
+template <typename T>
+sampled_grid<T>::sampled_grid() : cell_extent(0, 0, 0), inv_cell_extent(0, 0, 0)
+{
+	res[0] = res[1] = res[2] = 0;
+}
+
+/// allocate samples for the given box and per axis resolution, which needs to be at least 2
+template <typename T>
+void sampled_grid<T>::resize(const box_type& _box, unsigned res_x, unsigned res_y, unsigned res_z)
+{
+	box = _box;
+	res[0] = std::max(res_x, 2u);
+	res[1] = std::max(res_y, 2u);
+	res[2] = std::max(res_z, 2u);
+	vec_type e = box.get_extent();
+	for (int c = 0; c < 3; ++c) {
+		cell_extent(c) = e(c) / (res[c] - 1);
+		inv_cell_extent(c) = cell_extent(c) > 0 ? T(1) / cell_extent(c) : T(0);
+	}
+	values.resize(size_t(res[0])*res[1]*res[2]);
+}
+
+/// return the location of a sample
+template <typename T>
+typename sampled_grid<T>::pnt_type sampled_grid<T>::get_location(unsigned i, unsigned j, unsigned k) const
+{
+	const pnt_type& p0 = box.get_min_pnt();
+	return pnt_type(p0(0) + i*cell_extent(0), p0(1) + j*cell_extent(1), p0(2) + k*cell_extent(2));
+}
+
+/// check whether p lies inside the sampled box
+template <typename T>
+bool sampled_grid<T>::contains(const pnt_type& p) const
+{
+	if (empty())
+		return false;
+	for (int c = 0; c < 3; ++c)
+		if (p(c) < box.get_min_pnt()(c) || p(c) > box.get_max_pnt()(c))
+			return false;
+	return true;
+}
+
+/// find cell index and local coordinate in [0,1] of p along axis c
+template <typename T>
+int sampled_grid<T>::locate(const pnt_type& p, int c, T& t) const
+{
+	T u = (p(c) - box.get_min_pnt()(c))*inv_cell_extent(c);
+	T u_max = T(res[c] - 1);
+	if (u < 0)
+		u = 0;
+	else if (u > u_max)
+		u = u_max;
+	int i = std::min(int(u), int(res[c]) - 2);
+	t = u - i;
+	return i;
+}
+
+/// interpolate the samples at p, which is clamped to the box
+template <typename T>
+T sampled_grid<T>::interpolate(const pnt_type& p, bool tricubic) const
+{
+	T t[3];
+	int i = locate(p, 0, t[0]), j = locate(p, 1, t[1]), k = locate(p, 2, t[2]);
+	if (!tricubic) {
+		T v = 0;
+		for (int dk = 0; dk < 2; ++dk) {
+			T wk = dk ? t[2] : 1 - t[2];
+			for (int dj = 0; dj < 2; ++dj) {
+				T wjk = wk * (dj ? t[1] : 1 - t[1]);
+				v += wjk * ((1 - t[0])*get_value(i, j + dj, k + dk) + t[0]*get_value(i + 1, j + dj, k + dk));
+			}
+		}
+		return v;
+	}
+	T w[3][4], dw[3][4];
+	for (int c = 0; c < 3; ++c)
+		catmull_rom_weights(t[c], w[c], dw[c]);
+	T v = 0;
+	for (int dk = 0; dk < 4; ++dk) {
+		unsigned kk = unsigned(std::min(std::max(k + dk - 1, 0), int(res[2]) - 1));
+		for (int dj = 0; dj < 4; ++dj) {
+			unsigned jj = unsigned(std::min(std::max(j + dj - 1, 0), int(res[1]) - 1));
+			T wjk = w[2][dk] * w[1][dj];
+			for (int di = 0; di < 4; ++di) {
+				unsigned ii = unsigned(std::min(std::max(i + di - 1, 0), int(res[0]) - 1));
+				v += wjk * w[0][di] * get_value(ii, jj, kk);
+			}
+		}
+	}
+	// the Catmull-Rom spline overshoots next to steep changes, which could move the zero level set or invalidate Lipschitz bounds
+	T v_min = get_value(i, j, k), v_max = v_min;
+	for (int c = 1; c < 8; ++c) {
+		T vc = get_value(i + (c & 1), j + ((c >> 1) & 1), k + ((c >> 2) & 1));
+		v_min = std::min(v_min, vc);
+		v_max = std::max(v_max, vc);
+	}
+	return std::min(std::max(v, v_min), v_max);
+}
+
+/// compute the gradient of the interpolant at p, which is clamped to the box
+template <typename T>
+typename sampled_grid<T>::vec_type sampled_grid<T>::interpolate_gradient(const pnt_type& p, bool tricubic) const
+{
+	T t[3];
+	int i = locate(p, 0, t[0]), j = locate(p, 1, t[1]), k = locate(p, 2, t[2]);
+	vec_type g(0, 0, 0);
+	if (!tricubic) {
+		for (int dk = 0; dk < 2; ++dk) {
+			T wk = dk ? t[2] : 1 - t[2];
+			T sk = dk ? T(1) : T(-1);
+			for (int dj = 0; dj < 2; ++dj) {
+				T wj = dj ? t[1] : 1 - t[1];
+				T sj = dj ? T(1) : T(-1);
+				T v0 = get_value(i, j + dj, k + dk), v1 = get_value(i + 1, j + dj, k + dk);
+				T vx = (1 - t[0])*v0 + t[0]*v1;
+				g(0) += wj*wk*(v1 - v0);
+				g(1) += sj*wk*vx;
+				g(2) += wj*sk*vx;
+			}
+		}
+	}
+	else {
+		T w[3][4], dw[3][4];
+		for (int c = 0; c < 3; ++c)
+			catmull_rom_weights(t[c], w[c], dw[c]);
+		for (int dk = 0; dk < 4; ++dk) {
+			unsigned kk = unsigned(std::min(std::max(k + dk - 1, 0), int(res[2]) - 1));
+			for (int dj = 0; dj < 4; ++dj) {
+				unsigned jj = unsigned(std::min(std::max(j + dj - 1, 0), int(res[1]) - 1));
+				for (int di = 0; di < 4; ++di) {
+					unsigned ii = unsigned(std::min(std::max(i + di - 1, 0), int(res[0]) - 1));
+					T v = get_value(ii, jj, kk);
+					g(0) += dw[0][di] * w[1][dj] * w[2][dk] * v;
+					g(1) += w[0][di] * dw[1][dj] * w[2][dk] * v;
+					g(2) += w[0][di] * w[1][dj] * dw[2][dk] * v;
+				}
+			}
+		}
+	}
+	return vec_type(g(0)*inv_cell_extent(0), g(1)*inv_cell_extent(1), g(2)*inv_cell_extent(2));
+}
+
+template class sampled_grid<double>;
+template class sampled_grid<float>;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <cgv/math/fvec.h>
+#include <cgv/media/axis_aligned_box.h>
+#include "parallel_for.h"
+
+/** regular grid of function samples over an axis aligned box. The grid places
+    res samples along each axis such that the first and last sample lie on the box
+    faces. Samples can be interpolated trilinearly or with tricubic Catmull-Rom
+    splines, both together with the analytic gradient of the interpolant. */
+template <typename T>
+class sampled_grid
+{
+public:
+	/// type of 3d point
+	typedef cgv::math::fvec<T, 3> pnt_type;
+	/// type of 3d vector
+	typedef cgv::math::fvec<T, 3> vec_type;
+	/// type of the sampled box
+	typedef cgv::media::axis_aligned_box<T, 3> box_type;
+
+protected:
+	/// sampled box
+	box_type box;
+	/// number of samples along each axis
+	unsigned res[3];
+	/// distance between adjacent samples along each axis and its inverse
+	vec_type cell_extent, inv_cell_extent;
+	/// samples in x-fastest order
+	std::vector<T> values;
+	/// find cell index and local coordinate in [0,1] of p along axis c
+	int locate(const pnt_type& p, int c, T& t) const;
+
+public:
+	/// construct empty grid
+	sampled_grid();
+	/// allocate samples for the given box and per axis resolution, which needs to be at least 2
+	void resize(const box_type& _box, unsigned res_x, unsigned res_y, unsigned res_z);
+	/// return whether no samples are allocated
+	bool empty() const { return values.empty(); }
+	/// return the sampled box
+	const box_type& get_box() const { return box; }
+	/// return the number of samples along axis c
+	unsigned get_resolution(int c) const { return res[c]; }
+	/// return the distance between adjacent samples along each axis
+	const vec_type& get_cell_extent() const { return cell_extent; }
+	/// return the linear index of a sample
+	size_t get_index(unsigned i, unsigned j, unsigned k) const { return i + size_t(res[0])*(j + size_t(res[1])*k); }
+	/// return the location of a sample
+	pnt_type get_location(unsigned i, unsigned j, unsigned k) const;
+	/// read access to a sample
+	T get_value(unsigned i, unsigned j, unsigned k) const { return values[get_index(i, j, k)]; }
+	/// write access to a sample
+	T& ref_value(unsigned i, unsigned j, unsigned k) { return values[get_index(i, j, k)]; }
+	/// access to all samples in x-fastest order
+	const std::vector<T>& get_values() const { return values; }
+	/// return the memory occupied by the samples in bytes
+	size_t get_memory_size() const { return values.size()*sizeof(T); }
+	/// check whether p lies inside the sampled box
+	bool contains(const pnt_type& p) const;
+	/// set all samples of slice k to f(location), where f is any callable taking a pnt_type
+	template <typename F>
+	void sample_slice(unsigned k, const F& f)
+	{
+		for (unsigned j = 0; j < res[1]; ++j)
+			for (unsigned i = 0; i < res[0]; ++i)
+				ref_value(i, j, k) = f(get_location(i, j, k));
+	}
+	/// sample f on all grid locations distributing the slices over all hardware threads
+	template <typename F>
+	void sample(const F& f)
+	{
+		parallel_for(0, int(res[2]), [&](int k) { sample_slice(unsigned(k), f); });
+	}
+	/// interpolate the samples at p, which is clamped to the box; tricubic values are clamped to the range of the samples at the corners of the cell
+	T interpolate(const pnt_type& p, bool tricubic = false) const;
+	/// compute the gradient of the interpolant at p, which is clamped to the box
+	vec_type interpolate_gradient(const pnt_type& p, bool tricubic = false) const;
+};
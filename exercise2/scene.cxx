@@ -1,5 +1,6 @@
 #include "scene.h"
 #include "implicit_group.h"
+#include "parallel_for.h"
 #include <cgv/signal/rebind.h>
 #include <cgv/base/group.h>
 #include <cgv/gui/gui_driver.h>
@@ -9,6 +10,14 @@
 #include <cgv/math/qem.h>
 #include <cgv/base/register.h>
 #include <cgv/utils/convert_string.h>
+#include <cgv/utils/stopwatch.h>
+#include <cgv/utils/file.h>
+#include <cgv/gui/file_dialog.h>
+#include <cgv/gui/trigger.h>
+#include <cgv/type/info/type_name.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 
 using namespace cgv::media::font;
 
@@ -225,6 +234,19 @@ scene::scene(const std::string& _description)
 
 	disable_update = false;
 	help_shown = false;
+	nr_turntable_frames = 36;
+	use_native = false;
+	animation_time = 0;
+	animation_duration = 1;
+	nr_animation_frames = 25;
+	coherent_extraction = true;
+	sweep_min = 0;
+	sweep_max = 1;
+	nr_sweep_samples = 16;
+	sweep_value = 0;
+	nr_sweep_ready = 0;
+	sweep_exact_pending = false;
+	connect(get_animation_trigger().shoot, this, &scene::timer_event);
 	register_object(impl_draw_ptr);
 	impl_draw_ptr->set_function(this);
 	if (cgv::gui::get_gui_driver())
@@ -256,6 +278,7 @@ void scene::unregister()
 
 void scene::parse_description()
 {
+	clear_sweep();
 	disable_update = true;
 	if (editor) {
 		description = editor->get_text();
@@ -264,12 +287,19 @@ void scene::parse_description()
 	for (unsigned int j=0; j<factories.size(); ++j)
 		factories[j]->init_counter();
 
+	native.unload();
 	if (func_base_ptr) {
 		remove_all_children();
 		func_base_ptr.clear();
 	}
 	unsigned int i=0;
 	func_base_ptr = parse_description_recursive(i, 0);
+	std::string file_stamps;
+	append_file_stamps(func_base_ptr ? func_base_ptr->get_interface<implicit_type>() : 0, file_stamps);
+	impl_draw_ptr->set_function_key(description, file_stamps);
+	impl_draw_ptr->set_lipschitz_bound(get_lipschitz_bound());
+	generate_preview();
+	build_native();
 	post_recreate_gui();
 	post_redraw();
 	if (func_base_ptr) {
@@ -292,15 +322,29 @@ bool scene::symbol_matches_description(unsigned int i, abst_scene_factory* facto
 	}
 	std::vector<cgv::utils::token> tokens;
 	cgv::utils::split_to_tokens(factory->names, tokens, ";,", false);
+	bool found = false;
 	for (unsigned j = 0; j < tokens.size(); ++j) {
 		std::string symbol = to_string(tokens[j]);
 		if (i + symbol.size() <= description.size())
-			if (description.substr(i, symbol.size()) == symbol) {
+			if (description.substr(i, symbol.size()) == symbol && (!found || symbol.size() > offset)) {
 				offset = symbol.size();
-				return true;
+				found = true;
 			}
 	}
-	return false;
+	return found;
+}
+
+int scene::find_factory(unsigned int i, unsigned int& offset) const
+{
+	int best_j = -1;
+	for (unsigned int j=0; j<factories.size(); ++j) {
+		unsigned int o = 0;
+		if (symbol_matches_description(i, factories[j], o) && (best_j == -1 || o > offset)) {
+			best_j = j;
+			offset = o;
+		}
+	}
+	return best_j;
 }
 
 base_ptr scene::parse_description_recursive(unsigned int& i, group* g)
@@ -308,17 +352,11 @@ base_ptr scene::parse_description_recursive(unsigned int& i, group* g)
 	base_ptr bp;
 	std::string group_defs;
 	while (i < (unsigned int)description.size()) {
-		bool used_factory = false;
 		unsigned int offset = 0;
-		for (unsigned int j=0; j<factories.size(); ++j) {
-			if (symbol_matches_description(i, factories[j], offset)) {
-				bp = factories[j]->create_function();
-				bp->get_interface<implicit_type>()->set_update_handler(this);
-				used_factory = true;
-				break;
-			}
-		}
-		if (used_factory) {
+		int j = find_factory(i, offset);
+		if (j != -1) {
+			bp = factories[j]->create_function();
+			bp->get_interface<implicit_type>()->set_update_handler(this);
 			i += offset;
 			group_defs = "";
 			continue;
@@ -384,6 +422,14 @@ void scene::reconstruct_description()
 	if (editor)
 		editor->set_text(d);
 	description = d;
+	std::string file_stamps;
+	append_file_stamps(func_base_ptr ? func_base_ptr->get_interface<implicit_type>() : 0, file_stamps);
+	impl_draw_ptr->set_function_key(description, file_stamps);
+	// the preview reads the changed parameters from its uniforms, only the step size depends on them
+	impl_draw_ptr->set_lipschitz_bound(get_lipschitz_bound());
+	// baked parameters are constants of the native code
+	if (use_native && native.bake_parameters)
+		build_native();
 }
 
 void scene::show_help()
@@ -469,16 +515,10 @@ std::string scene::reconstruct_description_recursive(unsigned int& i, implicit_t
 			func_ptr = 0;
 	}
 	while (i < (unsigned int)description.size()) {
-		bool used_factory = false;
 		unsigned offset = 0;
-		for (unsigned int j=0; j<factories.size(); ++j) {
-			if (symbol_matches_description(i, factories[j], offset)) {
-				bp_ref = factories[j]->create_function();
-				used_factory = true;
-				break;
-			}
-		}
-		if (used_factory) {
+		int j = find_factory(i, offset);
+		if (j != -1) {
+			bp_ref = factories[j]->create_function();
 			i += offset;
 			continue;
 		}
@@ -542,8 +582,11 @@ void scene::update_scene()
 		show_help();
 	}
 	if (!disable_update) {
+		// precomputed meshes belong to the previous state of the scene
+		if (sweep.get_nr_samples() > 0)
+			clear_sweep();
 		reconstruct_description();
-		impl_draw_ptr->post_rebuild();
+		impl_draw_ptr->post_full_rebuild();
 	}
 }
 
@@ -567,6 +610,8 @@ std::string scene::get_type_name() const
 /// cast evaluation to func_base_ptr
 double scene::evaluate(const pnt_type& p) const
 {
+	if (native.is_loaded())
+		return native.evaluate(implicit_base<double>::pnt_type(p.x(), p.y(), p.z()));
 	if (func_base_ptr)
 		return func_base_ptr->get_interface<implicit_type>()->evaluate(
 			implicit_base<double>::pnt_type(p.x(), p.y(), p.z())
@@ -587,10 +632,561 @@ scene::vec_type scene::evaluate_gradient(const pnt_type& p) const
 	return vec_type(0, 0, 0);
 }
 
+/// fused evaluation of function value and surface color with a single traversal of the scene
+double scene::evaluate_and_color(const pnt_type& p, implicit_type::clr_type& clr) const
+{
+	if (func_base_ptr)
+		return func_base_ptr->get_interface<implicit_type>()->evaluate_and_color(
+			implicit_base<double>::pnt_type(p.x(), p.y(), p.z()), clr
+		);
+	clr = implicit_type::clr_type(0.5f, 0.5f, 0.5f, 1.0f);
+	return 0;
+}
+
+/// evaluate a batch of points with the batch interface of func_base_ptr
+void scene::evaluate_batch(const std::vector<implicit_type::pnt_type>& ps, std::vector<double>& vs) const
+{
+	if (native.is_loaded())
+		native.evaluate_batch(ps, vs);
+	else if (func_base_ptr)
+		func_base_ptr->get_interface<implicit_type>()->evaluate_batch(ps, vs);
+	else
+		vs.assign(ps.size(), 0.0);
+}
+
+/// evaluate values and surface colors of extracted vertices with the fused evaluation of value and color
+void scene::evaluate_batch_and_colors(const std::vector<implicit_type::pnt_type>& ps, std::vector<double>& vs, std::vector<cgv::math::fvec<float, 3> >& clrs) const
+{
+	vs.resize(ps.size());
+	clrs.resize(ps.size());
+	if (!func_base_ptr) {
+		vs.assign(ps.size(), 0.0);
+		clrs.assign(ps.size(), cgv::math::fvec<float, 3>(0.5f, 0.5f, 0.5f));
+		return;
+	}
+	const implicit_type* root = func_base_ptr->get_interface<implicit_type>();
+	const int block_size = 256;
+	parallel_for(0, int((ps.size() + block_size - 1) / block_size), [&](int b) {
+		size_t end = std::min(ps.size(), size_t(b + 1)*block_size);
+		implicit_type::clr_type clr;
+		for (size_t i = size_t(b)*block_size; i < end; ++i) {
+			vs[i] = root->evaluate_and_color(ps[i], clr);
+			clrs[i] = cgv::math::fvec<float, 3>(clr[0], clr[1], clr[2]);
+		}
+	});
+}
+
+/// return the Lipschitz bound of func_base_ptr
+double scene::get_lipschitz_bound() const
+{
+	if (func_base_ptr)
+		return func_base_ptr->get_interface<implicit_type>()->get_lipschitz_bound();
+	return 1;
+}
+
+/// evaluate the root node
+double scene_tree_function::evaluate(const pnt_type& p) const
+{
+	return root->get_interface<implicit_base<double> >()->evaluate(implicit_base<double>::pnt_type(p.x(), p.y(), p.z()));
+}
+
+/// evaluate the gradient of the root node
+scene_tree_function::vec_type scene_tree_function::evaluate_gradient(const pnt_type& p) const
+{
+	return root->get_interface<implicit_base<double> >()->evaluate_gradient(implicit_base<double>::pnt_type(p.x(), p.y(), p.z())).to_vec();
+}
+
+/// evaluate a batch of points with the batch interface of the root node
+void scene_tree_function::evaluate_batch(const std::vector<implicit_base<double>::pnt_type>& ps, std::vector<double>& vs) const
+{
+	root->get_interface<implicit_base<double> >()->evaluate_batch(ps, vs);
+}
+
+/// render the scene within the box of the implicit surface drawable to an image file
+void scene::render_image()
+{
+	if (!func_base_ptr)
+		return;
+	std::string fn = file_save_dialog("choose image output file", "Image Files (ppm):*.ppm|All Files:*.*");
+	if (fn.empty())
+		return;
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	tracer.set_box(sphere_tracer<double>::box_type(impl_draw_ptr->box.get_min_pnt(), impl_draw_ptr->box.get_max_pnt()));
+	std::vector<unsigned char> rgb;
+	size_t nr_evaluations = tracer.render(*func_base_ptr->get_interface<implicit_type>(), rgb);
+	time = sw.get_elapsed_time();
+	if (!sphere_tracer<double>::write_ppm(fn, tracer.width, tracer.height, rgb))
+		std::cerr << "could not write " << fn << std::endl;
+	std::cout << "[SPHERE TRACING] Rendered " << tracer.width << "x" << tracer.height << " image with "
+		<< nr_evaluations << " evaluations in " << time << "s." << std::endl;
+}
+
+/** translate the scene tree into GLSL for the ray marched preview of the implicit surface
+    drawable. The translation binds the parameters of the nodes to uniforms and only
+    needs to be regenerated when the structure of the tree changes after parsing. */
+void scene::generate_preview()
+{
+	glsl_generator g;
+	std::string result;
+	if (func_base_ptr)
+		result = func_base_ptr->get_interface<implicit_type>()->generate_glsl(g, glsl_generator::get_point_name());
+	if (result.empty()) {
+		impl_draw_ptr->clear_preview_function();
+		if (func_base_ptr)
+			std::cout << "[PREVIEW] The scene contains nodes without GLSL translation, no preview available" << std::endl;
+		return;
+	}
+	impl_draw_ptr->set_preview_function(g, result);
+}
+
+/** compile the translation of the scene tree into native code. With the parameter block
+    the code is only rebuilt when the structure of the tree changes, while baked parameters
+    need a rebuild after each parameter change, of which unchanged parameter sets are found
+    in the cache of compiled objects. */
+void scene::build_native()
+{
+	native.unload();
+	if (!use_native || !func_base_ptr)
+		return;
+	glsl_generator g;
+	std::string result = func_base_ptr->get_interface<implicit_type>()->generate_glsl(g, glsl_generator::get_point_name());
+	if (result.empty()) {
+		std::cout << "[NATIVE] The scene contains nodes without translation, using virtual evaluation" << std::endl;
+		return;
+	}
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	if (native.build(g, result))
+		std::cout << "[NATIVE] Built scene code with " << g.get_statements().size() << " statements in " << sw.get_elapsed_time() << "s." << std::endl;
+	else
+		std::cout << "[NATIVE] Could not build scene code with " << native.compiler << ", using virtual evaluation" << std::endl;
+}
+
+/// render a turntable of the scene to a sequence of image files
+void scene::render_turntable()
+{
+	if (!func_base_ptr)
+		return;
+	std::string fn = file_save_dialog("choose base name of turntable images", "Image Files (ppm):*.ppm|All Files:*.*");
+	if (fn.empty())
+		return;
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	tracer.set_box(sphere_tracer<double>::box_type(impl_draw_ptr->box.get_min_pnt(), impl_draw_ptr->box.get_max_pnt()));
+	if (!tracer.render_turntable(*func_base_ptr->get_interface<implicit_type>(), cgv::utils::file::drop_extension(fn), nr_turntable_frames))
+		std::cerr << "could not write turntable images to " << fn << std::endl;
+	time = sw.get_elapsed_time();
+	std::cout << "[SPHERE TRACING] Rendered " << nr_turntable_frames << " frames in " << time << "s." << std::endl;
+}
+
+/// append name, size and modification time of the files read by node and its descendants to stamps
+void scene::append_file_stamps(implicit_type* node, std::string& stamps) const
+{
+	if (!node)
+		return;
+	// nodes that read files such as mesh_sdf and volume name them by their file member
+	std::string file_name;
+	if (node->get_base()->get_void("file", "string", &file_name) && !file_name.empty())
+		stamps += file_name + "," + cgv::utils::to_string(cgv::utils::file::size(file_name)) + "," +
+			cgv::utils::to_string(cgv::utils::file::get_last_write_time(file_name)) + ";";
+	group* g = dynamic_cast<group*>(node);
+	if (g)
+		for (unsigned ci = 0; ci < g->get_nr_children(); ++ci)
+			append_file_stamps(g->get_child(ci)->get_interface<implicit_type>(), stamps);
+}
+
+/// find the node with the given name in the subtree of node and collect the nodes from node to it into path
+bool scene::find_node_path(implicit_type* node, const std::string& name, std::vector<implicit_type*>& path) const
+{
+	if (!node)
+		return false;
+	path.push_back(node);
+	cgv::base::named_ptr np = node->get_base()->get_named();
+	if (np && np->get_name() == name)
+		return true;
+	group* g = dynamic_cast<group*>(node);
+	if (g)
+		for (unsigned ci = 0; ci < g->get_nr_children(); ++ci)
+			if (find_node_path(g->get_child(ci)->get_interface<implicit_type>(), name, path))
+				return true;
+	path.pop_back();
+	return false;
+}
+
+/** evaluate each animated node in scene coordinates at the centers of the bricks of 8^3
+    cells of the sampling grid. The points are mapped through the ancestors of the node
+    into its coordinates, which fails below nodes that evaluate their children at several
+    points. The values of all nodes are stored one after the other. */
+bool scene::probe_animated_nodes(std::vector<double>& values) const
+{
+	values.clear();
+	if (!func_base_ptr)
+		return false;
+	const surface_extractor::box_type& box = impl_draw_ptr->box;
+	unsigned res = impl_draw_ptr->get_sampling_resolution();
+	unsigned nr_bricks[3];
+	double brick_extent[3];
+	for (int c = 0; c < 3; ++c) {
+		nr_bricks[c] = std::max(1u, (res - 2) / 8 + 1);
+		brick_extent[c] = 8 * box.get_extent()(c) / (res - 1);
+	}
+	std::vector<std::string> names;
+	for (const animation_track& track : tracks)
+		if (std::find(names.begin(), names.end(), track.node_name) == names.end())
+			names.push_back(track.node_name);
+	for (const std::string& name : names) {
+		std::vector<implicit_type*> path;
+		if (!find_node_path(func_base_ptr->get_interface<implicit_type>(), name, path))
+			return false;
+		for (unsigned k = 0; k < nr_bricks[2]; ++k)
+			for (unsigned j = 0; j < nr_bricks[1]; ++j)
+				for (unsigned i = 0; i < nr_bricks[0]; ++i) {
+					implicit_type::pnt_type p(
+						box.get_min_pnt()(0) + (i + 0.5)*brick_extent[0],
+						box.get_min_pnt()(1) + (j + 0.5)*brick_extent[1],
+						box.get_min_pnt()(2) + (k + 0.5)*brick_extent[2]);
+					for (size_t l = 0; l + 1 < path.size(); ++l)
+						if (!path[l]->map_to_children(p))
+							return false;
+					values.push_back(path.back()->evaluate(p));
+				}
+	}
+	return true;
+}
+
+/** set the animated members to their values at time t and collect the bricks in which the
+    surface may have changed. The function of the scene combines the values of the animated
+    nodes with minima, maxima and negations only, such that its sign and zero set can only
+    change where the sign of an animated node changes. With the Lipschitz bound L of the
+    scene a node keeps its sign along all grid edges of a brick if its absolute value at the
+    brick center exceeds L times the sum of the brick radius and the cell diagonal. Bricks
+    that violate this bound before or after the change are returned, enlarged by half a cell
+    to include their boundary samples. */
+bool scene::apply_animation(double t, std::vector<surface_extractor::box_type>& changed_boxes)
+{
+	changed_boxes.clear();
+	if (!func_base_ptr || tracks.empty())
+		return true;
+	std::vector<double> before, after;
+	double lipschitz_bound = get_lipschitz_bound();
+	bool bounded = probe_animated_nodes(before);
+	disable_update = true;
+	for (const animation_track& track : tracks)
+		if (!set_member_value(func_base_ptr->get_interface<implicit_type>(), track.node_name, track.member_name, track.evaluate(t)))
+			std::cerr << "could not animate " << track.node_name << "." << track.member_name << std::endl;
+	disable_update = false;
+	reconstruct_description();
+	lipschitz_bound = std::max(lipschitz_bound, get_lipschitz_bound());
+	bounded = probe_animated_nodes(after) && bounded;
+	const surface_extractor::box_type& box = impl_draw_ptr->box;
+	if (!bounded) {
+		changed_boxes.push_back(box);
+		return false;
+	}
+	unsigned res = impl_draw_ptr->get_sampling_resolution();
+	unsigned nr_bricks[3];
+	double cell_extent[3], brick_radius = 0, cell_diagonal = 0;
+	for (int c = 0; c < 3; ++c) {
+		nr_bricks[c] = std::max(1u, (res - 2) / 8 + 1);
+		cell_extent[c] = box.get_extent()(c) / (res - 1);
+		brick_radius += 16 * cell_extent[c] * cell_extent[c];
+		cell_diagonal += cell_extent[c] * cell_extent[c];
+	}
+	double bound = lipschitz_bound*(sqrt(brick_radius) + sqrt(cell_diagonal));
+	size_t n = size_t(nr_bricks[0])*nr_bricks[1] * nr_bricks[2];
+	std::vector<char> changed(n, 0);
+	for (size_t l = 0; l < before.size(); ++l)
+		if (!(std::abs(before[l]) > bound) || !(std::abs(after[l]) > bound))
+			changed[l % n] = 1;
+	for (size_t bi = 0; bi < n; ++bi) {
+		if (!changed[bi])
+			continue;
+		size_t b[3] = { bi % nr_bricks[0], (bi / nr_bricks[0]) % nr_bricks[1], bi / (size_t(nr_bricks[0])*nr_bricks[1]) };
+		surface_extractor::pnt_type p0, p1;
+		for (int c = 0; c < 3; ++c) {
+			p0(c) = box.get_min_pnt()(c) + (8 * b[c] - 0.5)*cell_extent[c];
+			p1(c) = box.get_min_pnt()(c) + (8 * b[c] + 8.5)*cell_extent[c];
+		}
+		changed_boxes.push_back(surface_extractor::box_type(p0, p1));
+	}
+	return true;
+}
+
+/// set a member of type double of the node with the given name in the tree below root
+bool scene::set_member_value(implicit_type* root, const std::string& node_name, const std::string& member_name, double value)
+{
+	std::vector<implicit_type*> path;
+	if (!find_node_path(root, node_name, path))
+		return false;
+	return path.back()->get_base()->set_void(member_name, cgv::type::info::type_name<double>::get_name(), &value);
+}
+
+/// store the current value of the selected member as key at the current time
+void scene::set_key()
+{
+	std::vector<implicit_type*> path;
+	if (!func_base_ptr || !find_node_path(func_base_ptr->get_interface<implicit_type>(), key_node_name, path)) {
+		std::cerr << "node " << key_node_name << " not found" << std::endl;
+		return;
+	}
+	double value;
+	if (!path.back()->get_base()->get_void(key_member_name, cgv::type::info::type_name<double>::get_name(), &value)) {
+		std::cerr << "property " << key_member_name << " not found" << std::endl;
+		return;
+	}
+	size_t ti = 0;
+	while (ti < tracks.size() && !(tracks[ti].node_name == key_node_name && tracks[ti].member_name == key_member_name))
+		++ti;
+	if (ti == tracks.size())
+		tracks.push_back(animation_track(key_node_name, key_member_name));
+	tracks[ti].set_key(animation_time, value);
+	std::cout << "[ANIMATION] " << key_node_name << "." << key_member_name << " = " << value << " at time " << animation_time
+		<< ", " << tracks[ti].keys.size() << " keys" << std::endl;
+}
+
+/// remove all tracks
+void scene::clear_tracks()
+{
+	tracks.clear();
+}
+
+/// extract the frames of the animation to obj files, resampling only the changed bricks of each frame in coherent mode
+void scene::extract_sequence()
+{
+	if (!func_base_ptr)
+		return;
+	std::string fn = file_save_dialog("choose base name of frame meshes", "Obj Files (obj):*.obj|All Files:*.*");
+	if (fn.empty())
+		return;
+	std::string file_base = cgv::utils::file::drop_extension(fn);
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	size_t nr_triangles = 0, nr_changed_boxes = 0;
+	std::vector<surface_extractor::box_type> changed_boxes;
+	for (unsigned i = 0; i < nr_animation_frames; ++i) {
+		double t = nr_animation_frames > 1 ? animation_duration*i / (nr_animation_frames - 1) : 0;
+		bool bounded = apply_animation(t, changed_boxes);
+		bool incremental = coherent_extraction && bounded && i > 0;
+		if (incremental)
+			nr_changed_boxes += changed_boxes.size();
+		char suffix[16];
+		snprintf(suffix, sizeof(suffix), "_%03u.obj", i);
+		nr_triangles += impl_draw_ptr->extract_frame(file_base + suffix, incremental ? &changed_boxes : 0);
+	}
+	time = sw.get_elapsed_time();
+	// return to the current time, which the drawable extracts from scratch as its samples belong to an earlier state
+	apply_animation(animation_time, changed_boxes);
+	impl_draw_ptr->post_full_rebuild();
+	std::cout << "[ANIMATION] Extracted " << nr_animation_frames << " frames with " << nr_triangles << " triangles in " << time << "s";
+	if (coherent_extraction)
+		std::cout << ", resampled " << nr_changed_boxes << " changed bricks";
+	std::cout << "." << std::endl;
+}
+
+/// parse the scene description into a tree that is not attached to the scene
+base_ptr scene::parse_detached_copy()
+{
+	// restarting the counters reproduces the node names of the scene
+	for (unsigned int j = 0; j < factories.size(); ++j)
+		factories[j]->init_counter();
+	disable_update = true;
+	unsigned int i = 0;
+	base_ptr bp = parse_description_recursive(i, 0);
+	if (bp)
+		bp->get_interface<implicit_type>()->set_update_handler(0);
+	disable_update = false;
+	return bp;
+}
+
+/// return the node of the tree copy that has the position of node in the tree of live
+static base_ptr find_corresponding_node(const base_ptr& live, const base_ptr& copy, const base_ptr& node)
+{
+	if (live == node)
+		return copy;
+	group* live_group = live->get_interface<group>();
+	group* copy_group = copy->get_interface<group>();
+	if (!live_group || !copy_group)
+		return base_ptr();
+	for (unsigned i = 0; i < live_group->get_nr_children() && i < copy_group->get_nr_children(); ++i) {
+		base_ptr found = find_corresponding_node(live_group->get_child(i), copy_group->get_child(i), node);
+		if (found)
+			return found;
+	}
+	return base_ptr();
+}
+
+/** return the node corresponding to node in a tree parsed from the current description.
+    The copy has no update handler, so cache nodes inside of it evaluate their children
+    directly. While the tree is being parsed or changed the description may not match the
+    tree and no copy is made. */
+base_ptr scene::copy_detached(const base_ptr& node)
+{
+	if (disable_update || !func_base_ptr)
+		return base_ptr();
+	base_ptr root = parse_detached_copy();
+	if (!root)
+		return base_ptr();
+	return find_corresponding_node(func_base_ptr, root, node);
+}
+
+/** start extracting the swept member at nr_sweep_samples values in [sweep_min,sweep_max]
+    in the background. Each value gets its own copy of the scene, such that the background
+    thread never evaluates the nodes shown in the gui. As the copies share nothing, every
+    mesh_sdf node reads its mesh and builds its bvh again per value, which multiplies their
+    time and memory by nr_sweep_samples. Cache nodes of the copies do not bake. */
+void scene::precompute_sweep()
+{
+	clear_sweep();
+	if (!func_base_ptr)
+		return;
+	std::vector<double> values;
+	for (unsigned si = 0; si < nr_sweep_samples; ++si) {
+		double value = nr_sweep_samples > 1 ? sweep_min + (sweep_max - sweep_min)*si / (nr_sweep_samples - 1) : sweep_min;
+		base_ptr root = parse_detached_copy();
+		if (!root || !set_member_value(root->get_interface<implicit_type>(), sweep_node_name, sweep_member_name, value)) {
+			std::cerr << "could not set " << sweep_node_name << "." << sweep_member_name << std::endl;
+			sweep_functions.clear();
+			return;
+		}
+		sweep_functions.push_back(scene_tree_function(root));
+		values.push_back(value);
+	}
+	std::vector<const surface_extractor::function_type*> functions;
+	for (const scene_tree_function& f : sweep_functions)
+		functions.push_back(&f);
+	surface_extractor configured_extractor;
+	impl_draw_ptr->configure_extractor(configured_extractor);
+	sweep.start(configured_extractor, impl_draw_ptr->box, impl_draw_ptr->get_sampling_resolution(), values, functions);
+	std::cout << "[SWEEP] Extracting " << nr_sweep_samples << " values of " << sweep_node_name << "." << sweep_member_name
+		<< " in [" << sweep_min << "," << sweep_max << "] in the background" << std::endl;
+}
+
+/// stop the sweep and release its meshes and copies
+void scene::clear_sweep()
+{
+	sweep.clear();
+	sweep_functions.clear();
+	sweep_exact_pending = false;
+	nr_sweep_ready = 0;
+	update_member(&nr_sweep_ready);
+}
+
+/// extract the exact surface once the sweep slider rests and update the progress of the sweep
+void scene::timer_event(double t, double dt)
+{
+	if (sweep_exact_pending && std::chrono::duration<double>(std::chrono::steady_clock::now() - last_sweep_change).count() > 0.3) {
+		sweep_exact_pending = false;
+		impl_draw_ptr->post_full_rebuild();
+	}
+	if (nr_sweep_ready != sweep.get_nr_ready()) {
+		nr_sweep_ready = sweep.get_nr_ready();
+		update_member(&nr_sweep_ready);
+		if (nr_sweep_ready == sweep.get_nr_samples())
+			std::cout << "[SWEEP] " << nr_sweep_ready << " meshes use " << sweep.get_memory_size() / 1024 << " KB" << std::endl;
+	}
+}
+
+/// apply the animation when its time changes
+void scene::on_set(void* member_ptr)
+{
+	if (member_ptr == &animation_time) {
+		std::vector<surface_extractor::box_type> changed_boxes;
+		if (apply_animation(animation_time, changed_boxes) && coherent_extraction)
+			impl_draw_ptr->post_incremental_rebuild(changed_boxes);
+		else
+			impl_draw_ptr->post_full_rebuild();
+	}
+	if (member_ptr == &animation_duration && find_control(animation_time))
+		find_control(animation_time)->set("max", animation_duration);
+	// while the slider moves, the precomputed mesh of the nearest value is shown and the exact surface follows once it rests
+	if (member_ptr == &sweep_value && func_base_ptr) {
+		disable_update = true;
+		bool found = set_member_value(func_base_ptr->get_interface<implicit_type>(), sweep_node_name, sweep_member_name, sweep_value);
+		disable_update = false;
+		if (found) {
+			reconstruct_description();
+			extracted_mesh mesh;
+			double nearest_value;
+			sweep_exact_pending = sweep.get_nearest(sweep_value, mesh, &nearest_value) && nearest_value != sweep_value;
+			if (sweep_exact_pending) {
+				last_sweep_change = std::chrono::steady_clock::now();
+				impl_draw_ptr->post_mesh(mesh);
+			}
+			else
+				impl_draw_ptr->post_full_rebuild();
+		}
+	}
+	if (member_ptr == &use_native || member_ptr == &native.bake_parameters || member_ptr == &native.compiler ||
+		member_ptr == &native.flags || member_ptr == &native.directory) {
+		build_native();
+		impl_draw_ptr->post_full_rebuild();
+	}
+	if ((member_ptr == &sweep_min || member_ptr == &sweep_max) && find_control(sweep_value)) {
+		find_control(sweep_value)->set("min", sweep_min);
+		find_control(sweep_value)->set("max", sweep_max);
+	}
+	update_member(member_ptr);
+}
+
 ///
 void scene::create_gui()
 {
 	add_decorator("scene", "heading");
+	if (begin_tree_node("Sphere Tracing", tracer.width)) {
+		align("\a");
+		add_member_control(this, "width", tracer.width, "value_slider", "min=16;max=4096;log=true;ticks=true");
+		add_member_control(this, "height", tracer.height, "value_slider", "min=16;max=4096;log=true;ticks=true");
+		add_member_control(this, "fov", tracer.fov, "value_slider", "min=5;max=120;ticks=true");
+		add_member_control(this, "azimuth", tracer.azimuth, "value_slider", "min=-180;max=180;ticks=true");
+		add_member_control(this, "elevation", tracer.elevation, "value_slider", "min=-89;max=89;ticks=true");
+		add_member_control(this, "max steps", tracer.max_nr_steps, "value_slider", "min=16;max=4096;log=true;ticks=true");
+		add_member_control(this, "pixel tolerance", tracer.pixel_tolerance, "value_slider", "min=0.01;max=4;log=true;ticks=true");
+		add_member_control(this, "background", tracer.background);
+		connect_copy(add_button("render image")->click, rebind(this, &scene::render_image));
+		add_member_control(this, "frames", nr_turntable_frames, "value_slider", "min=2;max=360;log=true;ticks=true");
+		connect_copy(add_button("render turntable")->click, rebind(this, &scene::render_turntable));
+		end_tree_node(tracer.width);
+		align("\b");
+	}
+	if (begin_tree_node("Animation", animation_time)) {
+		align("\a");
+		add_member_control(this, "node", key_node_name);
+		add_member_control(this, "member", key_member_name);
+		add_member_control(this, "time", animation_time, "value_slider", "min=0;ticks=true;max=" + cgv::utils::to_string(animation_duration));
+		connect_copy(add_button("set key")->click, rebind(this, &scene::set_key));
+		connect_copy(add_button("clear tracks")->click, rebind(this, &scene::clear_tracks));
+		add_member_control(this, "duration", animation_duration, "value_slider", "min=0.1;max=100;log=true;ticks=true");
+		add_member_control(this, "sequence frames", nr_animation_frames, "value_slider", "min=2;max=1000;log=true;ticks=true");
+		add_member_control(this, "coherent extraction", coherent_extraction, "check");
+		connect_copy(add_button("extract sequence")->click, rebind(this, &scene::extract_sequence));
+		end_tree_node(animation_time);
+		align("\b");
+	}
+	if (begin_tree_node("Parameter Sweep", sweep_value)) {
+		align("\a");
+		add_member_control(this, "node", sweep_node_name);
+		add_member_control(this, "member", sweep_member_name);
+		add_member_control(this, "min", sweep_min);
+		add_member_control(this, "max", sweep_max);
+		add_member_control(this, "samples", nr_sweep_samples, "value_slider", "min=2;max=256;log=true;ticks=true");
+		connect_copy(add_button("precompute sweep")->click, rebind(this, &scene::precompute_sweep));
+		add_view("extracted", nr_sweep_ready);
+		add_member_control(this, "value", sweep_value, "value_slider",
+			"ticks=true;min=" + cgv::utils::to_string(sweep_min) + ";max=" + cgv::utils::to_string(sweep_max));
+		end_tree_node(sweep_value);
+		align("\b");
+	}
+	if (begin_tree_node("Native Evaluation", use_native)) {
+		align("\a");
+		add_member_control(this, "native evaluation", use_native, "check");
+		add_member_control(this, "bake parameters", native.bake_parameters, "check");
+		add_member_control(this, "compiler", native.compiler);
+		add_member_control(this, "flags", native.flags);
+		add_member_control(this, "directory", native.directory);
+		end_tree_node(use_native);
+		align("\b");
+	}
 	if (func_base_ptr)
 		inline_object_gui(func_base_ptr);
 }
@@ -3,11 +3,35 @@
 #include "implicit_base.h"
 #include <cgv/gui/text_editor.h>
 #include "gl_implicit_surface_drawable.h"
+#include "sphere_tracer.h"
+#include "animation_track.h"
+#include "mesh_sweep.h"
+#include "native_scene.h"
+#include <chrono>
+
+/// implicit function of a scene tree that is not attached to a scene, such as the copies extracted by parameter sweeps
+struct scene_tree_function :
+	public gl_implicit_surface_drawable::F,
+	public batch_evaluation_interface
+{
+	/// root of the tree
+	base_ptr root;
+	/// construct from the root node
+	scene_tree_function(base_ptr _root = base_ptr()) : root(_root) {}
+	/// evaluate the root node
+	double evaluate(const pnt_type& p) const;
+	/// evaluate the gradient of the root node
+	vec_type evaluate_gradient(const pnt_type& p) const;
+	/// evaluate a batch of points with the batch interface of the root node
+	void evaluate_batch(const std::vector<implicit_base<double>::pnt_type>& ps, std::vector<double>& vs) const;
+};
 
 ///
 class scene :
 	public group,
 	public gl_implicit_surface_drawable::F,
+	public batch_evaluation_interface,
+	public color_evaluation_interface,
 	public scene_update_handler,
 	public drawable,
 	public provider,
@@ -45,9 +69,81 @@ protected:
 	void on_text_deletion(int text_pos, int nr_deleted, const char* deleted_text);
 	/// update the style starting from text_pos. The text is unchanged after text_pos + min_nr_checked. Return the number of changed style characters. The default implementation does nothing, such that style A is kept for all characters and returns 0
 	void update_style(int text_pos, int min_nr_checked);
+	/// cpu sphere tracer for previews without contouring
+	sphere_tracer<double> tracer;
+	/// number of frames of a turntable
+	unsigned nr_turntable_frames;
+	/// render the scene within the box of the implicit surface drawable to an image file
+	void render_image();
+	/// render a turntable of the scene to a sequence of image files
+	void render_turntable();
+	/// translate the scene tree into GLSL for the ray marched preview of the implicit surface drawable
+	void generate_preview();
+	/// whether the scene is evaluated by native code compiled from its translation
+	bool use_native;
+	/// native code of the current scene tree
+	native_scene native;
+	/// compile the translation of the scene tree into native code, which falls back to the virtual evaluation of the tree if this fails
+	void build_native();
 public:
 	/// type of implicits
 	typedef implicit_base<double> implicit_type;
+protected:
+	/// keyframe tracks of node members
+	std::vector<animation_track> tracks;
+	/// names of the node and of its member whose current value is stored by set_key
+	std::string key_node_name, key_member_name;
+	/// current time of the animation
+	double animation_time;
+	/// time of the last frame of extracted sequences
+	double animation_duration;
+	/// number of frames of extracted sequences
+	unsigned nr_animation_frames;
+	/// whether frames only resample the regions in which the animated nodes may have moved the surface
+	bool coherent_extraction;
+	/// append name, size and modification time of the files read by node and its descendants to stamps
+	void append_file_stamps(implicit_type* node, std::string& stamps) const;
+	/// find the node with the given name in the subtree of node and collect the nodes from node to it into path
+	bool find_node_path(implicit_type* node, const std::string& name, std::vector<implicit_type*>& path) const;
+	/// evaluate the animated nodes in scene coordinates at the centers of the bricks of the sampling grid; returns false if a node cannot be evaluated in scene coordinates
+	bool probe_animated_nodes(std::vector<double>& values) const;
+	/// set the animated members to their values at time t and collect boxes that contain all changes of the function; returns false if the changes could not be bounded
+	bool apply_animation(double t, std::vector<surface_extractor::box_type>& changed_boxes);
+	/// store the current value of the selected member as key at the current time
+	void set_key();
+	/// remove all tracks
+	void clear_tracks();
+	/// extract the frames of the animation to obj files
+	void extract_sequence();
+	/// set a member of type double of the node with the given name in the tree below root; returns false if node or member do not exist
+	bool set_member_value(implicit_type* root, const std::string& node_name, const std::string& member_name, double value);
+	/// names of the node and of its member that are swept
+	std::string sweep_node_name, sweep_member_name;
+	/// range of the swept values
+	double sweep_min, sweep_max;
+	/// number of sampled values
+	unsigned nr_sweep_samples;
+	/// current value of the swept member
+	double sweep_value;
+	/// number of extracted samples shown in the gui
+	unsigned nr_sweep_ready;
+	/// set while a precomputed mesh is shown until the exact surface is extracted
+	bool sweep_exact_pending;
+	/// time of the last change of sweep_value
+	std::chrono::steady_clock::time_point last_sweep_change;
+	/// detached copies of the scene with the sampled values
+	std::vector<scene_tree_function> sweep_functions;
+	/// meshes extracted at the sampled values, declared after the copies to stop its thread before they are destructed
+	mesh_sweep sweep;
+	/// parse the scene description into a tree that is not attached to the scene
+	base_ptr parse_detached_copy();
+	/// start extracting the sampled values of the swept member in the background
+	void precompute_sweep();
+	/// stop the sweep and release its meshes and copies
+	void clear_sweep();
+	/// extract the exact surface once the sweep slider rests and update the progress of the sweep
+	void timer_event(double t, double dt);
+public:
 	/// pointer to implicit surface drawable
 	gl_implicit_surface_drawable_ptr impl_draw_ptr;
 	/// pointer to current function
@@ -60,6 +156,8 @@ public:
 	std::string reconstruct_description_recursive(unsigned int& i, implicit_type* func_ptr, group* g);
 	/// check if factory's symbol[s] match location i in description
 	bool symbol_matches_description(unsigned int i, abst_scene_factory* factory, unsigned int& offset) const;
+	/// return the index of the factory whose symbol has the longest match at position i of the description or -1 if none matches
+	int find_factory(unsigned int i, unsigned int& offset) const;
 	/// recursive part of the scene description parsing
 	base_ptr parse_description_recursive(unsigned int& i, group* g);
 	/// parse a scene description and construct a function pointer
@@ -68,6 +166,8 @@ public:
 	void update_scene();
 	/// callback for functions that update the scene description without the implicit function
 	void update_description();
+	/// return the node corresponding to node in a detached copy of the scene tree, such that background threads evaluate nodes that the gui does not change; empty while the scene is being changed
+	base_ptr copy_detached(const base_ptr& node);
 	/// registration of scene factories;
 	void register_factory(abst_scene_factory* _scene_factory);
 	/// construct scene from a description string
@@ -76,12 +176,22 @@ public:
 	void unregister();
 	/// overload to return the type name of this object
 	std::string get_type_name() const;
+	/// apply the animation when its time changes
+	void on_set(void* member_ptr);
 	///
 	void create_gui();
 	/// cast evaluation to func_base_ptr
 	double evaluate(const pnt_type& p) const;
 	/// cast gradient evaluation to func_base_ptr
 	vec_type evaluate_gradient(const pnt_type& p) const;
+	/// fused evaluation of function value and surface color with a single traversal of the scene
+	double evaluate_and_color(const pnt_type& p, implicit_type::clr_type& clr) const;
+	/// evaluate a batch of points with the batch interface of func_base_ptr
+	void evaluate_batch(const std::vector<implicit_type::pnt_type>& ps, std::vector<double>& vs) const;
+	/// evaluate values and surface colors of extracted vertices with the fused evaluation of value and color
+	void evaluate_batch_and_colors(const std::vector<implicit_type::pnt_type>& ps, std::vector<double>& vs, std::vector<cgv::math::fvec<float, 3> >& clrs) const;
+	/// return the Lipschitz bound of func_base_ptr
+	double get_lipschitz_bound() const;
 };
 
 /// ref counted pointer to a scene
@@ -0,0 +1,162 @@
+#include "sparse_brick_volume.h"
+
+/// construct empty volume
+template <typename T>
+sparse_brick_volume<T>::sparse_brick_volume() : cell_extent(0, 0, 0), inv_cell_extent(0, 0, 0), background(1)
+{
+	res[0] = res[1] = res[2] = 0;
+	nr_bricks[0] = nr_bricks[1] = nr_bricks[2] = 0;
+}
+
+/// set the sampled box and resolution, remove all bricks and set all samples to the outside background value
+template <typename T>
+void sparse_brick_volume<T>::resize(const box_type& _box, unsigned res_x, unsigned res_y, unsigned res_z, T _background)
+{
+	box = _box;
+	res[0] = std::max(res_x, 2u);
+	res[1] = std::max(res_y, 2u);
+	res[2] = std::max(res_z, 2u);
+	background = _background;
+	vec_type e = box.get_extent();
+	for (int c = 0; c < 3; ++c) {
+		nr_bricks[c] = (res[c] + brick_size - 1) / brick_size;
+		cell_extent(c) = e(c) / (res[c] - 1);
+		inv_cell_extent(c) = cell_extent(c) > 0 ? 1.0 / cell_extent(c) : 0.0;
+	}
+	brick_index.clear();
+	brick_keys.clear();
+	brick_values.clear();
+	inside_bricks.assign(size_t(nr_bricks[0])*nr_bricks[1]*nr_bricks[2], false);
+}
+
+/// return the location of a sample
+template <typename T>
+typename sparse_brick_volume<T>::pnt_type sparse_brick_volume<T>::get_location(unsigned i, unsigned j, unsigned k) const
+{
+	const pnt_type& p0 = box.get_min_pnt();
+	return pnt_type(p0(0) + i*cell_extent(0), p0(1) + j*cell_extent(1), p0(2) + k*cell_extent(2));
+}
+
+/// return an estimate of the occupied memory in bytes
+template <typename T>
+size_t sparse_brick_volume<T>::get_memory_size() const
+{
+	return
+		brick_values.capacity()*sizeof(T) +
+		brick_keys.capacity()*sizeof(key_type) +
+		brick_index.size()*(sizeof(key_type) + sizeof(uint32_t) + 2*sizeof(void*)) +
+		brick_index.bucket_count()*sizeof(void*) +
+		inside_bricks.size() / 8;
+}
+
+/// allocate the brick with the given brick coordinates, initialize it with the background and return its samples
+template <typename T>
+T* sparse_brick_volume<T>::allocate_brick(unsigned bi, unsigned bj, unsigned bk)
+{
+	key_type key = get_brick_key(bi, bj, bk);
+	auto it = brick_index.find(key);
+	if (it != brick_index.end())
+		return &brick_values[size_t(it->second)*brick_volume];
+	T value = inside_bricks[get_brick_table_index(bi, bj, bk)] ? -background : background;
+	uint32_t b = uint32_t(brick_keys.size());
+	brick_index[key] = b;
+	brick_keys.push_back(key);
+	brick_values.resize(brick_values.size() + brick_volume, value);
+	return &brick_values[size_t(b)*brick_volume];
+}
+
+/// return the samples of the brick containing sample (i,j,k) or 0 if not allocated
+template <typename T>
+const T* sparse_brick_volume<T>::find_brick(unsigned i, unsigned j, unsigned k) const
+{
+	auto it = brick_index.find(get_brick_key(i / brick_size, j / brick_size, k / brick_size));
+	if (it == brick_index.end())
+		return 0;
+	return &brick_values[size_t(it->second)*brick_volume];
+}
+
+/// read access to a sample, which returns the signed background for unallocated bricks
+template <typename T>
+T sparse_brick_volume<T>::get_value(unsigned i, unsigned j, unsigned k) const
+{
+	const T* values = find_brick(i, j, k);
+	if (values)
+		return values[i % brick_size + brick_size*(j % brick_size + brick_size*(k % brick_size))];
+	return inside_bricks[get_brick_table_index(i / brick_size, j / brick_size, k / brick_size)] ? -background : background;
+}
+
+/// write access to a sample, which allocates the containing brick if necessary
+template <typename T>
+void sparse_brick_volume<T>::set_value(unsigned i, unsigned j, unsigned k, T value)
+{
+	T* values = allocate_brick(i / brick_size, j / brick_size, k / brick_size);
+	values[i % brick_size + brick_size*(j % brick_size + brick_size*(k % brick_size))] = value;
+}
+
+/// check whether p lies inside the sampled box
+template <typename T>
+bool sparse_brick_volume<T>::contains(const pnt_type& p) const
+{
+	if (inside_bricks.empty())
+		return false;
+	for (int c = 0; c < 3; ++c)
+		if (p(c) < box.get_min_pnt()(c) || p(c) > box.get_max_pnt()(c))
+			return false;
+	return true;
+}
+
+/// compute cell index and local coordinates of p clamped to the box and gather the 8 cell corner samples
+template <typename T>
+static void gather_cell(const sparse_brick_volume<T>& V, const typename sparse_brick_volume<T>::pnt_type& p, T v[8], double t[3])
+{
+	unsigned idx[3];
+	for (int c = 0; c < 3; ++c) {
+		double u = (p(c) - V.get_box().get_min_pnt()(c)) / V.get_cell_extent()(c);
+		double u_max = V.get_resolution(c) - 1;
+		if (!(u > 0))
+			u = 0;
+		else if (u > u_max)
+			u = u_max;
+		idx[c] = std::min(unsigned(u), V.get_resolution(c) - 2);
+		t[c] = u - idx[c];
+	}
+	for (int ci = 0; ci < 8; ++ci)
+		v[ci] = V.get_value(idx[0] + (ci & 1), idx[1] + ((ci >> 1) & 1), idx[2] + ((ci >> 2) & 1));
+}
+
+/// trilinearly interpolate the samples at p, which is clamped to the box
+template <typename T>
+T sparse_brick_volume<T>::interpolate(const pnt_type& p) const
+{
+	T v[8];
+	double t[3];
+	gather_cell(*this, p, v, t);
+	double vy0 = (1 - t[1])*((1 - t[0])*v[0] + t[0]*v[1]) + t[1]*((1 - t[0])*v[2] + t[0]*v[3]);
+	double vy1 = (1 - t[1])*((1 - t[0])*v[4] + t[0]*v[5]) + t[1]*((1 - t[0])*v[6] + t[0]*v[7]);
+	return T((1 - t[2])*vy0 + t[2]*vy1);
+}
+
+/// compute the gradient of the trilinear interpolant at p, which is clamped to the box
+template <typename T>
+typename sparse_brick_volume<T>::vec_type sparse_brick_volume<T>::interpolate_gradient(const pnt_type& p) const
+{
+	T v[8];
+	double t[3];
+	gather_cell(*this, p, v, t);
+	vec_type g(0, 0, 0);
+	for (int ci = 0; ci < 8; ++ci) {
+		double w[3], dw[3];
+		for (int c = 0; c < 3; ++c) {
+			bool upper = ((ci >> c) & 1) != 0;
+			w[c] = upper ? t[c] : 1 - t[c];
+			dw[c] = upper ? 1.0 : -1.0;
+		}
+		g(0) += dw[0]*w[1]*w[2]*v[ci];
+		g(1) += w[0]*dw[1]*w[2]*v[ci];
+		g(2) += w[0]*w[1]*dw[2]*v[ci];
+	}
+	return vec_type(g(0)*inv_cell_extent(0), g(1)*inv_cell_extent(1), g(2)*inv_cell_extent(2));
+}
+
+template class sparse_brick_volume<float>;
+template class sparse_brick_volume<double>;
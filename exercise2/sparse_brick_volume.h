@@ -0,0 +1,167 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <cgv/math/fvec.h>
+#include <cgv/media/axis_aligned_box.h>
+#include "parallel_for.h"
+
+/** sparse storage of a sampled scalar field on a regular grid of res samples per axis
+    over an axis aligned box. Samples are grouped into bricks of 8x8x8 samples, which are
+    kept in a hash map and allocated only in a narrow band around the zero level set.
+    Everywhere else the volume reports a background value, whose sign is stored per
+    brick in a bit table such that inside and outside regions stay distinguishable.
+    Sample locations and indexing match sampled_grid. */
+template <typename T>
+class sparse_brick_volume
+{
+public:
+	/// number of samples along each brick edge
+	static const unsigned brick_size = 8;
+	/// number of samples per brick
+	static const unsigned brick_volume = brick_size*brick_size*brick_size;
+	/// type of 3d point
+	typedef cgv::math::fvec<double, 3> pnt_type;
+	/// type of 3d vector
+	typedef cgv::math::fvec<double, 3> vec_type;
+	/// type of the sampled box
+	typedef cgv::media::axis_aligned_box<double, 3> box_type;
+	/// type of the hash key encoding the brick coordinates with 21 bits each
+	typedef uint64_t key_type;
+
+	/// iterator over the allocated bricks
+	class brick_iterator
+	{
+		const sparse_brick_volume<T>* volume;
+		size_t bi;
+	public:
+		brick_iterator(const sparse_brick_volume<T>* _volume, size_t _bi) : volume(_volume), bi(_bi) {}
+		bool operator != (const brick_iterator& it) const { return bi != it.bi; }
+		brick_iterator& operator ++ () { ++bi; return *this; }
+		/// return the brick coordinate along axis c
+		unsigned get_brick_coord(int c) const { return volume->decode_brick_key(volume->brick_keys[bi], c); }
+		/// return the sample index of the first brick sample along axis c
+		unsigned get_origin(int c) const { return get_brick_coord(c)*brick_size; }
+		/// return pointer to the samples of the brick in x-fastest order
+		const T* get_values() const { return &volume->brick_values[bi*brick_volume]; }
+	};
+
+protected:
+	/// sampled box
+	box_type box;
+	/// number of samples along each axis
+	unsigned res[3];
+	/// number of bricks along each axis
+	unsigned nr_bricks[3];
+	/// distance between adjacent samples along each axis and its inverse
+	vec_type cell_extent, inv_cell_extent;
+	/// absolute value reported for samples in unallocated bricks
+	T background;
+	/// map from brick key to the index of the brick in brick_values
+	std::unordered_map<key_type, uint32_t> brick_index;
+	/// key of each allocated brick
+	std::vector<key_type> brick_keys;
+	/// samples of all allocated bricks stored consecutively
+	std::vector<T> brick_values;
+	/// one bit per brick that tells whether an unallocated brick lies inside
+	std::vector<bool> inside_bricks;
+
+	/// return linear index into the brick table
+	size_t get_brick_table_index(unsigned bi, unsigned bj, unsigned bk) const { return bi + size_t(nr_bricks[0])*(bj + size_t(nr_bricks[1])*bk); }
+	/// return the samples of the brick containing sample (i,j,k) or 0 if not allocated
+	const T* find_brick(unsigned i, unsigned j, unsigned k) const;
+
+public:
+	/// construct empty volume
+	sparse_brick_volume();
+	/// set the sampled box and resolution, remove all bricks and set all samples to the outside background value
+	void resize(const box_type& _box, unsigned res_x, unsigned res_y, unsigned res_z, T _background);
+	/// return the sampled box
+	const box_type& get_box() const { return box; }
+	/// return the number of samples along axis c
+	unsigned get_resolution(int c) const { return res[c]; }
+	/// return the distance between adjacent samples along each axis
+	const vec_type& get_cell_extent() const { return cell_extent; }
+	/// return the absolute background value
+	T get_background() const { return background; }
+	/// return the location of a sample
+	pnt_type get_location(unsigned i, unsigned j, unsigned k) const;
+	/// encode brick coordinates into a hash key
+	static key_type get_brick_key(unsigned bi, unsigned bj, unsigned bk) { return key_type(bi) | (key_type(bj) << 21) | (key_type(bk) << 42); }
+	/// decode the brick coordinate along axis c from a hash key
+	static unsigned decode_brick_key(key_type key, int c) { return unsigned(key >> (21*c)) & 0x1FFFFF; }
+	/// return the number of allocated bricks
+	size_t get_nr_allocated_bricks() const { return brick_keys.size(); }
+	/// return an estimate of the occupied memory in bytes
+	size_t get_memory_size() const;
+	/// return iterator to the first allocated brick
+	brick_iterator begin_bricks() const { return brick_iterator(this, 0); }
+	/// return iterator behind the last allocated brick
+	brick_iterator end_bricks() const { return brick_iterator(this, brick_keys.size()); }
+	/// allocate the brick with the given brick coordinates, initialize it with the background and return its samples
+	T* allocate_brick(unsigned bi, unsigned bj, unsigned bk);
+	/// mark an unallocated brick as inside or outside region
+	void set_brick_inside(unsigned bi, unsigned bj, unsigned bk, bool inside) { inside_bricks[get_brick_table_index(bi, bj, bk)] = inside; }
+	/// read access to a sample, which returns the signed background for unallocated bricks
+	T get_value(unsigned i, unsigned j, unsigned k) const;
+	/// write access to a sample, which allocates the containing brick if necessary
+	void set_value(unsigned i, unsigned j, unsigned k, T value);
+	/// check whether p lies inside the sampled box
+	bool contains(const pnt_type& p) const;
+	/// trilinearly interpolate the samples at p, which is clamped to the box
+	T interpolate(const pnt_type& p) const;
+	/// compute the gradient of the trilinear interpolant at p, which is clamped to the box
+	vec_type interpolate_gradient(const pnt_type& p) const;
+	/** sample the function f (any callable mapping pnt_type to a value) in a narrow band
+	    of band_width cells around its zero level set. A brick is allocated if the value of
+	    f at its center does not exceed lipschitz_bound times the brick's half diagonal plus
+	    the band width. If lipschitz_bound bounds the gradient length of f, no brick with a
+	    sample inside the band is missed and all other bricks keep the sign of their center
+	    up to their boundary samples. Classification and sampling use all hardware threads. */
+	template <typename F>
+	void build_narrow_band(const F& f, double band_width, double lipschitz_bound)
+	{
+		size_t n = size_t(nr_bricks[0])*nr_bricks[1]*nr_bricks[2];
+		std::vector<char> classification(n, 0);
+		// the boxes of the bricks reach up to the first samples of the next bricks
+		double radius = 0.5*brick_size*cell_extent.length() + band_width*std::max(cell_extent(0), std::max(cell_extent(1), cell_extent(2)));
+		double max_value = lipschitz_bound*radius;
+		// classify bricks: 0 .. outside, 1 .. inside, 2 .. allocate
+		parallel_for(0, int(nr_bricks[2]), [&](int bk) {
+			for (unsigned bj = 0; bj < nr_bricks[1]; ++bj) {
+				for (unsigned bi = 0; bi < nr_bricks[0]; ++bi) {
+					pnt_type p0 = get_location(bi*brick_size, bj*brick_size, bk*brick_size);
+					pnt_type p1 = get_location((bi + 1)*brick_size, (bj + 1)*brick_size, (bk + 1)*brick_size);
+					double v = f(0.5*(p0 + p1));
+					classification[get_brick_table_index(bi, bj, unsigned(bk))] = std::abs(v) <= max_value ? 2 : (v < 0 ? 1 : 0);
+				}
+			}
+		});
+		// allocate bricks sequentially
+		for (unsigned bk = 0; bk < nr_bricks[2]; ++bk)
+			for (unsigned bj = 0; bj < nr_bricks[1]; ++bj)
+				for (unsigned bi = 0; bi < nr_bricks[0]; ++bi) {
+					char cls = classification[get_brick_table_index(bi, bj, bk)];
+					if (cls == 2)
+						allocate_brick(bi, bj, bk);
+					else
+						set_brick_inside(bi, bj, bk, cls == 1);
+				}
+		// sample allocated bricks in parallel
+		parallel_for(0, int(brick_keys.size()), [&](int b) {
+			unsigned o[3];
+			for (int c = 0; c < 3; ++c)
+				o[c] = decode_brick_key(brick_keys[b], c)*brick_size;
+			T* values = &brick_values[size_t(b)*brick_volume];
+			for (unsigned k = 0; k < brick_size; ++k)
+				for (unsigned j = 0; j < brick_size; ++j)
+					for (unsigned i = 0; i < brick_size; ++i) {
+						if (o[0] + i >= res[0] || o[1] + j >= res[1] || o[2] + k >= res[2])
+							continue;
+						values[i + brick_size*(j + brick_size*k)] = T(f(get_location(o[0] + i, o[1] + j, o[2] + k)));
+					}
+		});
+	}
+};
@@ -0,0 +1,144 @@
+#include "sphere_tracer.h"
+#include "parallel_for.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+/// construct with default camera and a 512x512 image
+template <typename T>
+sphere_tracer<T>::sphere_tracer() :
+	width(512), height(512), fov(40), azimuth(30), elevation(20), max_nr_steps(256), pixel_tolerance(T(0.5)),
+	background(1.0f, 1.0f, 1.0f, 1.0f), box(pnt_type(-1, -1, -1), pnt_type(1, 1, 1))
+{
+}
+
+/// compute the camera frame from box, azimuth, elevation and field of view
+template <typename T>
+void sphere_tracer<T>::compute_camera()
+{
+	const T deg = T(0.01745329252);
+	tan_half_fov = T(tan(T(0.5)*fov*deg));
+	pnt_type center = box.get_center();
+	T radius = T(0.5)*box.get_extent().length();
+	T distance = radius / T(sin(T(0.5)*fov*deg));
+	vec_type dir(cos(elevation*deg)*cos(azimuth*deg), sin(elevation*deg), cos(elevation*deg)*sin(azimuth*deg));
+	eye = center + distance*dir;
+	view_dir = -dir;
+	right = normalize(cross(view_dir, vec_type(0, 1, 0)));
+	if (right.length() < T(0.5) || !(right(0) == right(0)))
+		right = vec_type(1, 0, 0);
+	up = cross(right, view_dir);
+}
+
+/// clip the ray against the box and return whether the interval [t0,t1] is non empty
+template <typename T>
+bool sphere_tracer<T>::clip_ray(const pnt_type& o, const vec_type& d, T& t0, T& t1) const
+{
+	t0 = 0;
+	t1 = std::numeric_limits<T>::max();
+	for (int c = 0; c < 3; ++c) {
+		if (d(c) == 0) {
+			if (o(c) < box.get_min_pnt()(c) || o(c) > box.get_max_pnt()(c))
+				return false;
+			continue;
+		}
+		T ta = (box.get_min_pnt()(c) - o(c)) / d(c);
+		T tb = (box.get_max_pnt()(c) - o(c)) / d(c);
+		if (ta > tb)
+			std::swap(ta, tb);
+		t0 = std::max(t0, ta);
+		t1 = std::min(t1, tb);
+	}
+	return t0 <= t1;
+}
+
+/// trace a single ray and return the shaded color, nr_evaluations is incremented by the number of evaluations
+template <typename T>
+typename sphere_tracer<T>::clr_type sphere_tracer<T>::trace_ray(const implicit_base<T>& f, T lipschitz_bound, const pnt_type& o, const vec_type& d, size_t& nr_evaluations) const
+{
+	T t, t1;
+	if (!clip_ray(o, d, t, t1))
+		return background;
+	// footprint of a pixel per unit distance along the ray
+	T footprint = 2 * tan_half_fov / height;
+	for (unsigned s = 0; s < max_nr_steps && t <= t1; ++s) {
+		pnt_type p = o + t*d;
+		T v = f.evaluate(p);
+		++nr_evaluations;
+		T min_step = pixel_tolerance*footprint*t;
+		if (v < min_step) {
+			clr_type clr;
+			f.evaluate_and_color(p, clr);
+			vec_type n = f.evaluate_gradient(p);
+			nr_evaluations += 2;
+			T l = n.length();
+			T diffuse = l > 0 ? std::abs(dot(n, d)) / l : 1;
+			float intensity = float(T(0.2) + T(0.8)*diffuse);
+			return clr_type(clr[0] * intensity, clr[1] * intensity, clr[2] * intensity, 1.0f);
+		}
+		t += std::max(v / lipschitz_bound, min_step);
+	}
+	return background;
+}
+
+/// render f into rgb with 3 bytes per pixel stored row by row from top to bottom; returns the number of function evaluations
+template <typename T>
+size_t sphere_tracer<T>::render(const implicit_base<T>& f, std::vector<unsigned char>& rgb)
+{
+	compute_camera();
+	T lipschitz_bound = std::max(f.get_lipschitz_bound(), std::numeric_limits<T>::epsilon());
+	rgb.resize(size_t(width)*height * 3);
+	unsigned nr_tiles_x = (width + tile_size - 1) / tile_size;
+	unsigned nr_tiles_y = (height + tile_size - 1) / tile_size;
+	std::atomic<size_t> nr_evaluations(0);
+	parallel_for(0, int(nr_tiles_x*nr_tiles_y), [&](int tile) {
+		unsigned x0 = (tile % nr_tiles_x)*tile_size, y0 = (tile / nr_tiles_x)*tile_size;
+		size_t tile_evaluations = 0;
+		T aspect = T(width) / height;
+		for (unsigned y = y0; y < std::min(y0 + tile_size, height); ++y)
+			for (unsigned x = x0; x < std::min(x0 + tile_size, width); ++x) {
+				T u = (2 * (x + T(0.5)) / width - 1)*tan_half_fov*aspect;
+				T v = (1 - 2 * (y + T(0.5)) / height)*tan_half_fov;
+				vec_type d = normalize(view_dir + u*right + v*up);
+				clr_type clr = trace_ray(f, lipschitz_bound, eye, d, tile_evaluations);
+				unsigned char* pixel = &rgb[3 * (size_t(y)*width + x)];
+				for (int c = 0; c < 3; ++c)
+					pixel[c] = (unsigned char)(255 * std::max(0.0f, std::min(1.0f, float(clr[c]))));
+			}
+		nr_evaluations += tile_evaluations;
+	});
+	return nr_evaluations;
+}
+
+/// render a turntable of nr_frames images with increasing azimuth into files file_base_000.ppm and so on; returns false if a file could not be written
+template <typename T>
+bool sphere_tracer<T>::render_turntable(const implicit_base<T>& f, const std::string& file_base, unsigned nr_frames)
+{
+	T azimuth0 = azimuth;
+	std::vector<unsigned char> rgb;
+	bool success = true;
+	for (unsigned i = 0; i < nr_frames && success; ++i) {
+		azimuth = azimuth0 + 360 * T(i) / nr_frames;
+		render(f, rgb);
+		char suffix[16];
+		snprintf(suffix, sizeof(suffix), "_%03u.ppm", i);
+		success = write_ppm(file_base + suffix, width, height, rgb);
+	}
+	azimuth = azimuth0;
+	return success;
+}
+
+/// write an rgb image to a binary ppm file
+template <typename T>
+bool sphere_tracer<T>::write_ppm(const std::string& file_name, unsigned w, unsigned h, const std::vector<unsigned char>& rgb)
+{
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	os << "P6\n" << w << " " << h << "\n255\n";
+	os.write((const char*)&rgb.front(), rgb.size());
+	return !os.fail();
+}
+
+template class sphere_tracer<double>;
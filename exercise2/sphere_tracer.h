@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cgv/math/fvec.h>
+#include <cgv/media/axis_aligned_box.h>
+#include "implicit_base.h"
+
+/** renders an implicit function directly to an rgb image by sphere tracing, without
+    extracting a mesh. The camera orbits around the center of a box, which also bounds
+    the traced rays. Along each ray the tracer advances by |f(p)|/L with the Lipschitz
+    bound L reported by the function, such that no surface crossing can be skipped. A
+    ray stops once |f| falls below the footprint of a pixel at the current distance.
+    The image is split into tiles that are distributed over all hardware threads. */
+template <typename T>
+class sphere_tracer
+{
+public:
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::clr_type clr_type;
+	typedef cgv::media::axis_aligned_box<T, 3> box_type;
+
+	/// image width in pixels
+	unsigned width;
+	/// image height in pixels
+	unsigned height;
+	/// vertical field of view in degrees
+	T fov;
+	/// rotation of the camera around the vertical axis in degrees
+	T azimuth;
+	/// elevation of the camera above the horizontal plane in degrees
+	T elevation;
+	/// maximum number of steps per ray
+	unsigned max_nr_steps;
+	/// fraction of the pixel footprint below which a ray counts as hit
+	T pixel_tolerance;
+	/// background color
+	clr_type background;
+
+protected:
+	/// width and height of tiles in pixels
+	static const unsigned tile_size = 16;
+	/// box bounding the rays
+	box_type box;
+	/// camera frame
+	pnt_type eye;
+	vec_type view_dir, right, up;
+	/// half of the image plane extent at unit distance
+	T tan_half_fov;
+
+	/// compute the camera frame from box, azimuth, elevation and field of view
+	void compute_camera();
+	/// clip the ray against the box and return whether the interval [t0,t1] is non empty
+	bool clip_ray(const pnt_type& o, const vec_type& d, T& t0, T& t1) const;
+	/// trace a single ray and return the shaded color, nr_evaluations is incremented by the number of evaluations
+	clr_type trace_ray(const implicit_base<T>& f, T lipschitz_bound, const pnt_type& o, const vec_type& d, size_t& nr_evaluations) const;
+
+public:
+	/// construct with default camera and a 512x512 image
+	sphere_tracer();
+	/// set the box that bounds the traced rays and determines the camera distance
+	void set_box(const box_type& _box) { box = _box; }
+	/// render f into rgb with 3 bytes per pixel stored row by row from top to bottom; returns the number of function evaluations
+	size_t render(const implicit_base<T>& f, std::vector<unsigned char>& rgb);
+	/// render a turntable of nr_frames images with increasing azimuth into files file_base_000.ppm and so on; returns false if a file could not be written
+	bool render_turntable(const implicit_base<T>& f, const std::string& file_base, unsigned nr_frames);
+	/// write an rgb image to a binary ppm file
+	static bool write_ppm(const std::string& file_name, unsigned w, unsigned h, const std::vector<unsigned char>& rgb);
+};
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include "implicit_primitive.h"
+#include "parallel_for.h"
+
+/** expression templates for scenes that are fixed at compile time. Each node type of the
+    scene description has a counterpart whose children are members of template type, such
+    that the evaluation of a whole scene is a single function that the compiler inlines.
+    All node types are literal types with constexpr constructors, so scenes declared as
+    constexpr objects have their parameters folded into the inlined code:
+
+      constexpr auto s = static_scene::make_translation(0.5, 0, 0, static_scene::sphere()) |
+                         static_scene::make_uniform_scaling(0.5, static_scene::box());
+      static_implicit<decltype(s)> f(s);
+
+    static_implicit adapts a scene to implicit_base, such that it can be used wherever a
+    node of the scene tree is expected, and serves as the upper bound of evaluation speed
+    that the virtual, native and GPU paths are compared against. The nodes evaluate the
+    same functions as their counterparts in the scene tree, including the primitives
+    whose implementation is left to the tasks. Points are of any type P with element
+    access p(i) and a constructor from three coordinates. Further primitives are added
+    by deriving from static_scene::expression and implementing evaluate and
+    get_lipschitz_bound. */
+namespace static_scene {
+
+/// literal vector type of the parameters
+struct vec3
+{
+	double x, y, z;
+	constexpr vec3(double _x, double _y, double _z) : x(_x), y(_y), z(_z) {}
+};
+
+constexpr vec3 operator - (const vec3& a, const vec3& b) { return vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+constexpr vec3 operator * (double s, const vec3& a) { return vec3(s*a.x, s*a.y, s*a.z); }
+constexpr double dot(const vec3& a, const vec3& b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+
+/// base of all nodes that gives access to the derived node E
+template <typename E>
+struct expression
+{
+	/// return the derived node
+	constexpr const E& derived() const { return static_cast<const E&>(*this); }
+};
+
+/// counterpart of the sphere primitive
+struct sphere : public expression<sphere>
+{
+	constexpr sphere() {}
+	/// mirrors sphere::evaluate in sphere.cxx
+	template <typename P>
+	double evaluate(const P& p) const
+	{
+		double f_p = std::numeric_limits<double>::infinity();
+
+		// Task 2.1a: Use the same function of p as your implementation in sphere.cxx.
+
+		return f_p;
+	}
+	double get_lipschitz_bound() const { return 1; }
+};
+
+/// counterpart of the box primitive
+struct box : public expression<box>
+{
+	constexpr box() {}
+	/// mirrors box::evaluate in box.cxx
+	template <typename P>
+	double evaluate(const P& p) const
+	{
+		double f_p = std::numeric_limits<double>::infinity();
+
+		// Task 2.1a: Use the same function of p as your implementation in box.cxx.
+
+		return f_p;
+	}
+	double get_lipschitz_bound() const { return 1; }
+};
+
+/// counterpart of the cylinder primitive
+struct cylinder : public expression<cylinder>
+{
+	constexpr cylinder() {}
+	/// mirrors cylinder::evaluate in cylinder.cxx
+	template <typename P>
+	double evaluate(const P& p) const
+	{
+		double f_p = std::numeric_limits<double>::infinity();
+
+		// Task 2.1a: Use the same function of p as your implementation in cylinder.cxx.
+
+		return f_p;
+	}
+	double get_lipschitz_bound() const { return 1; }
+};
+
+/** counterpart of a distance surface around the single skeleton edge from a to b with
+    radius r. As the distance to a skeleton is the minimum over its edges, surfaces of
+    larger skeletons are the union of the surfaces of their edges. */
+struct distance_surface : public expression<distance_surface>
+{
+	/// first point of the edge
+	vec3 a;
+	/// reference radius
+	double r;
+	/// precomputed edge vector and edge vector divided by its squared length as in distance_surface::update_edge_precomputations
+	vec3 edge_vector, edge_vector_inv_length;
+	constexpr distance_surface(const vec3& _a, const vec3& b, double _r)
+		: a(_a), r(_r), edge_vector(b - _a), edge_vector_inv_length((1 / dot(b - _a, b - _a))*(b - _a)) {}
+	/// mirrors distance_surface::evaluate in distance_surface.cxx
+	template <typename P>
+	double evaluate(const P& p) const
+	{
+		double f_p = std::numeric_limits<double>::infinity();
+
+		// Task 2.2: Use the same function of p as your implementation in distance_surface.cxx.
+
+		return f_p;
+	}
+	double get_lipschitz_bound() const { return 1; }
+};
+
+/// minimum of two children
+template <typename A, typename B>
+struct union_node : public expression<union_node<A, B> >
+{
+	A a;
+	B b;
+	constexpr union_node(const A& _a, const B& _b) : a(_a), b(_b) {}
+	template <typename P>
+	double evaluate(const P& p) const { return std::min(a.evaluate(p), b.evaluate(p)); }
+	double get_lipschitz_bound() const { return std::max(a.get_lipschitz_bound(), b.get_lipschitz_bound()); }
+};
+
+/// maximum of two children
+template <typename A, typename B>
+struct intersection_node : public expression<intersection_node<A, B> >
+{
+	A a;
+	B b;
+	constexpr intersection_node(const A& _a, const B& _b) : a(_a), b(_b) {}
+	template <typename P>
+	double evaluate(const P& p) const { return std::max(a.evaluate(p), b.evaluate(p)); }
+	double get_lipschitz_bound() const { return std::max(a.get_lipschitz_bound(), b.get_lipschitz_bound()); }
+};
+
+/// first child with the second child removed
+template <typename A, typename B>
+struct difference_node : public expression<difference_node<A, B> >
+{
+	A a;
+	B b;
+	constexpr difference_node(const A& _a, const B& _b) : a(_a), b(_b) {}
+	template <typename P>
+	double evaluate(const P& p) const { return std::max(a.evaluate(p), -b.evaluate(p)); }
+	double get_lipschitz_bound() const { return std::max(a.get_lipschitz_bound(), b.get_lipschitz_bound()); }
+};
+
+/// rotation by angle in degrees around axis, which is not normalized just as in the scene tree
+template <typename C>
+struct rotation : public expression<rotation<C> >
+{
+	vec3 axis;
+	double angle;
+	C child;
+	constexpr rotation(const vec3& _axis, double _angle, const C& _child) : axis(_axis), angle(_angle), child(_child) {}
+	/// cos and sin of the constant angle are folded by the compiler
+	template <typename P>
+	double evaluate(const P& p) const
+	{
+		double ang = angle*(-.1745329252e-1);
+		double c = std::cos(ang), s = std::sin(ang);
+		double d = p(0)*axis.x + p(1)*axis.y + p(2)*axis.z;
+		double x0 = p(0) - d*axis.x, x1 = p(1) - d*axis.y, x2 = p(2) - d*axis.z;
+		return child.evaluate(P(
+			d*axis.x + c*x0 + s*(axis.y*x2 - axis.z*x1),
+			d*axis.y + c*x1 + s*(axis.z*x0 - axis.x*x2),
+			d*axis.z + c*x2 + s*(axis.x*x1 - axis.y*x0)));
+	}
+	double get_lipschitz_bound() const { return child.get_lipschitz_bound(); }
+};
+
+template <typename C>
+struct translation : public expression<translation<C> >
+{
+	vec3 delta;
+	C child;
+	constexpr translation(const vec3& _delta, const C& _child) : delta(_delta), child(_child) {}
+	template <typename P>
+	double evaluate(const P& p) const { return child.evaluate(P(p(0) - delta.x, p(1) - delta.y, p(2) - delta.z)); }
+	double get_lipschitz_bound() const { return child.get_lipschitz_bound(); }
+};
+
+template <typename C>
+struct scaling : public expression<scaling<C> >
+{
+	vec3 inv_scale;
+	C child;
+	constexpr scaling(const vec3& scale, const C& _child) : inv_scale(1 / scale.x, 1 / scale.y, 1 / scale.z), child(_child) {}
+	template <typename P>
+	double evaluate(const P& p) const { return child.evaluate(P(p(0)*inv_scale.x, p(1)*inv_scale.y, p(2)*inv_scale.z)); }
+	/// the inverse scaling stretches the gradient of the child by at most the largest |1/s_i|
+	double get_lipschitz_bound() const
+	{
+		return std::max(std::abs(inv_scale.x), std::max(std::abs(inv_scale.y), std::abs(inv_scale.z)))*child.get_lipschitz_bound();
+	}
+};
+
+template <typename C>
+struct uniform_scaling : public expression<uniform_scaling<C> >
+{
+	double inv_scale;
+	C child;
+	constexpr uniform_scaling(double scale, const C& _child) : inv_scale(1 / scale), child(_child) {}
+	template <typename P>
+	double evaluate(const P& p) const { return child.evaluate(P(inv_scale*p(0), inv_scale*p(1), inv_scale*p(2))); }
+	double get_lipschitz_bound() const { return std::abs(inv_scale)*child.get_lipschitz_bound(); }
+};
+
+template <typename C>
+struct shear : public expression<shear<C> >
+{
+	double h_xy, h_xz, h_yz;
+	C child;
+	constexpr shear(double _h_xy, double _h_xz, double _h_yz, const C& _child) : h_xy(_h_xy), h_xz(_h_xz), h_yz(_h_yz), child(_child) {}
+	template <typename P>
+	double evaluate(const P& p) const { return child.evaluate(P(p(0) - h_xy*p(1) - h_xz*p(2), p(1) - h_yz*p(2), p(2))); }
+	/// bound the norm of the inverse shear matrix by its Frobenius norm
+	double get_lipschitz_bound() const { return std::sqrt(3 + h_xy*h_xy + h_xz*h_xz + h_yz*h_yz)*child.get_lipschitz_bound(); }
+};
+
+template <typename A, typename B>
+constexpr union_node<A, B> operator | (const expression<A>& a, const expression<B>& b) { return union_node<A, B>(a.derived(), b.derived()); }
+template <typename A, typename B>
+constexpr intersection_node<A, B> operator & (const expression<A>& a, const expression<B>& b) { return intersection_node<A, B>(a.derived(), b.derived()); }
+template <typename A, typename B>
+constexpr difference_node<A, B> operator - (const expression<A>& a, const expression<B>& b) { return difference_node<A, B>(a.derived(), b.derived()); }
+
+/// rotate child by angle in degrees around the axis (nx,ny,nz)
+template <typename C>
+constexpr rotation<C> make_rotation(double angle, double nx, double ny, double nz, const expression<C>& child) { return rotation<C>(vec3(nx, ny, nz), angle, child.derived()); }
+template <typename C>
+constexpr translation<C> make_translation(double dx, double dy, double dz, const expression<C>& child) { return translation<C>(vec3(dx, dy, dz), child.derived()); }
+template <typename C>
+constexpr scaling<C> make_scaling(double sx, double sy, double sz, const expression<C>& child) { return scaling<C>(vec3(sx, sy, sz), child.derived()); }
+template <typename C>
+constexpr uniform_scaling<C> make_uniform_scaling(double s, const expression<C>& child) { return uniform_scaling<C>(s, child.derived()); }
+template <typename C>
+constexpr shear<C> make_shear(double h_xy, double h_xz, double h_yz, const expression<C>& child) { return shear<C>(h_xy, h_xz, h_yz, child.derived()); }
+/// distance surface of the edge from (ax,ay,az) to (bx,by,bz) with radius r
+constexpr distance_surface make_distance_surface(double ax, double ay, double az, double bx, double by, double bz, double r)
+{
+	return distance_surface(vec3(ax, ay, az), vec3(bx, by, bz), r);
+}
+
+}
+
+/// adapts a static scene E to a primitive of the scene tree
+template <typename E, typename T = double>
+class static_implicit : public implicit_primitive<T>
+{
+public:
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+protected:
+	/// the scene
+	E scene;
+public:
+	/// construct from the scene
+	static_implicit(const E& _scene) : scene(_scene) {}
+	/// returns "static_implicit"
+	std::string get_type_name() const { return "static_implicit"; }
+	/// evaluate the inlined scene
+	T evaluate(const pnt_type& p) const { return T(scene.evaluate(p)); }
+	/// evaluate the inlined scene in a loop per block instead of a virtual call per point
+	void evaluate_batch(const std::vector<pnt_type>& ps, std::vector<T>& vs) const
+	{
+		const int block_size = 256;
+		vs.resize(ps.size());
+		parallel_for(0, int((ps.size() + block_size - 1) / block_size), [&](int b) {
+			size_t end = std::min(ps.size(), size_t(b + 1)*block_size);
+			for (size_t i = size_t(b)*block_size; i < end; ++i)
+				vs[i] = T(scene.evaluate(ps[i]));
+		});
+	}
+	/// return the Lipschitz bound of the scene
+	T get_lipschitz_bound() const { return T(scene.get_lipschitz_bound()); }
+};
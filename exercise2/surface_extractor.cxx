@@ -0,0 +1,1157 @@
+#include "surface_extractor.h"
+#include "parallel_for.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+/** marching cubes triangle table that is generated from the cube faces instead of being
+    listed explicitly. On each face the sign changing edges are connected by segments that
+    separate the negative corners, which resolves ambiguous faces identically in both
+    cubes sharing the face. The segments of all faces are chained into loops that are
+    triangulated as fans. Corner c has the coordinates (c&1, (c>>1)&1, (c>>2)&1) and the
+    edges along axis a have the indices 4*a+r, where r combines the two other coordinates
+    of the lower corner in increasing axis order. */
+struct marching_cubes_table
+{
+	int8_t triangles[256][16];
+
+	/// return the index of the edge connecting the corners u and v that differ in one bit
+	static int get_edge(int u, int v)
+	{
+		int c0 = std::min(u, v), a = (u ^ v) == 1 ? 0 : ((u ^ v) == 2 ? 1 : 2);
+		int o0 = a == 0 ? 1 : 0, o1 = a == 2 ? 1 : 2;
+		return 4 * a + ((c0 >> o0) & 1) + 2 * ((c0 >> o1) & 1);
+	}
+	marching_cubes_table()
+	{
+		// corners of the six faces in counter clockwise order seen from outside
+		int faces[6][4];
+		for (int a = 0; a < 3; ++a) {
+			int o0 = a == 0 ? 1 : 0, o1 = a == 2 ? 1 : 2;
+			for (int s = 0; s < 2; ++s) {
+				int* f = faces[2 * a + s];
+				f[0] = s << a;
+				f[1] = (s << a) | (1 << o0);
+				f[2] = (s << a) | (1 << o0) | (1 << o1);
+				f[3] = (s << a) | (1 << o1);
+				// the cycle (o0,o1) is counter clockwise around +a exactly if (a,o0,o1) is an even permutation
+				bool ccw_around_positive_a = (a != 1);
+				if (ccw_around_positive_a != (s == 1))
+					std::swap(f[1], f[3]);
+			}
+		}
+		for (int cube_case = 0; cube_case < 256; ++cube_case) {
+			int next[12];
+			std::fill(next, next + 12, -1);
+			for (int fi = 0; fi < 6; ++fi) {
+				const int* f = faces[fi];
+				// classify the face edges walked counter clockwise as entries into or exits from the negative region
+				int type[4];
+				for (int k = 0; k < 4; ++k)
+					type[k] = int((cube_case >> f[(k + 1) % 4]) & 1) - int((cube_case >> f[k]) & 1);
+				// connect each entry with the following exit such that the negative corners are separated on ambiguous faces
+				for (int k = 0; k < 4; ++k) {
+					if (type[k] != 1)
+						continue;
+					int m = (k + 1) % 4;
+					while (type[m] != -1)
+						m = (m + 1) % 4;
+					next[get_edge(f[k], f[(k + 1) % 4])] = get_edge(f[m], f[(m + 1) % 4]);
+				}
+			}
+			int nr = 0;
+			bool visited[12] = { false };
+			for (int e = 0; e < 12; ++e) {
+				if (next[e] == -1 || visited[e])
+					continue;
+				int loop[12], n = 0;
+				for (int f = e; f != -1 && !visited[f]; f = next[f]) {
+					visited[f] = true;
+					loop[n++] = f;
+				}
+				for (int k = 1; k + 1 < n; ++k) {
+					triangles[cube_case][nr++] = int8_t(loop[0]);
+					triangles[cube_case][nr++] = int8_t(loop[k]);
+					triangles[cube_case][nr++] = int8_t(loop[k + 1]);
+				}
+			}
+			for (; nr < 16; ++nr)
+				triangles[cube_case][nr] = -1;
+		}
+	}
+};
+
+/** quadric error functions of a batch of dual contouring cells stored as structure of
+    arrays. Each solver stage is a branch free loop over all cells of the batch such that
+    the compiler can vectorize it. The quadrics are expressed relative to the mass point
+    of the edge crossings and solved with a pseudo inverse computed from a cyclic Jacobi
+    eigen decomposition. */
+struct qef_batch
+{
+	/// number of cells per batch
+	static const unsigned capacity = 64;
+	/// number of cells in the batch
+	unsigned size;
+	/// symmetric matrices A = sum n n^T
+	double A[3][3][capacity];
+	/// right hand sides b = sum n (n . (p - mass))
+	double b[3][capacity];
+	/// mass points of the edge crossings
+	double mass[3][capacity];
+	/// minimum corners of the cells
+	double cell_min[3][capacity];
+	/// eigenvectors as columns
+	double V[3][3][capacity];
+	/// resulting vertex locations
+	double x[3][capacity];
+
+	/// remove all cells
+	void clear() { size = 0; }
+	/// add a cell with n edge crossings ps and normals ns and return its index in the batch
+	template <typename P, typename N>
+	unsigned add_cell(const P* const* ps, const N* const* ns, int n, const P& cell_min_pnt)
+	{
+		unsigned l = size++;
+		double m[3] = { 0, 0, 0 };
+		for (int e = 0; e < n; ++e)
+			for (int r = 0; r < 3; ++r)
+				m[r] += (*ps[e])(r);
+		for (int r = 0; r < 3; ++r) {
+			mass[r][l] = m[r] / n;
+			cell_min[r][l] = cell_min_pnt(r);
+			b[r][l] = 0;
+			for (int c = 0; c < 3; ++c)
+				A[r][c][l] = 0;
+		}
+		for (int e = 0; e < n; ++e) {
+			const N& nl = *ns[e];
+			double d = 0;
+			for (int r = 0; r < 3; ++r)
+				d += nl(r)*((*ps[e])(r) - mass[r][l]);
+			for (int r = 0; r < 3; ++r) {
+				b[r][l] += nl(r)*d;
+				for (int c = 0; c < 3; ++c)
+					A[r][c][l] += nl(r)*nl(c);
+			}
+		}
+		return l;
+	}
+	/// apply a Jacobi rotation in the (p,q) plane to all matrices that annihilates their (p,q) entries
+	template <int p, int q>
+	void rotate()
+	{
+		const int o = 3 - p - q;
+		for (unsigned l = 0; l < size; ++l) {
+			double apq = A[p][q][l], app = A[p][p][l], aqq = A[q][q][l];
+			// rotations are computed for all cells and discarded for the ones without off diagonal entry to keep the loop free of branches
+			bool active = std::abs(apq) > 1e-30;
+			double theta = (aqq - app) / (2 * (active ? apq : 1.0));
+			double t = std::copysign(1.0, theta) / (std::abs(theta) + sqrt(theta*theta + 1));
+			t = active ? t : 0;
+			double c = 1 / sqrt(t*t + 1), s = t*c;
+			double aop = A[o][p][l], aoq = A[o][q][l];
+			A[p][p][l] = app - t*apq;
+			A[q][q][l] = aqq + t*apq;
+			A[p][q][l] = A[q][p][l] = 0;
+			A[o][p][l] = A[p][o][l] = c*aop - s*aoq;
+			A[o][q][l] = A[q][o][l] = s*aop + c*aoq;
+			for (int k = 0; k < 3; ++k) {
+				double vkp = V[k][p][l], vkq = V[k][q][l];
+				V[k][p][l] = c*vkp - s*vkq;
+				V[k][q][l] = s*vkp + c*vkq;
+			}
+		}
+	}
+	/// diagonalize all matrices with nr_sweeps sweeps of Jacobi rotations
+	void diagonalize(unsigned nr_sweeps)
+	{
+		for (int r = 0; r < 3; ++r)
+			for (int c = 0; c < 3; ++c)
+				for (unsigned l = 0; l < size; ++l)
+					V[r][c][l] = r == c ? 1 : 0;
+		for (unsigned sweep = 0; sweep < nr_sweeps; ++sweep) {
+			rotate<0, 1>();
+			rotate<0, 2>();
+			rotate<1, 2>();
+		}
+	}
+	/// solve all quadrics with the eigenvalues below threshold times the largest one truncated and clamp the results to the cells of the given extent
+	void solve(unsigned nr_sweeps, double threshold, const double cell_extent[3])
+	{
+		diagonalize(nr_sweeps);
+		for (unsigned l = 0; l < size; ++l) {
+			double max_eigenvalue = std::max(std::abs(A[0][0][l]), std::max(std::abs(A[1][1][l]), std::abs(A[2][2][l])));
+			double y[3] = { mass[0][l], mass[1][l], mass[2][l] };
+			for (int e = 0; e < 3; ++e) {
+				double lambda = A[e][e][l];
+				bool keep = std::abs(lambda) > threshold*max_eigenvalue && lambda != 0;
+				double coefficient = keep ? (V[0][e][l] * b[0][l] + V[1][e][l] * b[1][l] + V[2][e][l] * b[2][l]) / (keep ? lambda : 1.0) : 0;
+				for (int r = 0; r < 3; ++r)
+					y[r] += coefficient*V[r][e][l];
+			}
+			for (int r = 0; r < 3; ++r)
+				x[r][l] = std::max(cell_min[r][l], std::min(cell_min[r][l] + cell_extent[r], y[r]));
+		}
+	}
+};
+
+}
+
+/// remove all vertices and triangles
+void extracted_mesh::clear()
+{
+	positions.clear();
+	normals.clear();
+	triangles.clear();
+	colors.clear();
+}
+
+/// return the unnormalized normal of triangle t
+extracted_mesh::vtx_type extracted_mesh::compute_face_normal(size_t t) const
+{
+	const vtx_type& p0 = positions[triangles[3 * t]];
+	return cross(positions[triangles[3 * t + 1]] - p0, positions[triangles[3 * t + 2]] - p0);
+}
+
+/// write vertices, normals and faces in obj format, offsetting indices by index_offset; vertices are followed by their rgb color if colors are given
+void extracted_mesh::write_obj(std::ostream& os, unsigned index_offset, const color_evaluation_interface* color_func) const
+{
+	const std::vector<vtx_type>* clrs = colors.size() == positions.size() && !colors.empty() ? &colors : 0;
+	std::vector<vtx_type> evaluated_colors;
+	if (!clrs && color_func && !positions.empty()) {
+		std::vector<cgv::math::fvec<double, 3> > ps(positions.size());
+		for (size_t v = 0; v < positions.size(); ++v)
+			ps[v] = cgv::math::fvec<double, 3>(positions[v]);
+		std::vector<double> vs;
+		color_func->evaluate_batch_and_colors(ps, vs, evaluated_colors);
+		clrs = &evaluated_colors;
+	}
+	for (size_t v = 0; v < positions.size(); ++v) {
+		const vtx_type& p = positions[v];
+		os << "v " << p(0) << " " << p(1) << " " << p(2);
+		if (clrs)
+			os << " " << (*clrs)[v](0) << " " << (*clrs)[v](1) << " " << (*clrs)[v](2);
+		os << "\n";
+	}
+	for (const vtx_type& n : normals)
+		os << "vn " << n(0) << " " << n(1) << " " << n(2) << "\n";
+	for (size_t t = 0; t < triangles.size(); t += 3) {
+		os << "f";
+		for (int c = 0; c < 3; ++c) {
+			unsigned vi = triangles[t + c] + index_offset + 1;
+			if (normals.empty())
+				os << " " << vi;
+			else
+				os << " " << vi << "//" << vi;
+		}
+		os << "\n";
+	}
+}
+
+/// append vertices, normals and colors
+void extracted_mesh_sink::add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n)
+{
+	mesh.positions.insert(mesh.positions.end(), ps, ps + n);
+	if (ns)
+		mesh.normals.insert(mesh.normals.end(), ns, ns + n);
+	if (cs)
+		mesh.colors.insert(mesh.colors.end(), cs, cs + n);
+}
+
+/// append triangles
+void extracted_mesh_sink::add_triangles(const uint32_t* vis, size_t n)
+{
+	mesh.triangles.insert(mesh.triangles.end(), vis, vis + 3 * n);
+}
+
+/// write vertices followed by their colors if given and normals
+void obj_mesh_sink::add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n)
+{
+	if (ns)
+		has_normals = true;
+	for (size_t v = 0; v < n; ++v) {
+		os << "v " << ps[v](0) << " " << ps[v](1) << " " << ps[v](2);
+		if (cs)
+			os << " " << cs[v](0) << " " << cs[v](1) << " " << cs[v](2);
+		os << "\n";
+	}
+	if (ns)
+		for (size_t v = 0; v < n; ++v)
+			os << "vn " << ns[v](0) << " " << ns[v](1) << " " << ns[v](2) << "\n";
+}
+
+/// write faces
+void obj_mesh_sink::add_triangles(const uint32_t* vis, size_t n)
+{
+	for (size_t t = 0; t < 3 * n; t += 3) {
+		os << "f";
+		for (int c = 0; c < 3; ++c) {
+			unsigned vi = vis[t + c] + index_offset + 1;
+			if (has_normals)
+				os << " " << vi << "//" << vi;
+			else
+				os << " " << vi;
+		}
+		os << "\n";
+	}
+}
+
+/// construct with marching cubes and gradient normals
+surface_extractor::surface_extractor() :
+	dual_contouring(false), root_method(RRM_SECANT), max_nr_root_iters(8), epsilon(1e-6), grid_epsilon(0.01),
+	normal_mode(ENM_GRADIENT), normal_threshold(0.8), consistency_threshold(0.01), max_nr_iters(10), extract_colors(false), lipschitz_bound(0), cancel_flag(0),
+	func(0), batch_func(0), color_func(0), res(0), sampled_in_band(false)
+{
+}
+
+/// return the triangles of the marching cubes case given by the sign bits of the 8 cube corners as edge indices terminated by -1
+const int8_t* surface_extractor::get_marching_cubes_case(unsigned cube_case)
+{
+	static marching_cubes_table table;
+	return table.triangles[cube_case];
+}
+
+/// return the location of sample (i,j,k)
+surface_extractor::pnt_type surface_extractor::get_location(unsigned i, unsigned j, unsigned k) const
+{
+	const pnt_type& p0 = box.get_min_pnt();
+	return pnt_type(p0(0) + i*cell_extent(0), p0(1) + j*cell_extent(1), p0(2) + k*cell_extent(2));
+}
+
+/// evaluate the function at all points, using the batch interface if available
+void surface_extractor::evaluate_batch(const std::vector<pnt_type>& ps, std::vector<double>& vs) const
+{
+	if (batch_func) {
+		batch_func->evaluate_batch(ps, vs);
+		return;
+	}
+	vs.resize(ps.size());
+	const int block_size = 256;
+	parallel_for(0, int((ps.size() + block_size - 1) / block_size), [&](int b) {
+		size_t end = std::min(ps.size(), size_t(b + 1)*block_size);
+		for (size_t i = size_t(b)*block_size; i < end; ++i)
+			vs[i] = func->evaluate(ps[i].to_vec());
+	});
+}
+
+/// set the function and its batch and color interfaces
+void surface_extractor::set_function(const function_type* f)
+{
+	func = f;
+	batch_func = dynamic_cast<const batch_evaluation_interface*>(f);
+	color_func = extract_colors ? dynamic_cast<const color_evaluation_interface*>(f) : 0;
+}
+
+/// evaluate the colors at the points ps with the color interface
+void surface_extractor::evaluate_colors(const std::vector<pnt_type>& ps, std::vector<extracted_mesh::vtx_type>& colors) const
+{
+	std::vector<double> vs;
+	color_func->evaluate_batch_and_colors(ps, vs, colors);
+}
+
+/// evaluate the colors of crossings kept from an extraction without colors, or release them if no colors are extracted
+void surface_extractor::update_crossing_colors()
+{
+	if (!color_func || dual_contouring)
+		crossing_colors.clear();
+	else if (crossing_colors.size() != crossing_points.size())
+		evaluate_colors(crossing_points, crossing_colors);
+}
+
+/// sample the function at all grid points, or in the narrow band only if a Lipschitz bound is given
+void surface_extractor::sample_values()
+{
+	if (lipschitz_bound > 0) {
+		sample_narrow_band();
+		return;
+	}
+	sampled_in_band = false;
+	values.resize(size_t(res)*res*res);
+	std::vector<pnt_type> ps(size_t(res)*res);
+	std::vector<double> vs;
+	for (unsigned k = 0; k < res && !is_cancelled(); ++k) {
+		for (unsigned j = 0; j < res; ++j)
+			for (unsigned i = 0; i < res; ++i)
+				ps[i + size_t(res)*j] = get_location(i, j, k);
+		evaluate_batch(ps, vs);
+		for (size_t l = 0; l < ps.size(); ++l)
+			values[get_index(0, 0, k) + l] = float(vs[l]);
+	}
+}
+
+/** sample the function in the narrow band of bricks whose center value does not rule out
+    the surface under the Lipschitz bound. The band reaches two cells beyond these bricks,
+    such that the central differences of grid normals next to the surface use sampled values
+    only. The dense samples are filled from the band and get the signed background of their
+    brick outside of it, which has the correct sign up to the brick boundary. */
+void surface_extractor::sample_narrow_band()
+{
+	const unsigned bs = sparse_brick_volume<float>::brick_size;
+	band.resize(box, res, res, res, float(lipschitz_bound*bs*cell_extent.length()));
+	band.build_narrow_band([this](const pnt_type& p) { return func->evaluate(p.to_vec()); }, 2, lipschitz_bound);
+	sampled_in_band = true;
+	values.resize(size_t(res)*res*res);
+	parallel_for(0, int(res), [&](int k) {
+		for (unsigned j = 0; j < res; ++j)
+			for (unsigned i = 0; i < res; ++i)
+				values[get_index(i, j, k)] = band.get_value(i, j, unsigned(k));
+	});
+}
+
+/// collect all edges whose end points have different signs
+void surface_extractor::collect_crossings()
+{
+	// append the sign changing edges starting at the samples of the given range
+	auto collect = [this](const unsigned lo[3], const unsigned hi[3], std::vector<uint64_t>& sc) {
+		for (unsigned k = lo[2]; k < hi[2]; ++k)
+			for (unsigned j = lo[1]; j < hi[1]; ++j)
+				for (unsigned i = lo[0]; i < hi[0]; ++i) {
+					size_t idx = get_index(i, j, k);
+					bool neg = values[idx] < 0;
+					if (i + 1 < res && (values[idx + 1] < 0) != neg)
+						sc.push_back(3 * uint64_t(idx));
+					if (j + 1 < res && (values[idx + res] < 0) != neg)
+						sc.push_back(3 * uint64_t(idx) + 1);
+					if (k + 1 < res && (values[idx + size_t(res)*res] < 0) != neg)
+						sc.push_back(3 * uint64_t(idx) + 2);
+				}
+	};
+	std::vector<std::vector<uint64_t> > part_crossings;
+	if (sampled_in_band) {
+		// bricks outside of the band have a constant sign up to the first samples of their neighbors, so only the edges starting in band bricks can change sign
+		const unsigned bs = sparse_brick_volume<float>::brick_size;
+		std::vector<sparse_brick_volume<float>::brick_iterator> bricks;
+		for (auto it = band.begin_bricks(); it != band.end_bricks(); ++it)
+			bricks.push_back(it);
+		part_crossings.resize(bricks.size());
+		parallel_for(0, int(bricks.size()), [&](int b) {
+			unsigned lo[3], hi[3];
+			for (int c = 0; c < 3; ++c) {
+				lo[c] = bricks[b].get_origin(c);
+				hi[c] = std::min(lo[c] + bs, res);
+			}
+			collect(lo, hi, part_crossings[b]);
+		});
+		band = sparse_brick_volume<float>();
+	}
+	else {
+		part_crossings.resize(res);
+		parallel_for(0, int(res), [&](int k) {
+			unsigned lo[3] = { 0, 0, unsigned(k) }, hi[3] = { res, res, unsigned(k) + 1 };
+			collect(lo, hi, part_crossings[k]);
+		});
+	}
+	crossings.clear();
+	for (auto& sc : part_crossings) {
+		crossings.insert(crossings.end(), sc.begin(), sc.end());
+		std::vector<uint64_t>().swap(sc);
+	}
+	edge_crossing.assign(3 * values.size(), uint32_t(-1));
+	for (size_t c = 0; c < crossings.size(); ++c)
+		edge_crossing[crossings[c]] = uint32_t(c);
+}
+
+/** locate the roots along all given edges from p0s[c] to p0s[c]+dirs[c] with function
+    values fa[c] and fb[c] of opposite signs at their end points together. In each round the
+    points of all edges that did not converge yet are evaluated as one batch. Each edge keeps
+    a bracket [ta,tb] of its root, which is shrunk with bisection, the Illinois variant of
+    the secant method or Newton steps along the edge that fall back to bisection when
+    leaving the bracket. If colors are requested, each round evaluates values and colors
+    together and every edge keeps the color of its last evaluated point, which is the final
+    root unless the edge ran out of iterations or its root was clamped. Only the colors of
+    these edges are evaluated again at their final points. */
+void surface_extractor::refine_roots(const std::vector<pnt_type>& p0s, const std::vector<vec_type>& dirs, std::vector<double>& fa, std::vector<double>& fb, std::vector<pnt_type>& points, std::vector<extracted_mesh::vtx_type>* colors) const
+{
+	size_t n = p0s.size();
+	std::vector<double> ta(n, 0), tb(n, 1), ts(n);
+	std::vector<int8_t> last_side(n, 0);
+	for (size_t c = 0; c < n; ++c)
+		ts[c] = fa[c] / (fa[c] - fb[c]);
+	std::vector<uint32_t> active(n);
+	for (size_t c = 0; c < n; ++c)
+		active[c] = uint32_t(c);
+	std::vector<pnt_type> ps;
+	std::vector<double> vs;
+	std::vector<vec_type> gs;
+	std::vector<extracted_mesh::vtx_type> clrs;
+	// parameter of the point whose color is stored per edge
+	std::vector<double> colored_ts;
+	if (colors) {
+		colors->resize(n);
+		colored_ts.assign(n, -1);
+	}
+	for (unsigned iter = 0; iter < max_nr_root_iters && !active.empty() && !is_cancelled(); ++iter) {
+		ps.resize(active.size());
+		for (size_t l = 0; l < active.size(); ++l)
+			ps[l] = p0s[active[l]] + ts[active[l]] * dirs[active[l]];
+		if (colors)
+			color_func->evaluate_batch_and_colors(ps, vs, clrs);
+		else
+			evaluate_batch(ps, vs);
+		if (root_method == RRM_NEWTON) {
+			gs.resize(ps.size());
+			parallel_for(0, int((ps.size() + 255) / 256), [&](int b) {
+				for (size_t l = size_t(b) * 256; l < std::min(ps.size(), size_t(b + 1) * 256); ++l)
+					gs[l] = vec_type(func->evaluate_gradient(ps[l].to_vec()));
+			});
+		}
+		size_t nr_active = 0;
+		for (size_t l = 0; l < active.size(); ++l) {
+			uint32_t c = active[l];
+			double v = vs[l], t = ts[c];
+			if (colors) {
+				(*colors)[c] = clrs[l];
+				colored_ts[c] = t;
+			}
+			if (std::abs(v) <= epsilon)
+				continue;
+			// shrink the bracket, keeping fa and fb of opposite signs
+			int side;
+			if ((v < 0) == (fa[c] < 0)) {
+				ta[c] = t;
+				fa[c] = v;
+				side = -1;
+			}
+			else {
+				tb[c] = t;
+				fb[c] = v;
+				side = 1;
+			}
+			if (tb[c] - ta[c] < 1e-9)
+				continue;
+			switch (root_method) {
+			case RRM_BISECTION:
+				t = 0.5*(ta[c] + tb[c]);
+				break;
+			case RRM_SECANT:
+				// Illinois modification halves the value of an end point that is retained twice
+				if (side == last_side[c]) {
+					if (side == -1)
+						fb[c] *= 0.5;
+					else
+						fa[c] *= 0.5;
+				}
+				t = (ta[c] * fb[c] - tb[c] * fa[c]) / (fb[c] - fa[c]);
+				break;
+			case RRM_NEWTON: {
+				double derivative = dot(gs[l], dirs[c]);
+				t = derivative != 0 ? t - v / derivative : -1;
+				if (!(t > ta[c] && t < tb[c]))
+					t = 0.5*(ta[c] + tb[c]);
+				break;
+			}
+			}
+			last_side[c] = int8_t(side);
+			ts[c] = t;
+			active[nr_active++] = c;
+		}
+		active.resize(nr_active);
+	}
+	points.resize(n);
+	double t_min = std::min(grid_epsilon, 0.5), t_max = 1 - t_min;
+	std::vector<uint32_t> uncolored;
+	for (size_t c = 0; c < n; ++c) {
+		double t = std::max(t_min, std::min(t_max, ts[c]));
+		points[c] = p0s[c] + t * dirs[c];
+		if (colors && t != colored_ts[c])
+			uncolored.push_back(uint32_t(c));
+	}
+	if (uncolored.empty())
+		return;
+	ps.resize(uncolored.size());
+	for (size_t l = 0; l < uncolored.size(); ++l)
+		ps[l] = points[uncolored[l]];
+	evaluate_colors(ps, clrs);
+	for (size_t l = 0; l < uncolored.size(); ++l)
+		(*colors)[uncolored[l]] = clrs[l];
+}
+
+/// locate the surface along the sign changing edges of the grid starting at crossing first together
+void surface_extractor::refine_crossings(size_t first)
+{
+	size_t n = crossings.size() - first;
+	const size_t stride[3] = { 1, size_t(res), size_t(res)*res };
+	std::vector<pnt_type> p0s(n);
+	std::vector<vec_type> dirs(n);
+	std::vector<double> fa(n), fb(n);
+	parallel_for(0, int((n + 1023) / 1024), [&](int b) {
+		for (size_t c = size_t(b) * 1024; c < std::min(n, size_t(b + 1) * 1024); ++c) {
+			size_t idx = size_t(crossings[first + c] / 3);
+			int a = int(crossings[first + c] % 3);
+			unsigned i = unsigned(idx % res), j = unsigned((idx / res) % res), k = unsigned(idx / (size_t(res)*res));
+			p0s[c] = get_location(i, j, k);
+			dirs[c] = vec_type(0, 0, 0);
+			dirs[c](a) = cell_extent(a);
+			fa[c] = values[idx];
+			fb[c] = values[idx + stride[a]];
+		}
+	});
+	// only marching cubes vertices lie on the edge crossings
+	bool with_colors = color_func && !dual_contouring;
+	if (first == 0) {
+		crossing_colors.clear();
+		refine_roots(p0s, dirs, fa, fb, crossing_points, with_colors ? &crossing_colors : 0);
+		return;
+	}
+	std::vector<pnt_type> points;
+	std::vector<extracted_mesh::vtx_type> colors;
+	refine_roots(p0s, dirs, fa, fb, points, with_colors ? &colors : 0);
+	crossing_points.resize(first);
+	crossing_points.insert(crossing_points.end(), points.begin(), points.end());
+	// kept crossings have colors if the previous extraction captured them, otherwise update_crossing_colors evaluates all
+	if (!with_colors || crossing_colors.size() < first)
+		crossing_colors.clear();
+	else {
+		crossing_colors.resize(first);
+		crossing_colors.insert(crossing_colors.end(), colors.begin(), colors.end());
+	}
+}
+
+/// return the central difference gradient at sample (i,j,k), one sided at the border of the grid
+surface_extractor::vec_type surface_extractor::get_sample_gradient(unsigned i, unsigned j, unsigned k) const
+{
+	const unsigned coord[3] = { i, j, k };
+	const size_t stride[3] = { 1, size_t(res), size_t(res)*res };
+	size_t idx = get_index(i, j, k);
+	vec_type g;
+	for (int a = 0; a < 3; ++a) {
+		size_t lo = coord[a] > 0 ? idx - stride[a] : idx;
+		size_t hi = coord[a] + 1 < res ? idx + stride[a] : idx;
+		unsigned nr_steps = (coord[a] > 0 ? 1 : 0) + (coord[a] + 1 < res ? 1 : 0);
+		g(a) = (values[hi] - values[lo]) / (nr_steps*cell_extent(a));
+	}
+	return g;
+}
+
+/// trilinearly interpolate the sample gradients of the cell containing p
+surface_extractor::vec_type surface_extractor::interpolate_sample_gradient(const pnt_type& p) const
+{
+	unsigned coord[3];
+	double frac[3];
+	for (int a = 0; a < 3; ++a) {
+		double x = (p(a) - box.get_min_pnt()(a)) / cell_extent(a);
+		coord[a] = unsigned(std::max(0.0, std::min(double(res - 2), floor(x))));
+		frac[a] = std::max(0.0, std::min(1.0, x - coord[a]));
+	}
+	vec_type g(0, 0, 0);
+	for (int c = 0; c < 8; ++c) {
+		double w = ((c & 1) ? frac[0] : 1 - frac[0])*((c & 2) ? frac[1] : 1 - frac[1])*((c & 4) ? frac[2] : 1 - frac[2]);
+		g += w*get_sample_gradient(coord[0] + (c & 1), coord[1] + ((c >> 1) & 1), coord[2] + ((c >> 2) & 1));
+	}
+	return g;
+}
+
+/// compute normalized gradients at the edge crossings starting at crossing first from the function or from the samples in grid mode
+void surface_extractor::compute_crossing_normals(size_t first)
+{
+	crossing_normals.resize(crossing_points.size());
+	size_t n = crossing_points.size() - first;
+	parallel_for(0, int((n + 255) / 256), [&](int b) {
+		for (size_t c = first + size_t(b) * 256; c < std::min(crossing_points.size(), first + size_t(b + 1) * 256); ++c) {
+			vec_type g = normal_mode == ENM_GRID ? interpolate_sample_gradient(crossing_points[c]) :
+				vec_type(func->evaluate_gradient(crossing_points[c].to_vec()));
+			double l = g.length();
+			crossing_normals[c] = l > 0 ? g / l : g;
+		}
+	});
+}
+
+/// build the marching cubes mesh from the edge crossings
+void surface_extractor::build_marching_cubes_mesh(extracted_mesh& mesh) const
+{
+	mesh.positions.resize(crossing_points.size());
+	for (size_t c = 0; c < crossing_points.size(); ++c)
+		mesh.positions[c] = extracted_mesh::vtx_type(crossing_points[c]);
+	mesh.colors = crossing_colors;
+	// offsets of the lower corners of the 12 edges
+	size_t edge_offsets[12];
+	for (int e = 0; e < 12; ++e) {
+		int a = e / 4, o0 = a == 0 ? 1 : 0, o1 = a == 2 ? 1 : 2;
+		size_t offset[3] = { 0, 0, 0 };
+		offset[o0] = e & 1;
+		offset[o1] = (e >> 1) & 1;
+		edge_offsets[e] = 3 * (offset[0] + size_t(res)*(offset[1] + size_t(res)*offset[2])) + a;
+	}
+	std::vector<std::vector<uint32_t> > slab_triangles(res - 1);
+	parallel_for(0, int(res) - 1, [&](int k) {
+		std::vector<uint32_t>& st = slab_triangles[k];
+		for (unsigned j = 0; j + 1 < res; ++j)
+			for (unsigned i = 0; i + 1 < res; ++i) {
+				size_t idx = get_index(i, j, k);
+				unsigned cube_case = 0;
+				for (int c = 0; c < 8; ++c)
+					if (values[idx + (c & 1) + ((c >> 1) & 1)*size_t(res) + ((c >> 2) & 1)*size_t(res)*res] < 0)
+						cube_case |= 1 << c;
+				if (cube_case == 0 || cube_case == 255)
+					continue;
+				for (const int8_t* e = get_marching_cubes_case(cube_case); *e != -1; ++e)
+					st.push_back(edge_crossing[3 * idx + edge_offsets[*e]]);
+			}
+	});
+	mesh.triangles.clear();
+	for (auto& st : slab_triangles)
+		mesh.triangles.insert(mesh.triangles.end(), st.begin(), st.end());
+}
+
+/** compute the vertices of the given dual contouring cells from the edge crossings on their
+    edges by minimizing the sum of squared distances to the tangent planes at the crossings.
+    The quadrics are accumulated and solved in batches of qef_batch::capacity cells. */
+void surface_extractor::place_cell_vertices(const std::vector<size_t>& cells, std::vector<extracted_mesh::vtx_type>& vertices) const
+{
+	unsigned cr = res - 1;
+	const double extent[3] = { cell_extent(0), cell_extent(1), cell_extent(2) };
+	vertices.resize(cells.size());
+	std::unique_ptr<qef_batch> batch(new qef_batch);
+	for (size_t begin = 0; begin < cells.size(); begin += qef_batch::capacity) {
+		size_t end = std::min(cells.size(), begin + qef_batch::capacity);
+		batch->clear();
+		for (size_t ci = begin; ci < end; ++ci) {
+			unsigned i = unsigned(cells[ci] % cr), j = unsigned((cells[ci] / cr) % cr), k = unsigned(cells[ci] / (size_t(cr)*cr));
+			size_t idx = get_index(i, j, k);
+			const pnt_type* ps[12];
+			const vec_type* ns[12];
+			int n = 0;
+			for (int e = 0; e < 12; ++e) {
+				int a = e / 4, o0 = a == 0 ? 1 : 0, o1 = a == 2 ? 1 : 2;
+				size_t offset[3] = { 0, 0, 0 };
+				offset[o0] = e & 1;
+				offset[o1] = (e >> 1) & 1;
+				uint32_t c = edge_crossing[3 * (idx + offset[0] + size_t(res)*(offset[1] + size_t(res)*offset[2])) + a];
+				if (c == uint32_t(-1))
+					continue;
+				ps[n] = &crossing_points[c];
+				ns[n] = &crossing_normals[c];
+				++n;
+			}
+			batch->add_cell(ps, ns, n, get_location(i, j, k));
+		}
+		batch->solve(max_nr_iters, consistency_threshold, extent);
+		for (size_t ci = begin; ci < end; ++ci) {
+			unsigned l = unsigned(ci - begin);
+			vertices[ci] = extracted_mesh::vtx_type(float(batch->x[0][l]), float(batch->x[1][l]), float(batch->x[2][l]));
+		}
+	}
+}
+
+/// build the dual contouring mesh with one vertex per cell placed by minimizing the quadric of its edge crossings
+void surface_extractor::build_dual_contouring_mesh(extracted_mesh& mesh) const
+{
+	unsigned cr = res - 1;
+	std::vector<uint32_t> cell_vertex(size_t(cr)*cr*cr, uint32_t(-1));
+	std::vector<std::vector<extracted_mesh::vtx_type> > slab_vertices(cr);
+	std::vector<std::vector<size_t> > slab_cells(cr);
+	parallel_for(0, int(cr), [&](int k) {
+		for (unsigned j = 0; j < cr; ++j)
+			for (unsigned i = 0; i < cr; ++i) {
+				size_t idx = get_index(i, j, k);
+				bool neg = values[idx] < 0, active = false;
+				for (int c = 1; c < 8 && !active; ++c)
+					active = (values[idx + (c & 1) + ((c >> 1) & 1)*size_t(res) + ((c >> 2) & 1)*size_t(res)*res] < 0) != neg;
+				if (active)
+					slab_cells[k].push_back(i + size_t(cr)*(j + size_t(cr)*k));
+			}
+		place_cell_vertices(slab_cells[k], slab_vertices[k]);
+	});
+	mesh.positions.clear();
+	for (unsigned k = 0; k < cr; ++k) {
+		for (size_t l = 0; l < slab_cells[k].size(); ++l)
+			cell_vertex[slab_cells[k][l]] = uint32_t(mesh.positions.size() + l);
+		mesh.positions.insert(mesh.positions.end(), slab_vertices[k].begin(), slab_vertices[k].end());
+	}
+	// the cell vertices are placed off the edges, so their colors need an evaluation of their own
+	if (color_func && !mesh.positions.empty()) {
+		std::vector<pnt_type> ps(mesh.positions.size());
+		for (size_t v = 0; v < ps.size(); ++v)
+			ps[v] = pnt_type(mesh.positions[v]);
+		evaluate_colors(ps, mesh.colors);
+	}
+	// one quad per sign changing edge that connects the vertices of the four cells around the edge
+	mesh.triangles.clear();
+	for (uint64_t key : crossings) {
+		size_t idx = size_t(key / 3);
+		int a = int(key % 3), o0 = (a + 1) % 3, o1 = (a + 2) % 3;
+		unsigned coord[3] = { unsigned(idx % res), unsigned((idx / res) % res), unsigned(idx / (size_t(res)*res)) };
+		if (coord[o0] == 0 || coord[o1] == 0 || coord[o0] >= cr || coord[o1] >= cr)
+			continue;
+		static const int quad_offsets[4][2] = { { -1, -1 }, { 0, -1 }, { 0, 0 }, { -1, 0 } };
+		uint32_t quad[4];
+		for (int q = 0; q < 4; ++q) {
+			unsigned cc[3] = { coord[0], coord[1], coord[2] };
+			cc[o0] += quad_offsets[q][0];
+			cc[o1] += quad_offsets[q][1];
+			quad[q] = cell_vertex[cc[0] + size_t(cr)*(cc[1] + size_t(cr)*cc[2])];
+		}
+		// the quad faces along +a if the edge leaves the inside
+		if (!(values[idx] < 0))
+			std::swap(quad[1], quad[3]);
+		uint32_t tris[6] = { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] };
+		mesh.triangles.insert(mesh.triangles.end(), tris, tris + 6);
+	}
+}
+
+/// compute the normals of the mesh according to normal_mode
+void surface_extractor::compute_mesh_normals(extracted_mesh& mesh) const
+{
+	mesh.normals.clear();
+	switch (normal_mode) {
+	case ENM_FACE:
+		break;
+	case ENM_CORNER: {
+		mesh.normals.assign(mesh.positions.size(), extracted_mesh::vtx_type(0, 0, 0));
+		for (size_t t = 0; t < mesh.get_nr_triangles(); ++t) {
+			extracted_mesh::vtx_type n = mesh.compute_face_normal(t);
+			for (int c = 0; c < 3; ++c)
+				mesh.normals[mesh.triangles[3 * t + c]] += n;
+		}
+		for (auto& n : mesh.normals)
+			n.normalize();
+		break;
+	}
+	default:
+		mesh.normals.resize(mesh.positions.size());
+		if (!dual_contouring) {
+			for (size_t c = 0; c < crossing_normals.size(); ++c)
+				mesh.normals[c] = extracted_mesh::vtx_type(crossing_normals[c]);
+			break;
+		}
+		parallel_for(0, int((mesh.positions.size() + 255) / 256), [&](int b) {
+			for (size_t v = size_t(b) * 256; v < std::min(mesh.positions.size(), size_t(b + 1) * 256); ++v) {
+				const extracted_mesh::vtx_type& p = mesh.positions[v];
+				pnt_type q(p(0), p(1), p(2));
+				vec_type g = normal_mode == ENM_GRID ? interpolate_sample_gradient(q) : vec_type(func->evaluate_gradient(q.to_vec()));
+				g.normalize();
+				mesh.normals[v] = extracted_mesh::vtx_type(g);
+			}
+		});
+	}
+}
+
+/// extract the surface of f sampled with res^3 points in box into mesh and return whether a surface was found
+bool surface_extractor::extract(const function_type* f, const box_type& _box, unsigned _res, extracted_mesh& mesh)
+{
+	mesh.clear();
+	set_function(f);
+	box = _box;
+	res = _res;
+	crossings.clear();
+	if (!func || res < 2)
+		return false;
+	for (int c = 0; c < 3; ++c)
+		cell_extent(c) = box.get_extent()(c) / (res - 1);
+	sample_values();
+	if (is_cancelled()) {
+		clear();
+		return false;
+	}
+	collect_crossings();
+	if (crossings.empty())
+		return false;
+	refine_crossings();
+	if (is_cancelled()) {
+		clear();
+		return false;
+	}
+	if (needs_crossing_normals())
+		compute_crossing_normals();
+	else
+		crossing_normals.clear();
+	if (dual_contouring)
+		build_dual_contouring_mesh(mesh);
+	else
+		build_marching_cubes_mesh(mesh);
+	compute_mesh_normals(mesh);
+	return true;
+}
+
+/** update the last extraction after f changed inside the given boxes only. The corners of
+    all cells overlapping the boxes are marked and evaluated again. Crossings of edges without marked end
+    points are kept together with their points and normals, while the sign changing edges
+    with a marked end point are collected, appended and refined as one batch. Each such edge
+    is added by its lower end point if that one is marked and by its upper end point
+    otherwise. The mesh is built from scratch, which needs no further evaluations of f
+    except for gradient normals of dual contouring vertices. */
+bool surface_extractor::extract_incremental(const function_type* f, const box_type& _box, unsigned _res, const std::vector<box_type>& changed_boxes, extracted_mesh& mesh)
+{
+	if (f != func || _res != res || !(_box.get_min_pnt() == box.get_min_pnt()) || !(_box.get_max_pnt() == box.get_max_pnt()) ||
+		values.size() != size_t(res)*res*res || edge_crossing.size() != 3 * values.size() || crossing_points.size() < crossings.size())
+		return extract(f, _box, _res, mesh);
+	mesh.clear();
+	set_function(f);
+	// mark the grid points inside the changed boxes
+	std::vector<char> changed(values.size(), 0);
+	std::vector<size_t> changed_indices;
+	for (const box_type& cb : changed_boxes) {
+		unsigned lo[3], hi[3];
+		bool empty = false;
+		for (int a = 0; a < 3; ++a) {
+			// mark the corners of all cells overlapping the box, such that boxes thinner than a cell are not skipped
+			double l = std::max(0.0, floor((cb.get_min_pnt()(a) - box.get_min_pnt()(a)) / cell_extent(a)));
+			double h = std::min(double(res - 1), ceil((cb.get_max_pnt()(a) - box.get_min_pnt()(a)) / cell_extent(a)));
+			if (l > h)
+				empty = true;
+			else {
+				lo[a] = unsigned(l);
+				hi[a] = unsigned(h);
+			}
+		}
+		if (empty)
+			continue;
+		for (unsigned k = lo[2]; k <= hi[2]; ++k)
+			for (unsigned j = lo[1]; j <= hi[1]; ++j)
+				for (unsigned i = lo[0]; i <= hi[0]; ++i) {
+					size_t idx = get_index(i, j, k);
+					if (!changed[idx]) {
+						changed[idx] = 1;
+						changed_indices.push_back(idx);
+					}
+				}
+	}
+	std::vector<pnt_type> ps(changed_indices.size());
+	std::vector<double> vs;
+	for (size_t l = 0; l < changed_indices.size(); ++l) {
+		size_t idx = changed_indices[l];
+		ps[l] = get_location(unsigned(idx % res), unsigned((idx / res) % res), unsigned(idx / (size_t(res)*res)));
+	}
+	evaluate_batch(ps, vs);
+	for (size_t l = 0; l < changed_indices.size(); ++l)
+		values[changed_indices[l]] = float(vs[l]);
+	// keep the crossings of edges whose end points were not resampled
+	const size_t stride[3] = { 1, size_t(res), size_t(res)*res };
+	bool with_normals = crossing_normals.size() == crossing_points.size();
+	bool with_colors = color_func && !dual_contouring && crossing_colors.size() == crossing_points.size();
+	size_t nr_kept = 0;
+	for (size_t c = 0; c < crossings.size(); ++c) {
+		size_t idx = size_t(crossings[c] / 3);
+		int a = int(crossings[c] % 3);
+		edge_crossing[crossings[c]] = uint32_t(-1);
+		if (changed[idx] || changed[idx + stride[a]])
+			continue;
+		crossings[nr_kept] = crossings[c];
+		crossing_points[nr_kept] = crossing_points[c];
+		if (with_normals)
+			crossing_normals[nr_kept] = crossing_normals[c];
+		if (with_colors)
+			crossing_colors[nr_kept] = crossing_colors[c];
+		++nr_kept;
+	}
+	crossings.resize(nr_kept);
+	crossing_points.resize(nr_kept);
+	if (with_normals)
+		crossing_normals.resize(nr_kept);
+	if (with_colors)
+		crossing_colors.resize(nr_kept);
+	else
+		crossing_colors.clear();
+	// append the sign changing edges incident to resampled grid points
+	for (size_t idx : changed_indices) {
+		unsigned coord[3] = { unsigned(idx % res), unsigned((idx / res) % res), unsigned(idx / (size_t(res)*res)) };
+		bool neg = values[idx] < 0;
+		for (int a = 0; a < 3; ++a) {
+			if (coord[a] + 1 < res && (values[idx + stride[a]] < 0) != neg)
+				crossings.push_back(3 * uint64_t(idx) + a);
+			if (coord[a] > 0 && !changed[idx - stride[a]] && (values[idx - stride[a]] < 0) != neg)
+				crossings.push_back(3 * uint64_t(idx - stride[a]) + a);
+		}
+	}
+	for (size_t c = 0; c < crossings.size(); ++c)
+		edge_crossing[crossings[c]] = uint32_t(c);
+	if (crossings.empty())
+		return false;
+	refine_crossings(nr_kept);
+	update_crossing_colors();
+	if (needs_crossing_normals())
+		compute_crossing_normals(with_normals ? nr_kept : 0);
+	else
+		crossing_normals.clear();
+	if (dual_contouring)
+		build_dual_contouring_mesh(mesh);
+	else
+		build_marching_cubes_mesh(mesh);
+	compute_mesh_normals(mesh);
+	return true;
+}
+
+/** extract the marching cubes surface of f slice by slice. For each slab between two
+    adjacent slices the sign changing edges that were not processed before are refined as
+    one batch, their vertices are passed to the sink and the triangles of the slab are
+    emitted. Only the samples and edge vertex indices of the two slices bounding the slab
+    are kept, such that the memory grows with the square of the resolution. Vertex normals
+    are provided for gradient based normal modes only. */
+size_t surface_extractor::extract_streaming(const function_type* f, const box_type& _box, unsigned _res, mesh_sink& sink)
+{
+	clear();
+	set_function(f);
+	box = _box;
+	res = _res;
+	if (!func || res < 2)
+		return 0;
+	for (int c = 0; c < 3; ++c)
+		cell_extent(c) = box.get_extent()(c) / (res - 1);
+	bool with_normals = normal_mode == ENM_GRADIENT || normal_mode == ENM_CORNER_GRADIENT;
+	size_t slice_size = size_t(res)*res;
+	// samples and vertex indices of the x and y edges of the bottom and top slice of the current slab
+	std::vector<float> slice_values[2];
+	std::vector<uint32_t> slice_edges[2];
+	// vertex indices of the z edges of the current slab
+	std::vector<uint32_t> z_edges(slice_size);
+	std::vector<pnt_type> ps(slice_size);
+	std::vector<double> vs;
+	auto sample_slice = [&](unsigned k, std::vector<float>& slice) {
+		for (unsigned j = 0; j < res; ++j)
+			for (unsigned i = 0; i < res; ++i)
+				ps[i + size_t(res)*j] = get_location(i, j, k);
+		evaluate_batch(ps, vs);
+		slice.resize(slice_size);
+		for (size_t l = 0; l < slice_size; ++l)
+			slice[l] = float(vs[l]);
+	};
+	// edges of the current slab that still need a vertex
+	std::vector<pnt_type> p0s;
+	std::vector<vec_type> dirs;
+	std::vector<double> fa, fb;
+	std::vector<uint32_t*> targets;
+	auto add_edge = [&](const pnt_type& p0, int a, float v0, float v1, uint32_t* target) {
+		if ((v0 < 0) == (v1 < 0)) {
+			*target = uint32_t(-1);
+			return;
+		}
+		vec_type d(0, 0, 0);
+		d(a) = cell_extent(a);
+		p0s.push_back(p0);
+		dirs.push_back(d);
+		fa.push_back(v0);
+		fb.push_back(v1);
+		targets.push_back(target);
+	};
+	auto add_slice_edges = [&](unsigned k, int s) {
+		const std::vector<float>& sv = slice_values[s];
+		slice_edges[s].resize(2 * slice_size);
+		for (unsigned j = 0; j < res; ++j)
+			for (unsigned i = 0; i < res; ++i) {
+				size_t idx = i + size_t(res)*j;
+				if (i + 1 < res)
+					add_edge(get_location(i, j, k), 0, sv[idx], sv[idx + 1], &slice_edges[s][2 * idx]);
+				if (j + 1 < res)
+					add_edge(get_location(i, j, k), 1, sv[idx], sv[idx + res], &slice_edges[s][2 * idx + 1]);
+			}
+	};
+	uint32_t nr_vertices = 0;
+	size_t nr_triangles = 0;
+	std::vector<pnt_type> points;
+	std::vector<extracted_mesh::vtx_type> vertices, normals, colors;
+	std::vector<std::vector<uint32_t> > row_triangles(res - 1);
+	int bottom = 0, top = 1;
+	sample_slice(0, slice_values[bottom]);
+	for (unsigned k = 0; k + 1 < res; ++k) {
+		sample_slice(k + 1, slice_values[top]);
+		p0s.clear();
+		dirs.clear();
+		fa.clear();
+		fb.clear();
+		targets.clear();
+		if (k == 0)
+			add_slice_edges(0, bottom);
+		for (size_t idx = 0; idx < slice_size; ++idx)
+			add_edge(get_location(unsigned(idx % res), unsigned(idx / res), k), 2, slice_values[bottom][idx], slice_values[top][idx], &z_edges[idx]);
+		add_slice_edges(k + 1, top);
+		// refine the new edge crossings together and pass them to the sink
+		refine_roots(p0s, dirs, fa, fb, points, color_func ? &colors : 0);
+		vertices.resize(points.size());
+		for (size_t c = 0; c < points.size(); ++c) {
+			vertices[c] = extracted_mesh::vtx_type(points[c]);
+			*targets[c] = nr_vertices + uint32_t(c);
+		}
+		if (with_normals) {
+			normals.resize(points.size());
+			parallel_for(0, int((points.size() + 255) / 256), [&](int b) {
+				for (size_t c = size_t(b) * 256; c < std::min(points.size(), size_t(b + 1) * 256); ++c) {
+					vec_type g(func->evaluate_gradient(points[c].to_vec()));
+					double l = g.length();
+					normals[c] = extracted_mesh::vtx_type(l > 0 ? g / l : g);
+				}
+			});
+		}
+		sink.add_vertices(vertices.empty() ? 0 : &vertices.front(), with_normals && !normals.empty() ? &normals.front() : 0,
+			colors.empty() ? 0 : &colors.front(), vertices.size());
+		nr_vertices += uint32_t(vertices.size());
+		// triangulate the cells of the slab row by row
+		const std::vector<float>* sv[2] = { &slice_values[bottom], &slice_values[top] };
+		const std::vector<uint32_t>* se[2] = { &slice_edges[bottom], &slice_edges[top] };
+		parallel_for(0, int(res) - 1, [&](int j) {
+			std::vector<uint32_t>& rt = row_triangles[j];
+			rt.clear();
+			for (unsigned i = 0; i + 1 < res; ++i) {
+				unsigned cube_case = 0;
+				for (int c = 0; c < 8; ++c)
+					if ((*sv[c >> 2])[i + (c & 1) + size_t(res)*(j + ((c >> 1) & 1))] < 0)
+						cube_case |= 1 << c;
+				if (cube_case == 0 || cube_case == 255)
+					continue;
+				for (const int8_t* e = get_marching_cubes_case(cube_case); *e != -1; ++e) {
+					int a = *e / 4, r0 = *e & 1, r1 = (*e >> 1) & 1;
+					switch (a) {
+					case 0: rt.push_back((*se[r1])[2 * (i + size_t(res)*(j + r0))]); break;
+					case 1: rt.push_back((*se[r1])[2 * (i + r0 + size_t(res)*j) + 1]); break;
+					default: rt.push_back(z_edges[i + r0 + size_t(res)*(j + r1)]); break;
+					}
+				}
+			}
+		});
+		for (auto& rt : row_triangles) {
+			if (!rt.empty())
+				sink.add_triangles(&rt.front(), rt.size() / 3);
+			nr_triangles += rt.size() / 3;
+		}
+		sink.end_slab();
+		std::swap(bottom, top);
+	}
+	return nr_triangles;
+}
+
+/// return whether the current parameters need normals at the edge crossings
+bool surface_extractor::needs_crossing_normals() const
+{
+	return dual_contouring || normal_mode == ENM_GRADIENT || normal_mode == ENM_CORNER_GRADIENT || normal_mode == ENM_GRID;
+}
+
+/// rebuild the mesh from the cached samples and Hermite data of the last extraction with the current contouring and vertex placement parameters; returns false if nothing is cached
+bool surface_extractor::rebuild_mesh(extracted_mesh& mesh)
+{
+	if (!func || crossings.empty() || crossing_points.size() != crossings.size())
+		return false;
+	// crossing normals are only computed on demand, so they may be missing after an extraction with face or corner normals
+	if (needs_crossing_normals() && crossing_normals.size() != crossing_points.size())
+		compute_crossing_normals();
+	set_function(func);
+	update_crossing_colors();
+	mesh.clear();
+	if (dual_contouring)
+		build_dual_contouring_mesh(mesh);
+	else
+		build_marching_cubes_mesh(mesh);
+	compute_mesh_normals(mesh);
+	return true;
+}
+
+/// release the memory of the sampled data
+void surface_extractor::clear()
+{
+	std::vector<float>().swap(values);
+	std::vector<uint64_t>().swap(crossings);
+	std::vector<pnt_type>().swap(crossing_points);
+	std::vector<vec_type>().swap(crossing_normals);
+	std::vector<extracted_mesh::vtx_type>().swap(crossing_colors);
+	std::vector<uint32_t>().swap(edge_crossing);
+	band = sparse_brick_volume<float>();
+	sampled_in_band = false;
+}
+
+/// return the memory used by the sampled data in bytes
+size_t surface_extractor::get_memory_size() const
+{
+	return values.size()*sizeof(float) + crossings.size()*sizeof(uint64_t) + crossing_points.size()*sizeof(pnt_type) +
+		crossing_normals.size()*sizeof(vec_type) + crossing_colors.size()*sizeof(extracted_mesh::vtx_type) + edge_crossing.size()*sizeof(uint32_t);
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <atomic>
+#include <cgv/math/fvec.h>
+#include <cgv/math/mfunc.h>
+#include <cgv/media/axis_aligned_box.h>
+#include "sparse_brick_volume.h"
+
+/// optional interface of implicit functions that evaluate batches of points faster than point by point
+struct batch_evaluation_interface
+{
+	/// evaluate the function at all points of ps and store the results in vs
+	virtual void evaluate_batch(const std::vector<cgv::math::fvec<double, 3> >& ps, std::vector<double>& vs) const = 0;
+};
+
+/// optional interface of implicit functions that provide a surface color, used to export colored meshes
+struct color_evaluation_interface
+{
+	/// evaluate the function together with its surface color at all points of ps in a single traversal per point, storing the values in vs and the rgb components of the colors in clrs
+	virtual void evaluate_batch_and_colors(const std::vector<cgv::math::fvec<double, 3> >& ps, std::vector<double>& vs, std::vector<cgv::math::fvec<float, 3> >& clrs) const = 0;
+};
+
+/// triangle mesh produced by the surface extractor
+struct extracted_mesh
+{
+	/// vertex type
+	typedef cgv::math::fvec<float, 3> vtx_type;
+	/// vertex locations
+	std::vector<vtx_type> positions;
+	/// per vertex normals, empty if the mesh is shaded with face normals
+	std::vector<vtx_type> normals;
+	/// three vertex indices per triangle
+	std::vector<uint32_t> triangles;
+	/// per vertex rgb colors captured during the extraction, empty if the mesh is uncolored
+	std::vector<vtx_type> colors;
+
+	/// remove all vertices and triangles
+	void clear();
+	/// return the number of triangles
+	size_t get_nr_triangles() const { return triangles.size() / 3; }
+	/// return the unnormalized normal of triangle t
+	vtx_type compute_face_normal(size_t t) const;
+	/// write vertices, normals and faces in obj format, offsetting indices by index_offset; vertices are followed by their rgb color if captured, or evaluated with color_func for meshes whose vertices moved after the extraction
+	void write_obj(std::ostream& os, unsigned index_offset = 0, const color_evaluation_interface* color_func = 0) const;
+};
+
+/// receiver of the vertices and triangles of a streamed extraction, vertices are numbered in the order in which they are added
+struct mesh_sink
+{
+	/// vertex type
+	typedef extracted_mesh::vtx_type vtx_type;
+	/// add n vertices with normals and colors, ns and cs are 0 if the extraction provides no normals or colors
+	virtual void add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n) = 0;
+	/// add n triangles given by three indices each of previously added vertices
+	virtual void add_triangles(const uint32_t* vis, size_t n) = 0;
+	/// called after the triangles of each slab, later triangles only reference vertices of the last two slabs
+	virtual void end_slab() {}
+};
+
+/// sink that appends the streamed vertices and triangles to a mesh
+struct extracted_mesh_sink : public mesh_sink
+{
+	/// mesh receiving the data
+	extracted_mesh& mesh;
+	/// construct from the receiving mesh, which is cleared
+	extracted_mesh_sink(extracted_mesh& _mesh) : mesh(_mesh) { mesh.clear(); }
+	/// append vertices, normals and colors
+	void add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n);
+	/// append triangles
+	void add_triangles(const uint32_t* vis, size_t n);
+};
+
+/// sink that writes the streamed vertices and triangles directly to a stream in obj format
+struct obj_mesh_sink : public mesh_sink
+{
+	/// output stream
+	std::ostream& os;
+	/// offset added to all vertex indices
+	unsigned index_offset;
+	/// whether vertices carry normals, determined from the first vertices
+	bool has_normals;
+	/// construct from output stream and index offset
+	obj_mesh_sink(std::ostream& _os, unsigned _index_offset = 0)
+		: os(_os), index_offset(_index_offset), has_normals(false) {}
+	/// write vertices followed by their colors if given and normals
+	void add_vertices(const vtx_type* ps, const vtx_type* ns, const vtx_type* cs, size_t n);
+	/// write faces
+	void add_triangles(const uint32_t* vis, size_t n);
+};
+
+/// supported methods to locate the surface along sign changing edges
+enum RootRefinementMethod
+{
+	RRM_BISECTION,
+	RRM_SECANT,
+	RRM_NEWTON
+};
+
+/// supported ways to compute the normals of the extracted mesh, grid normals interpolate central differences of the samples without further evaluations
+enum ExtractionNormalMode
+{
+	ENM_GRADIENT,
+	ENM_FACE,
+	ENM_CORNER,
+	ENM_CORNER_GRADIENT,
+	ENM_GRID
+};
+
+/** extracts the zero level set of an implicit function from a regular grid of samples
+    with marching cubes or dual contouring. The extraction runs in stages that each
+    process all grid elements in parallel: sampling of the grid, collection of sign
+    changing edges, batched refinement of the edge crossings, evaluation of the normals
+    at the crossings and finally construction of the mesh. Negative samples are inside. */
+class surface_extractor
+{
+public:
+	/// type of 3d point
+	typedef cgv::math::fvec<double, 3> pnt_type;
+	/// type of 3d vector
+	typedef cgv::math::fvec<double, 3> vec_type;
+	/// type of sampling box
+	typedef cgv::media::axis_aligned_box<double, 3> box_type;
+	/// type of the implicit function
+	typedef cgv::math::implicit_function<double> function_type;
+
+	/// use dual contouring instead of marching cubes
+	bool dual_contouring;
+	/// method used to refine edge crossings
+	RootRefinementMethod root_method;
+	/// maximum number of refinement steps per edge crossing, zero keeps the linear interpolation
+	unsigned max_nr_root_iters;
+	/// refinement of an edge crossing stops once the absolute function value drops below epsilon
+	double epsilon;
+	/// edge crossings are kept at least this fraction of the edge length away from the grid points
+	double grid_epsilon;
+	/// way to compute the mesh normals
+	ExtractionNormalMode normal_mode;
+	/// cosine threshold below which normals are considered to meet at a sharp feature
+	double normal_threshold;
+	/// relative threshold of singular values that are truncated in the solution of the dual contouring quadrics
+	double consistency_threshold;
+	/// maximum number of Jacobi sweeps in the eigen decomposition of the dual contouring quadrics
+	unsigned max_nr_iters;
+	/// whether to capture the surface color at the vertices if the function implements the color_evaluation_interface
+	bool extract_colors;
+	/// upper bound on the gradient length of the function; if positive, extract() samples only the bricks of the grid that may contain the surface and gives all other samples the sign of their brick center
+	double lipschitz_bound;
+	/// flag that aborts extract() between slabs and refinement rounds once it is set, 0 if extractions cannot be cancelled
+	const std::atomic<bool>* cancel_flag;
+
+protected:
+	/// function to be contoured
+	const function_type* func;
+	/// batch interface of the function or 0 if not supported
+	const batch_evaluation_interface* batch_func;
+	/// color interface of the function if colors are extracted, otherwise 0
+	const color_evaluation_interface* color_func;
+	/// sampling box
+	box_type box;
+	/// number of samples along each axis
+	unsigned res;
+	/// extent of a grid cell
+	vec_type cell_extent;
+	/// sampled function values
+	std::vector<float> values;
+	/// sign changing edges encoded as 3*sample_index+axis
+	std::vector<uint64_t> crossings;
+	/// surface location along each sign changing edge
+	std::vector<pnt_type> crossing_points;
+	/// normalized gradient at each edge crossing
+	std::vector<vec_type> crossing_normals;
+	/// surface color at each edge crossing, empty if no colors are extracted
+	std::vector<extracted_mesh::vtx_type> crossing_colors;
+	/// per grid edge the index of its crossing or -1
+	std::vector<uint32_t> edge_crossing;
+	/// narrow band of the samples of the last extraction with a Lipschitz bound, released once the crossings are collected
+	sparse_brick_volume<float> band;
+	/// whether the samples were taken in the narrow band, such that crossings are only searched in its bricks
+	bool sampled_in_band;
+
+	/// return the linear index of sample (i,j,k)
+	size_t get_index(unsigned i, unsigned j, unsigned k) const { return i + size_t(res)*(j + size_t(res)*k); }
+	/// return the location of sample (i,j,k)
+	pnt_type get_location(unsigned i, unsigned j, unsigned k) const;
+	/// evaluate the function at all points, using the batch interface if available
+	void evaluate_batch(const std::vector<pnt_type>& ps, std::vector<double>& vs) const;
+	/// set the function and its batch and color interfaces
+	void set_function(const function_type* f);
+	/// sample the function at all grid points, or in the narrow band only if a Lipschitz bound is given
+	void sample_values();
+	/// sample the function in the bricks of the narrow band and fill the remaining samples with the signed background of their bricks
+	void sample_narrow_band();
+	/// collect all edges whose end points have different signs
+	void collect_crossings();
+	/// locate the roots along edges from p0s to p0s+dirs with end point values fa and fb of opposite signs in batches, capturing the colors at the roots if colors is not 0
+	void refine_roots(const std::vector<pnt_type>& p0s, const std::vector<vec_type>& dirs, std::vector<double>& fa, std::vector<double>& fb, std::vector<pnt_type>& points, std::vector<extracted_mesh::vtx_type>* colors = 0) const;
+	/// locate the surface along the sign changing edges of the grid starting at crossing first together
+	void refine_crossings(size_t first = 0);
+	/// return the central difference gradient at sample (i,j,k), one sided at the border of the grid
+	vec_type get_sample_gradient(unsigned i, unsigned j, unsigned k) const;
+	/// trilinearly interpolate the sample gradients of the cell containing p
+	vec_type interpolate_sample_gradient(const pnt_type& p) const;
+	/// compute normalized gradients at the edge crossings starting at crossing first from the function or from the samples in grid mode
+	void compute_crossing_normals(size_t first = 0);
+	/// evaluate the colors at the points ps with the color interface
+	void evaluate_colors(const std::vector<pnt_type>& ps, std::vector<extracted_mesh::vtx_type>& colors) const;
+	/// evaluate the colors of crossings kept from an extraction without colors, or release them if no marching cubes colors are extracted
+	void update_crossing_colors();
+	/// build the marching cubes mesh from the edge crossings
+	void build_marching_cubes_mesh(extracted_mesh& mesh) const;
+	/// build the dual contouring mesh with one vertex per cell placed by minimizing the quadric of its edge crossings
+	void build_dual_contouring_mesh(extracted_mesh& mesh) const;
+	/// compute the vertices of the dual contouring cells given by linear cell indices in batches of quadrics
+	void place_cell_vertices(const std::vector<size_t>& cells, std::vector<extracted_mesh::vtx_type>& vertices) const;
+	/// compute the normals of the mesh according to normal_mode
+	void compute_mesh_normals(extracted_mesh& mesh) const;
+	/// return whether the current parameters need normals at the edge crossings
+	bool needs_crossing_normals() const;
+	/// return whether the cancel flag is set
+	bool is_cancelled() const { return cancel_flag && *cancel_flag; }
+
+public:
+	/// construct with marching cubes and gradient normals
+	surface_extractor();
+	/// extract the surface of f sampled with res^3 points in box into mesh and return whether a surface was found; a cancelled extraction returns false with an empty mesh and no samples
+	bool extract(const function_type* f, const box_type& _box, unsigned _res, extracted_mesh& mesh);
+	/// extract the marching cubes surface of f sampled with res^3 points in box slice by slice into sink, keeping only two slices of samples and edge vertices in memory; returns the number of triangles
+	size_t extract_streaming(const function_type* f, const box_type& _box, unsigned _res, mesh_sink& sink);
+	/** update the last extraction of f, whose values changed only inside the given boxes.
+	    The samples inside the boxes are evaluated again and only the sign changing edges with
+	    a resampled end point are refined, all other edge crossings and their normals are
+	    taken over. Falls back to a full extraction if the cached data belongs to another
+	    function, box or resolution. Returns whether a surface was found. */
+	bool extract_incremental(const function_type* f, const box_type& _box, unsigned _res, const std::vector<box_type>& changed_boxes, extracted_mesh& mesh);
+	/// rebuild the mesh from the cached samples and Hermite data of the last extraction with the current contouring and vertex placement parameters; returns false if nothing is cached
+	bool rebuild_mesh(extracted_mesh& mesh);
+	/// release the memory of the sampled data
+	void clear();
+	/// return the sampled function values of the last extraction with x varying fastest, empty after streaming extractions
+	const std::vector<float>& get_values() const { return values; }
+	/// return the number of sign changing edges of the last extraction
+	size_t get_nr_crossings() const { return crossings.size(); }
+	/// return the memory used by the sampled data in bytes
+	size_t get_memory_size() const;
+	/// return the triangles of the marching cubes case given by the sign bits of the 8 cube corners as edge indices terminated by -1
+	static const int8_t* get_marching_cubes_case(unsigned cube_case);
+};
@@ -0,0 +1,36 @@
+#include "check.h"
+#include "../animation_track.h"
+#include <cmath>
+
+int main()
+{
+	animation_track track("sphere", "r");
+	CHECK(track.node_name == "sphere" && track.member_name == "r");
+	// a track without keys is zero
+	CHECK(track.evaluate(1) == 0);
+
+	// keys are kept sorted independent of the insertion order
+	track.set_key(2, 1);
+	track.set_key(0, 3);
+	track.set_key(1, -1);
+	CHECK(track.keys.size() == 3);
+	CHECK(track.keys[0].first == 0 && track.keys[1].first == 1 && track.keys[2].first == 2);
+
+	// setting a key at an existing time replaces its value
+	track.set_key(1, 0);
+	CHECK(track.keys.size() == 3 && track.keys[1].second == 0);
+
+	// the values at the keys are reproduced and interpolated linearly in between
+	CHECK(track.evaluate(0) == 3 && track.evaluate(1) == 0 && track.evaluate(2) == 1);
+	CHECK(std::abs(track.evaluate(0.25) - 2.25) < 1e-12);
+	CHECK(std::abs(track.evaluate(1.5) - 0.5) < 1e-12);
+
+	// the values of the first and last key are held outside of the keys
+	CHECK(track.evaluate(-5) == 3 && track.evaluate(10) == 1);
+
+	// a single key is constant
+	animation_track constant;
+	constant.set_key(1, 4);
+	CHECK(constant.evaluate(0) == 4 && constant.evaluate(1) == 4 && constant.evaluate(2) == 4);
+	return test_result();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <iostream>
+
+/// number of failed checks of the test program
+static int nr_failed_checks = 0;
+
+/// report the location of a failed condition and count it
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			std::cout << __FILE__ << "(" << __LINE__ << "): check failed: " << #cond << std::endl; \
+			++nr_failed_checks; \
+		} \
+	} while (false)
+
+/// exit code of the test program
+inline int test_result()
+{
+	if (nr_failed_checks > 0)
+		std::cout << nr_failed_checks << " checks failed" << std::endl;
+	return nr_failed_checks > 0 ? 1 : 0;
+}
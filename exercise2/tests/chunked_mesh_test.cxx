@@ -0,0 +1,82 @@
+#include "check.h"
+#include "../chunked_mesh.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+typedef surface_extractor::pnt_type pnt_type;
+typedef extracted_mesh::vtx_type vtx_type;
+
+/// sphere of radius 0.7 around the origin
+struct sphere : public cgv::math::implicit_function<double>
+{
+	double evaluate(const cgv::math::vec<double>& p) const { return std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]) - 0.7; }
+};
+
+/// return the positions of the mesh in lexicographic order
+static std::vector<vtx_type> sorted_positions(const extracted_mesh& mesh)
+{
+	std::vector<vtx_type> ps(mesh.positions);
+	std::sort(ps.begin(), ps.end(), [](const vtx_type& a, const vtx_type& b) {
+		return a(0) < b(0) || (a(0) == b(0) && (a(1) < b(1) || (a(1) == b(1) && a(2) < b(2))));
+	});
+	return ps;
+}
+
+int main()
+{
+	const std::string file_name = "chunked_mesh_test.chk";
+	surface_extractor::box_type box(pnt_type(-1, -1, -1), pnt_type(1, 1, 1));
+	const unsigned res = 64;
+	sphere f;
+	surface_extractor e;
+	extracted_mesh reference;
+	CHECK(e.extract(&f, box, res, reference));
+
+	// the streamed chunks contain the same mesh as the extraction into memory
+	chunked_mesh_writer writer;
+	CHECK(writer.open(file_name, box, res, 16));
+	CHECK(e.extract_streaming(&f, box, res, writer) > 0);
+	CHECK(writer.close());
+	CHECK(writer.get_nr_chunks() > 8);
+
+	chunked_mesh_reader reader;
+	CHECK(reader.open(file_name));
+	CHECK(reader.get_nr_chunks() == writer.get_nr_chunks());
+	extracted_mesh mesh;
+	CHECK(reader.read_chunks(box, mesh) == reader.get_nr_chunks());
+	CHECK(mesh.get_nr_triangles() == reference.get_nr_triangles());
+	// vertices on chunk boundaries are welded, such that no vertex is duplicated
+	CHECK(sorted_positions(mesh) == sorted_positions(reference));
+	for (uint32_t vi : mesh.triangles)
+		CHECK(vi < mesh.positions.size());
+
+	// a query box selects the chunks of one octant only
+	extracted_mesh octant;
+	size_t nr_read = reader.read_chunks(surface_extractor::box_type(pnt_type(0.1, 0.1, 0.1), pnt_type(1, 1, 1)), octant);
+	CHECK(nr_read > 0 && nr_read < reader.get_nr_chunks());
+	CHECK(octant.get_nr_triangles() > 0 && octant.get_nr_triangles() < mesh.get_nr_triangles());
+	for (const vtx_type& p : octant.positions)
+		CHECK(p(0) > -0.2 && p(1) > -0.2 && p(2) > -0.2);
+	reader.close();
+
+	// an index entry pointing behind the end of the file is rejected on open
+	std::vector<char> data;
+	{
+		std::ifstream is(file_name.c_str(), std::ios::binary);
+		data.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+	}
+	chunk_info last;
+	std::copy(data.end() - sizeof(chunk_info), data.end(), reinterpret_cast<char*>(&last));
+	last.offset = data.size() - 4;
+	std::copy(reinterpret_cast<const char*>(&last), reinterpret_cast<const char*>(&last) + sizeof(chunk_info), data.end() - sizeof(chunk_info));
+	{
+		std::ofstream os(file_name.c_str(), std::ios::binary);
+		os.write(data.data(), data.size());
+	}
+	CHECK(!reader.open(file_name));
+	std::remove(file_name.c_str());
+	return test_result();
+}
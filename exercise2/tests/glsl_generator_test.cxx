@@ -0,0 +1,103 @@
+#include "check.h"
+#include "../glsl_generator.h"
+#include "../native_scene.h"
+#include <cmath>
+#include <limits>
+#include <random>
+
+typedef native_scene::pnt_type pnt_type;
+
+/// parameters of a difference of two spheres rotated around an axis, which are bound to uniforms
+struct scene_parameters
+{
+	double center[3], radius, hole_radius, axis[3], angle;
+	/// return the distance computed in the same way as the translation
+	double evaluate(const pnt_type& p) const
+	{
+		pnt_type a(axis[0], axis[1], axis[2]);
+		pnt_type x = p - dot(p, a)*a;
+		pnt_type q = dot(p, a)*a + std::cos(-angle)*x + std::sin(-angle)*cross(a, x);
+		double outer = (q - pnt_type(center[0], center[1], center[2])).length() - radius;
+		double inner = q.length() - hole_radius;
+		return std::max(outer, -inner);
+	}
+};
+
+/// translate the scene and return the expression of its value
+static std::string generate_scene(const scene_parameters& s, glsl_generator& g)
+{
+	// the uniforms are added in separate statements, such that their numbering is defined
+	std::string axis = g.add_uniform3(s.axis);
+	std::string angle = g.add_uniform(s.angle);
+	std::string q = g.add_variable("vec3", "rotate_around_axis(" + glsl_generator::get_point_name() + ", " + axis + ", -" + angle + ")");
+	std::string center = g.add_uniform3(s.center);
+	std::string radius = g.add_uniform(s.radius);
+	std::string outer = g.add_variable("float", "length(" + q + " - " + center + ") - " + radius);
+	std::string inner = g.add_variable("float", "length(" + q + ") - " + g.add_uniform(s.hole_radius));
+	// the infinite literal does not change the result
+	return g.add_variable("float", "min(max(" + outer + ", -" + inner + "), " + glsl_generator::literal(std::numeric_limits<double>::infinity()) + ")");
+}
+
+int main()
+{
+	// literals are valid float literals of GLSL and C++
+	CHECK(glsl_generator::literal(2) == "2.0");
+	CHECK(glsl_generator::literal(-0.5) == "-0.5");
+	CHECK(glsl_generator::literal(1e20) == "1e+20");
+	CHECK(glsl_generator::literal(std::numeric_limits<double>::infinity()) == "3.4e38");
+	CHECK(glsl_generator::literal(-std::numeric_limits<double>::infinity()) == "-3.4e38");
+
+	// uniforms are bound to the parameters and variables are numbered in the order of their statements
+	scene_parameters s = { { 0.2, 0, 0 }, 0.5, 0.15, { 0, 0.6, 0.8 }, 0.5 };
+	glsl_generator g;
+	std::string result = generate_scene(s, g);
+	CHECK(g.get_uniforms().size() == 5 && g.get_statements().size() == 4);
+	CHECK(g.get_uniforms()[0].name == "u0" && g.get_uniforms()[0].values == s.axis && g.get_uniforms()[0].nr_components == 3);
+	CHECK(g.get_uniforms()[1].values == &s.angle && g.get_uniforms()[1].nr_components == 1);
+	CHECK(g.get_statements()[0].name == "v0" && g.get_statements()[0].type == "vec3");
+	CHECK(result == "v3");
+
+	// the source declares the uniforms and returns the result from the distance function
+	std::string source = g.get_source(result);
+	CHECK(source.find("uniform vec3 u0;\n") != std::string::npos);
+	CHECK(source.find("uniform float u4;\n") != std::string::npos);
+	CHECK(source.find("float scene_distance(vec3 p)") != std::string::npos);
+	CHECK(source.find("\tfloat v1 = length(v0 - u2) - u3;\n") != std::string::npos);
+	CHECK(source.find("\treturn v3;\n") != std::string::npos);
+	g.clear();
+	CHECK(g.get_uniforms().empty() && g.get_statements().empty());
+
+	// the translation evaluated as native code agrees with the scene, with parameters read through the bindings or baked
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<double> coord(-1, 1);
+	std::vector<pnt_type> ps(1000);
+	for (pnt_type& p : ps)
+		p = pnt_type(coord(rng), coord(rng), coord(rng));
+	for (int bake = 0; bake < 2; ++bake) {
+		scene_parameters t = s;
+		glsl_generator h;
+		result = generate_scene(t, h);
+		native_scene ns;
+		// the objects are kept in a private directory of the build tree
+		ns.directory = "native_scene_test";
+		ns.bake_parameters = bake == 1;
+		CHECK(ns.build(h, result));
+		if (!ns.is_loaded())
+			continue;
+		for (int change = 0; change < 2; ++change) {
+			std::vector<double> vs;
+			ns.evaluate_batch(ps, vs);
+			CHECK(vs.size() == ps.size());
+			double max_error = 0;
+			for (size_t i = 0; i < ps.size(); ++i)
+				max_error = std::max(max_error, std::max(std::abs(vs[i] - t.evaluate(ps[i])), std::abs(ns.evaluate(ps[i]) - vs[i])));
+			// baked parameters keep the values of the build
+			CHECK(max_error < 1e-9 || (bake == 1 && change == 1));
+			CHECK(bake == 0 || change == 0 || max_error > 1e-3);
+			t.radius = 0.7;
+			t.angle = 1.2;
+		}
+		ns.unload();
+	}
+	return test_result();
+}
@@ -0,0 +1,89 @@
+#include "check.h"
+#include "../mesh_cache.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+typedef extracted_mesh::vtx_type vtx_type;
+
+/// return a mesh of n vertices along the y-axis at x coordinate k with colors and one triangle
+static extracted_mesh make_mesh(int k, int n)
+{
+	extracted_mesh mesh;
+	for (int i = 0; i < n; ++i) {
+		mesh.positions.push_back(vtx_type(float(k), float(i), 0));
+		mesh.colors.push_back(vtx_type(1, 0.5f, float(k)));
+	}
+	mesh.triangles = { 0, 1, 2 };
+	return mesh;
+}
+
+/// return whether the meshes are equal
+static bool same_mesh(const extracted_mesh& a, const extracted_mesh& b)
+{
+	return a.positions == b.positions && a.normals == b.normals && a.colors == b.colors && a.triangles == b.triangles;
+}
+
+int main()
+{
+	// comments and whitespace do not change the key of a description
+	CHECK(mesh_cache::normalize_description("sphere 0.5 % radius\n\t  box  1\r\n") == "sphere 0.5 box 1");
+	CHECK(mesh_cache::normalize_description("  % only a comment\n") == "");
+	CHECK(mesh_cache::normalize_description("union\n{sphere 1}\n") == mesh_cache::normalize_description("union {sphere 1} % same scene"));
+	CHECK(mesh_cache::normalize_description("sphere 1") != mesh_cache::normalize_description("sphere 2"));
+	CHECK(mesh_cache::compute_hash("a") != mesh_cache::compute_hash("b"));
+
+	// meshes are evicted in least recently used order once the budget is exceeded
+	mesh_cache cache;
+	extracted_mesh mesh;
+	cache.insert("key0", make_mesh(0, 30));
+	cache.memory_budget = 3 * cache.get_memory_size();
+	for (int k = 1; k < 3; ++k)
+		cache.insert("key" + std::to_string(k), make_mesh(k, 30));
+	CHECK(cache.get_nr_entries() == 3);
+	CHECK(cache.get_memory_size() <= cache.memory_budget);
+	CHECK(cache.find("key0", mesh) && same_mesh(mesh, make_mesh(0, 30)));
+	cache.insert("key3", make_mesh(3, 30));
+	CHECK(cache.get_nr_entries() == 3);
+	CHECK(!cache.find("key1", mesh));
+	CHECK(cache.find("key0", mesh) && cache.find("key2", mesh) && cache.find("key3", mesh));
+	CHECK(!cache.find("missing", mesh));
+	// inserting an existing key replaces its mesh
+	cache.insert("key3", make_mesh(3, 40));
+	CHECK(cache.find("key3", mesh) && mesh.positions.size() == 40);
+	cache.clear();
+	CHECK(cache.get_nr_entries() == 0 && cache.get_memory_size() == 0);
+
+	// spilled meshes are loaded from the directory after eviction and after clearing the cache
+	mesh_cache spilling;
+	spilling.directory = ".";
+	spilling.memory_budget = 1000;
+	for (int k = 0; k < 4; ++k)
+		spilling.insert("spilled key" + std::to_string(k), make_mesh(k, 30 + k));
+	CHECK(spilling.get_nr_entries() < 4);
+	for (int k = 0; k < 4; ++k)
+		CHECK(spilling.find("spilled key" + std::to_string(k), mesh) && same_mesh(mesh, make_mesh(k, 30 + k)));
+	spilling.clear();
+	CHECK(spilling.find("spilled key0", mesh) && same_mesh(mesh, make_mesh(0, 30)));
+
+	// a file whose stored key differs from the requested one, as after a hash collision, is not used
+	mesh_cache reader;
+	reader.directory = ".";
+	{
+		char name[24];
+		snprintf(name, sizeof(name), "%016llx.imc", (unsigned long long)mesh_cache::compute_hash("spilled key0"));
+		std::ifstream is(name, std::ios::binary);
+		std::string data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+		snprintf(name, sizeof(name), "%016llx.imc", (unsigned long long)mesh_cache::compute_hash("spilled key9"));
+		std::ofstream(name, std::ios::binary) << data;
+	}
+	CHECK(!reader.find("spilled key9", mesh));
+	CHECK(reader.find("spilled key1", mesh) && same_mesh(mesh, make_mesh(1, 31)));
+
+	for (const char* key : { "spilled key0", "spilled key1", "spilled key2", "spilled key3", "spilled key9" }) {
+		char name[24];
+		snprintf(name, sizeof(name), "%016llx.imc", (unsigned long long)mesh_cache::compute_hash(key));
+		std::remove(name);
+	}
+	return test_result();
+}
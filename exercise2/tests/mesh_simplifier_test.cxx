@@ -0,0 +1,120 @@
+#include "check.h"
+#include "../mesh_simplifier.h"
+#include <cmath>
+#include <map>
+#include <algorithm>
+
+typedef surface_extractor::pnt_type pnt_type;
+typedef extracted_mesh::vtx_type vtx_type;
+
+/// union of a torus and a cube, which has curved regions as well as sharp edges and corners
+struct torus_and_box : public cgv::math::implicit_function<double>
+{
+	static double value(const vtx_type& p)
+	{
+		double q = std::sqrt(p(0)*p(0) + p(2)*p(2)) - 0.6;
+		double torus = std::sqrt(q*q + p(1)*p(1)) - 0.25;
+		double box = std::max(std::abs(p(0)), std::max(std::abs(p(1)), std::abs(p(2)))) - 0.5;
+		return std::min(torus, box);
+	}
+	double evaluate(const cgv::math::vec<double>& p) const { return value(vtx_type(float(p[0]), float(p[1]), float(p[2]))); }
+};
+
+/// topological properties of an indexed triangle mesh
+struct mesh_topology
+{
+	size_t nr_non_manifold_edges, nr_boundary_edges, nr_degenerate_triangles;
+	long euler_characteristic;
+	/// vertices incident to boundary edges
+	std::vector<uint32_t> boundary_vertices;
+	mesh_topology(const extracted_mesh& mesh) : nr_non_manifold_edges(0), nr_boundary_edges(0), nr_degenerate_triangles(0)
+	{
+		std::map<std::pair<uint32_t, uint32_t>, int> half_edges;
+		for (size_t t = 0; t < mesh.get_nr_triangles(); ++t) {
+			const uint32_t* vis = &mesh.triangles[3 * t];
+			if (vis[0] == vis[1] || vis[1] == vis[2] || vis[2] == vis[0])
+				++nr_degenerate_triangles;
+			for (int c = 0; c < 3; ++c)
+				++half_edges[std::make_pair(vis[c], vis[(c + 1) % 3])];
+		}
+		for (const auto& he : half_edges) {
+			if (he.second != 1)
+				++nr_non_manifold_edges;
+			if (half_edges.count(std::make_pair(he.first.second, he.first.first)) == 0) {
+				++nr_boundary_edges;
+				boundary_vertices.push_back(he.first.first);
+				boundary_vertices.push_back(he.first.second);
+			}
+		}
+		euler_characteristic = long(mesh.positions.size()) - long(half_edges.size() + nr_boundary_edges) / 2 + long(mesh.get_nr_triangles());
+	}
+};
+
+/// return the largest absolute function value at the vertices of the mesh
+static double max_vertex_value(const extracted_mesh& mesh)
+{
+	double max_value = 0;
+	for (const vtx_type& p : mesh.positions)
+		max_value = std::max(max_value, std::abs(torus_and_box::value(p)));
+	return max_value;
+}
+
+int main()
+{
+	surface_extractor::box_type box(pnt_type(-1, -1, -1), pnt_type(1, 1, 1));
+	const unsigned res = 64;
+	torus_and_box f;
+	surface_extractor e;
+	extracted_mesh mesh;
+
+	// without target and error bound the mesh is left untouched
+	CHECK(e.extract(&f, box, res, mesh));
+	size_t nr_triangles = mesh.get_nr_triangles();
+	double cell_size = 2.0 / (res - 1);
+	mesh_simplifier off;
+	CHECK(off.simplify(mesh) == 0);
+	CHECK(mesh.get_nr_triangles() == nr_triangles);
+
+	// each collapse of a closed mesh removes two triangles, and the topology and the surface are preserved
+	for (size_t divisor : { 2, 10, 50 }) {
+		CHECK(e.extract(&f, box, res, mesh));
+		mesh_simplifier simplifier;
+		simplifier.target_nr_triangles = nr_triangles / divisor;
+		size_t nr_collapses = simplifier.simplify(mesh);
+		CHECK(mesh.get_nr_triangles() == nr_triangles - 2 * nr_collapses);
+		CHECK(mesh.get_nr_triangles() <= simplifier.target_nr_triangles + 1);
+		CHECK(mesh.normals.size() == mesh.positions.size());
+		mesh_topology topology(mesh);
+		CHECK(topology.nr_non_manifold_edges == 0 && topology.nr_boundary_edges == 0 && topology.nr_degenerate_triangles == 0);
+		CHECK(topology.euler_characteristic == 2);
+		// quadric placement keeps the vertices close to the curved torus and on the flat faces and sharp edges of the cube
+		CHECK(max_vertex_value(mesh) < 0.25 * cell_size);
+	}
+
+	// an error bound stops the simplification earlier the smaller it is
+	size_t previous_nr_triangles = 0;
+	for (double max_error : { 3e-3, 1e-3, 1e-4 }) {
+		CHECK(e.extract(&f, box, res, mesh));
+		mesh_simplifier simplifier;
+		simplifier.max_error = max_error;
+		CHECK(simplifier.simplify(mesh) > 0);
+		CHECK(mesh.get_nr_triangles() > previous_nr_triangles);
+		previous_nr_triangles = mesh.get_nr_triangles();
+		CHECK(mesh_topology(mesh).euler_characteristic == 2);
+	}
+
+	// the boundary of a clipped mesh stays in the clipping plane
+	surface_extractor::box_type clipped(pnt_type(-1, -1, -1), pnt_type(1, 1, 0.1));
+	CHECK(e.extract(&f, clipped, res, mesh));
+	mesh_topology before(mesh);
+	CHECK(before.nr_boundary_edges > 0);
+	mesh_simplifier simplifier;
+	simplifier.target_nr_triangles = mesh.get_nr_triangles() / 10;
+	CHECK(simplifier.simplify(mesh) > 0);
+	mesh_topology after(mesh);
+	CHECK(after.nr_non_manifold_edges == 0 && after.nr_degenerate_triangles == 0);
+	CHECK(after.nr_boundary_edges > 0 && after.euler_characteristic == before.euler_characteristic);
+	for (uint32_t vi : after.boundary_vertices)
+		CHECK(std::abs(mesh.positions[vi](2) - 0.1f) < 1e-4);
+	return test_result();
+}
@@ -0,0 +1,91 @@
+#include "check.h"
+#include "../repeat.h"
+#include "../implicit_primitive.h"
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+typedef implicit_base<double>::pnt_type pnt_type;
+typedef implicit_base<double>::vec_type vec_type;
+
+/// sphere of radius r around center with its analytic gradient, standing in for the primitives left to the tasks
+struct ball : public implicit_primitive<double>
+{
+	pnt_type center;
+	double r;
+	ball(const pnt_type& _center, double _r) : center(_center), r(_r) {}
+	double evaluate(const pnt_type& p) const { return (p - center).length() - r; }
+	vec_type evaluate_gradient(const pnt_type& p) const { return (p - center) / (p - center).length(); }
+};
+
+/// return the center of the copy of the child closest to p by checking all copies
+static pnt_type closest_copy(const repeat_node<double>& rep, const pnt_type& child_center, const pnt_type& p)
+{
+	pnt_type best = child_center;
+	double best_dist = 1e300;
+	for (int k = 0; k < std::max(rep.count[2], 1); ++k)
+		for (int j = 0; j < std::max(rep.count[1], 1); ++j)
+			for (int i = 0; i < std::max(rep.count[0], 1); ++i) {
+				pnt_type c = child_center;
+				int cell[3] = { i, j, k };
+				for (int a = 0; a < 3; ++a)
+					if (rep.delta(a) > 0)
+						c(a) += (cell[a] - 0.5*(rep.count[a] - 1))*rep.delta(a);
+				if ((p - c).length() < best_dist) {
+					best_dist = (p - c).length();
+					best = c;
+				}
+			}
+	return best;
+}
+
+int main()
+{
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<double> coord(-3, 3);
+
+	// without children the node is empty
+	repeat_node<double> empty;
+	CHECK(empty.evaluate(pnt_type(0, 0, 0)) == 1);
+
+	// a centered child is evaluated in the closest cell only, which agrees with the minimum over all copies
+	repeat_node<double> rep;
+	rep.delta = vec_type(1, 1.5, 0);
+	rep.count[0] = 3;
+	rep.count[1] = 2;
+	pnt_type centered(0, 0, 0);
+	rep.append_child(base_ptr(new ball(centered, 0.3)));
+	for (int n = 0; n < 1000; ++n) {
+		pnt_type p(coord(rng), coord(rng), coord(rng));
+		pnt_type c = closest_copy(rep, centered, p);
+		CHECK(std::abs(rep.evaluate(p) - ((p - c).length() - 0.3)) < 1e-12);
+		CHECK((rep.evaluate_gradient(p) - (p - c) / (p - c).length()).length() < 1e-12);
+	}
+
+	// infinite repetition folds far away points into the cell at the origin
+	repeat_node<double> infinite;
+	infinite.append_child(base_ptr(new ball(centered, 0.3)));
+	CHECK(std::abs(infinite.evaluate(pnt_type(1000.2, -2000.1, 3000)) - (pnt_type(0.2, -0.1, 0).length() - 0.3)) < 1e-9);
+
+	// a child that reaches into the adjacent cells needs the neighbors to find the closest copy
+	pnt_type shifted(0.4, 0, 0);
+	rep.remove_all_children();
+	rep.append_child(base_ptr(new ball(shifted, 0.3)));
+	size_t nr_wrong = 0;
+	for (int n = 0; n < 1000; ++n) {
+		pnt_type p(coord(rng), coord(rng), coord(rng));
+		pnt_type c = closest_copy(rep, shifted, p);
+		double exact = (p - c).length() - 0.3;
+		rep.neighbors = false;
+		// the closest cell evaluates one of the copies, which bounds the minimum from above
+		double v = rep.evaluate(p);
+		CHECK(v >= exact - 1e-12);
+		if (v > exact + 1e-9)
+			++nr_wrong;
+		rep.neighbors = true;
+		CHECK(std::abs(rep.evaluate(p) - exact) < 1e-12);
+		CHECK((rep.evaluate_gradient(p) - (p - c) / (p - c).length()).length() < 1e-12);
+	}
+	CHECK(nr_wrong > 0);
+	return test_result();
+}
@@ -0,0 +1,103 @@
+#include "check.h"
+#include "../sparse_brick_volume.h"
+#include "../surface_extractor.h"
+#include <cmath>
+#include <atomic>
+#include <array>
+#include <algorithm>
+
+typedef sparse_brick_volume<float> volume_type;
+typedef volume_type::pnt_type pnt_type;
+
+/// sphere with waves whose gradient length stays below 2
+struct wavy_sphere : public cgv::math::implicit_function<double>
+{
+	mutable std::atomic<size_t> nr_evaluations;
+	wavy_sphere() : nr_evaluations(0) {}
+	static double value(const volume_type::pnt_type& p) { return p.length() - 0.7 + 0.1*std::sin(7 * p(0))*std::sin(5 * p(1)); }
+	double evaluate(const cgv::math::vec<double>& p) const { ++nr_evaluations; return value(volume_type::pnt_type(p[0], p[1], p[2])); }
+};
+
+/// thin slab of half width 0.01 around the plane x = 0.3, which a first order distance estimate from the brick centers misses
+static double thin_slab(const pnt_type& p)
+{
+	return 20 * (std::abs(p(0) - 0.3) - 0.01);
+}
+
+/// check that all samples have the sign of f, and the sampled value within band cells of the surface
+template <typename F>
+static void check_samples(const volume_type& V, const F& f, double band)
+{
+	double h = V.get_cell_extent()(0);
+	for (unsigned k = 0; k < V.get_resolution(2); ++k)
+		for (unsigned j = 0; j < V.get_resolution(1); ++j)
+			for (unsigned i = 0; i < V.get_resolution(0); ++i) {
+				double v = f(V.get_location(i, j, k));
+				float s = V.get_value(i, j, k);
+				CHECK((s < 0) == (v < 0));
+				if (std::abs(v) < 0.5*band*h)
+					CHECK(std::abs(s - v) < 1e-5);
+			}
+}
+
+/// return the triangles of m in lexicographic order, as the order of the edge crossings depends on the sampling
+static std::vector<std::array<uint32_t, 3> > sorted_triangles(const extracted_mesh& m)
+{
+	std::vector<std::array<uint32_t, 3> > ts(m.get_nr_triangles());
+	for (size_t t = 0; t < ts.size(); ++t)
+		ts[t] = { m.triangles[3 * t], m.triangles[3 * t + 1], m.triangles[3 * t + 2] };
+	std::sort(ts.begin(), ts.end());
+	return ts;
+}
+
+int main()
+{
+	volume_type::box_type box(pnt_type(-1, -1, -1), pnt_type(1, 1, 1));
+	volume_type V;
+
+	// narrow band of the wavy sphere
+	V.resize(box, 61, 61, 61, 1);
+	V.build_narrow_band(&wavy_sphere::value, 2, 2);
+	CHECK(V.get_nr_allocated_bricks() > 0);
+	CHECK(V.get_nr_allocated_bricks() < size_t(8 * 8 * 8));
+	check_samples(V, &wavy_sphere::value, 2);
+	size_t nr_bricks = 0;
+	for (auto it = V.begin_bricks(); it != V.end_bricks(); ++it) {
+		for (int c = 0; c < 3; ++c)
+			CHECK(it.get_origin(c) % volume_type::brick_size == 0);
+		CHECK(it.get_values()[0] == V.get_value(it.get_origin(0), it.get_origin(1), it.get_origin(2)));
+		++nr_bricks;
+	}
+	CHECK(nr_bricks == V.get_nr_allocated_bricks());
+
+	// the Lipschitz bound keeps the bricks of a surface thinner than a cell
+	V.resize(box, 61, 61, 61, 1);
+	V.build_narrow_band(&thin_slab, 0, 20);
+	check_samples(V, &thin_slab, 0);
+
+	// interpolation reproduces linear functions
+	V.resize(box, 17, 17, 17, 1);
+	for (unsigned k = 0; k < 17; ++k)
+		for (unsigned j = 0; j < 17; ++j)
+			for (unsigned i = 0; i < 17; ++i)
+				V.set_value(i, j, k, float(V.get_location(i, j, k)(0) - 0.25));
+	CHECK(std::abs(V.interpolate(pnt_type(0.1, 0.2, 0.3)) + 0.15) < 1e-5);
+	CHECK(std::abs(V.interpolate_gradient(pnt_type(0.1, 0.2, 0.3))(0) - 1) < 1e-4);
+
+	// contouring from the narrow band gives the mesh of the dense samples with fewer evaluations
+	wavy_sphere f;
+	surface_extractor ex;
+	ex.dual_contouring = true;
+	extracted_mesh dense, band;
+	ex.extract(&f, box, 96, dense);
+	size_t nr_dense_evaluations = f.nr_evaluations;
+	f.nr_evaluations = 0;
+	ex.lipschitz_bound = 2;
+	ex.extract(&f, box, 96, band);
+	CHECK(f.nr_evaluations < nr_dense_evaluations);
+	CHECK(band.positions.size() == dense.positions.size());
+	CHECK(sorted_triangles(band) == sorted_triangles(dense));
+	for (size_t i = 0; i < band.positions.size() && i < dense.positions.size(); ++i)
+		CHECK((band.positions[i] - dense.positions[i]).length() < 1e-6f);
+	return test_result();
+}
@@ -0,0 +1,67 @@
+#include "check.h"
+#include "../static_scene.h"
+#include <cmath>
+#include <random>
+
+typedef implicit_base<double>::pnt_type pnt_type;
+
+/// sphere of radius r around the origin, standing in for the primitives left to the tasks
+struct ball : public static_scene::expression<ball>
+{
+	double r;
+	constexpr ball(double _r) : r(_r) {}
+	template <typename P>
+	double evaluate(const P& p) const { return std::sqrt(p(0)*p(0) + p(1)*p(1) + p(2)*p(2)) - r; }
+	double get_lipschitz_bound() const { return 1; }
+};
+
+static double ball_value(const pnt_type& p, double r) { return p.length() - r; }
+
+namespace ss = static_scene;
+
+// all node types as constexpr scenes, such that their constructors are checked to be literal
+constexpr auto transformed = ss::make_uniform_scaling(1.5, ss::make_shear(0.3, 0, -0.2, ss::make_rotation(30, 0, 0.6, 0.8,
+	ss::make_translation(0.2, 0, 0, ball(0.5)) - ss::make_scaling(2, 1, 4, ball(0.15))))) & ball(2);
+constexpr auto primitives = ss::make_distance_surface(0, 0, 0, 1, 0, 0, 0.3) | ss::sphere() | (ss::box() & ss::cylinder());
+static_assert(transformed.b.r == 2, "parameters of constexpr scenes are compile time constants");
+
+int main()
+{
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<double> coord(-1, 1);
+	for (int n = 0; n < 200; ++n) {
+		pnt_type p(coord(rng), coord(rng), coord(rng));
+		// csg nodes
+		CHECK((ball(0.5) | ball(0.2)).evaluate(p) == std::min(ball_value(p, 0.5), ball_value(p, 0.2)));
+		CHECK((ball(0.5) & ball(0.2)).evaluate(p) == std::max(ball_value(p, 0.5), ball_value(p, 0.2)));
+		CHECK((ball(0.5) - ball(0.2)).evaluate(p) == std::max(ball_value(p, 0.5), -ball_value(p, 0.2)));
+		// transformations evaluate the child at the inversely transformed point
+		CHECK(std::abs(ss::make_translation(0.2, -0.1, 0.3, ball(0.5)).evaluate(p) - ball_value(p - pnt_type(0.2, -0.1, 0.3), 0.5)) < 1e-12);
+		CHECK(std::abs(ss::make_uniform_scaling(2, ball(0.5)).evaluate(p) - ball_value(0.5*p, 0.5)) < 1e-12);
+		CHECK(std::abs(ss::make_scaling(2, 1, 4, ball(0.5)).evaluate(p) - ball_value(pnt_type(p(0) / 2, p(1), p(2) / 4), 0.5)) < 1e-12);
+		CHECK(std::abs(ss::make_shear(0.3, 0.1, -0.2, ball(0.5)).evaluate(p) -
+			ball_value(pnt_type(p(0) - 0.3*p(1) - 0.1*p(2), p(1) + 0.2*p(2), p(2)), 0.5)) < 1e-12);
+		// rotating an off center ball by 90 degrees around z moves it from the x to the y axis
+		auto rotated = ss::make_rotation(90, 0, 0, 1, ss::make_translation(0.5, 0, 0, ball(0.2)));
+		CHECK(std::abs(rotated.evaluate(p) - ball_value(p - pnt_type(0, 0.5, 0), 0.2)) < 1e-9);
+	}
+	CHECK(ss::make_uniform_scaling(0.25, ball(1)).get_lipschitz_bound() == 4);
+	CHECK(ss::make_scaling(2, 0.5, 4, ball(1)).get_lipschitz_bound() == 2);
+	CHECK(transformed.get_lipschitz_bound() >= 1);
+	CHECK(primitives.get_lipschitz_bound() == 1);
+	(void)primitives.evaluate(pnt_type(0, 0, 0));
+
+	// the adapter evaluates the inlined scene through the interface of the scene tree
+	static_implicit<decltype(transformed)> f(transformed);
+	implicit_base<double>* base = &f;
+	std::vector<pnt_type> ps(1000);
+	for (pnt_type& p : ps)
+		p = pnt_type(coord(rng), coord(rng), coord(rng));
+	std::vector<double> vs;
+	base->evaluate_batch(ps, vs);
+	CHECK(vs.size() == ps.size());
+	for (size_t i = 0; i < ps.size(); ++i)
+		CHECK(vs[i] == transformed.evaluate(ps[i]) && base->evaluate(ps[i]) == vs[i]);
+	CHECK(base->get_lipschitz_bound() == transformed.get_lipschitz_bound());
+	return test_result();
+}
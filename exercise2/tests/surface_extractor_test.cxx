@@ -0,0 +1,283 @@
+#include "check.h"
+#include "../surface_extractor.h"
+#include <cmath>
+#include <atomic>
+#include <sstream>
+#include <map>
+#include <algorithm>
+
+typedef surface_extractor::pnt_type pnt_type;
+typedef extracted_mesh::vtx_type vtx_type;
+
+/// sphere of radius 0.7 whose surface color encodes the location, counting value and fused evaluations
+struct colored_sphere : public cgv::math::implicit_function<double>, public color_evaluation_interface
+{
+	mutable std::atomic<size_t> nr_evaluations, nr_colored_evaluations;
+	colored_sphere() : nr_evaluations(0), nr_colored_evaluations(0) {}
+	static double value(const surface_extractor::pnt_type& p) { return p.length() - 0.7; }
+	static vtx_type color(const surface_extractor::pnt_type& p) { return vtx_type(float(0.5 + 0.5*p(0)), float(0.5 + 0.5*p(1)), float(0.5 + 0.5*p(2))); }
+	double evaluate(const cgv::math::vec<double>& p) const { ++nr_evaluations; return value(surface_extractor::pnt_type(p[0], p[1], p[2])); }
+	void evaluate_batch_and_colors(const std::vector<surface_extractor::pnt_type>& ps, std::vector<double>& vs, std::vector<vtx_type>& clrs) const
+	{
+		nr_colored_evaluations += ps.size();
+		vs.resize(ps.size());
+		clrs.resize(ps.size());
+		for (size_t i = 0; i < ps.size(); ++i) {
+			vs[i] = value(ps[i]);
+			clrs[i] = color(ps[i]);
+		}
+	}
+};
+
+/// sphere with waves and its analytic gradient
+struct wavy_sphere : public cgv::math::implicit_function<double>
+{
+	static double value(const surface_extractor::pnt_type& p) { return p.length() - 0.7 + 0.1*std::sin(7 * p(0))*std::sin(5 * p(1)); }
+	double evaluate(const cgv::math::vec<double>& p) const { return value(surface_extractor::pnt_type(p[0], p[1], p[2])); }
+	cgv::math::vec<double> evaluate_gradient(const cgv::math::vec<double>& p) const
+	{
+		surface_extractor::pnt_type q(p[0], p[1], p[2]);
+		surface_extractor::vec_type g = q / q.length();
+		g(0) += 0.7*std::cos(7 * q(0))*std::sin(5 * q(1));
+		g(1) += 0.5*std::sin(7 * q(0))*std::cos(5 * q(1));
+		return g.to_vec();
+	}
+};
+
+/// cube of half size 0.5 whose center and corners lie off the grid points, the gradient is the normal of the closest face
+struct offset_cube : public cgv::math::implicit_function<double>
+{
+	static surface_extractor::pnt_type center() { return surface_extractor::pnt_type(0.03, 0.02, 0.01); }
+	static double value(const surface_extractor::pnt_type& p)
+	{
+		surface_extractor::pnt_type q = p - center();
+		return std::max(std::abs(q(0)), std::max(std::abs(q(1)), std::abs(q(2)))) - 0.5;
+	}
+	double evaluate(const cgv::math::vec<double>& p) const { return value(surface_extractor::pnt_type(p[0], p[1], p[2])); }
+	cgv::math::vec<double> evaluate_gradient(const cgv::math::vec<double>& p) const
+	{
+		surface_extractor::pnt_type q = surface_extractor::pnt_type(p[0], p[1], p[2]) - center();
+		int a = std::abs(q(0)) >= std::max(std::abs(q(1)), std::abs(q(2))) ? 0 : (std::abs(q(1)) >= std::abs(q(2)) ? 1 : 2);
+		surface_extractor::vec_type n(0, 0, 0);
+		n(a) = q(a) < 0 ? -1 : 1;
+		return n.to_vec();
+	}
+};
+
+/// two spheres of radius 0.3, the right one of which moves along the x-axis, counting the evaluations
+struct moving_spheres : public cgv::math::implicit_function<double>
+{
+	double x;
+	mutable std::atomic<size_t> nr_evaluations;
+	moving_spheres() : x(0.5), nr_evaluations(0) {}
+	double evaluate(const cgv::math::vec<double>& p) const
+	{
+		++nr_evaluations;
+		surface_extractor::pnt_type q(p[0], p[1], p[2]);
+		return std::min((q - surface_extractor::pnt_type(-0.5, 0, 0)).length(), (q - surface_extractor::pnt_type(x, 0, 0)).length()) - 0.3;
+	}
+};
+
+/// return the positions of the mesh in lexicographic order
+static std::vector<vtx_type> sorted_positions(const extracted_mesh& mesh)
+{
+	std::vector<vtx_type> ps(mesh.positions);
+	std::sort(ps.begin(), ps.end(), [](const vtx_type& a, const vtx_type& b) {
+		return a(0) < b(0) || (a(0) == b(0) && (a(1) < b(1) || (a(1) == b(1) && a(2) < b(2))));
+	});
+	return ps;
+}
+
+/// return the largest absolute function value at the vertices of the mesh
+static double max_vertex_value(const extracted_mesh& mesh)
+{
+	double max_value = 0;
+	for (const vtx_type& p : mesh.positions)
+		max_value = std::max(max_value, std::abs(wavy_sphere::value(pnt_type(p))));
+	return max_value;
+}
+
+/// check that the mesh is closed and two-manifold with all faces oriented away from the origin
+static void check_closed_sphere(const extracted_mesh& mesh)
+{
+	CHECK(mesh.get_nr_triangles() > 0);
+	std::map<std::pair<uint32_t, uint32_t>, int> half_edges;
+	size_t nr_inwards = 0;
+	for (size_t t = 0; t < mesh.get_nr_triangles(); ++t) {
+		for (int c = 0; c < 3; ++c)
+			++half_edges[std::make_pair(mesh.triangles[3 * t + c], mesh.triangles[3 * t + (c + 1) % 3])];
+		if (dot(mesh.compute_face_normal(t), mesh.positions[mesh.triangles[3 * t]]) < 0)
+			++nr_inwards;
+	}
+	size_t nr_unpaired = 0;
+	for (const auto& he : half_edges)
+		if (he.second != 1 || half_edges.count(std::make_pair(he.first.second, he.first.first)) == 0)
+			++nr_unpaired;
+	CHECK(nr_unpaired == 0);
+	CHECK(nr_inwards == 0);
+	// a sphere has Euler characteristic 2
+	CHECK(long(mesh.positions.size()) - long(half_edges.size() / 2) + long(mesh.get_nr_triangles()) == 2);
+}
+
+/// check that every vertex of the mesh carries the color of its location
+static void check_colors(const extracted_mesh& mesh)
+{
+	CHECK(!mesh.positions.empty());
+	CHECK(mesh.colors.size() == mesh.positions.size());
+	for (size_t v = 0; v < mesh.colors.size(); ++v)
+		CHECK((mesh.colors[v] - colored_sphere::color(pnt_type(mesh.positions[v]))).length() < 1e-5);
+}
+
+int main()
+{
+	surface_extractor::box_type box(pnt_type(-1, -1, -1), pnt_type(1, 1, 1));
+	const unsigned res = 32;
+
+	// every marching cubes case consists of at most five triangles
+	for (unsigned c = 0; c < 256; ++c) {
+		const int8_t* e = surface_extractor::get_marching_cubes_case(c);
+		unsigned n = 0;
+		while (n < 16 && e[n] != -1)
+			++n;
+		CHECK(n % 3 == 0 && n <= 15);
+		CHECK((c == 0 || c == 255) == (n == 0));
+	}
+
+	// the dual contouring quadrics reproduce sharp edges and corners that do not lie on the grid
+	{
+		offset_cube f;
+		surface_extractor e;
+		e.dual_contouring = true;
+		e.normal_mode = ENM_FACE;
+		// the function is constant along parts of some edges, so give the refinement enough steps to find exact crossings
+		e.max_nr_root_iters = 40;
+		extracted_mesh mesh;
+		for (unsigned r : { 16u, 23u, 24u, 31u }) {
+			CHECK(e.extract(&f, box, r, mesh));
+			double max_value = 0;
+			for (const vtx_type& p : mesh.positions)
+				max_value = std::max(max_value, std::abs(offset_cube::value(pnt_type(p))));
+			CHECK(max_value < 1e-5);
+			for (int c = 0; c < 8; ++c) {
+				pnt_type corner = offset_cube::center() + pnt_type((c & 1) ? 0.5 : -0.5, (c & 2) ? 0.5 : -0.5, (c & 4) ? 0.5 : -0.5);
+				double min_dist = 1e10;
+				for (const vtx_type& p : mesh.positions)
+					min_dist = std::min(min_dist, (pnt_type(p) - corner).length());
+				CHECK(min_dist < 1e-5);
+			}
+		}
+		// truncating more eigenvalues moves vertices towards the mass points of their crossings, which stay in the cell
+		e.consistency_threshold = 0.5;
+		CHECK(e.rebuild_mesh(mesh));
+		double h = 2.0 / 30;
+		for (const vtx_type& p : mesh.positions)
+			CHECK(std::abs(offset_cube::value(pnt_type(p))) < 2 * h);
+	}
+
+	// all root refinement methods place the vertices much closer to the surface than the linear interpolation
+	{
+		wavy_sphere f;
+		surface_extractor e;
+		extracted_mesh mesh;
+		// roots are not moved away from the grid points, which would dominate the error
+		e.grid_epsilon = 0;
+		e.max_nr_root_iters = 0;
+		CHECK(e.extract(&f, box, res, mesh));
+		double linear_error = max_vertex_value(mesh);
+		size_t nr_vertices = mesh.positions.size();
+		e.max_nr_root_iters = 8;
+		const RootRefinementMethod methods[3] = { RRM_BISECTION, RRM_SECANT, RRM_NEWTON };
+		for (RootRefinementMethod m : methods) {
+			e.root_method = m;
+			CHECK(e.extract(&f, box, res, mesh));
+			CHECK(mesh.positions.size() == nr_vertices);
+			check_closed_sphere(mesh);
+			// eight bisection steps shrink the bracket to 1/256 of an edge, while secant and Newton steps converge to epsilon
+			CHECK(max_vertex_value(mesh) < (m == RRM_BISECTION ? linear_error / 4 : 1e-5));
+		}
+		// dual contouring of the same samples is closed as well
+		e.dual_contouring = true;
+		CHECK(e.rebuild_mesh(mesh));
+		check_closed_sphere(mesh);
+	}
+
+	// animating a sphere updates only the samples around its old and new location and yields the mesh of a full extraction
+	for (int dc = 0; dc < 2; ++dc) {
+		moving_spheres f;
+		surface_extractor e, reference;
+		e.dual_contouring = reference.dual_contouring = dc == 1;
+		extracted_mesh mesh, full;
+		CHECK(e.extract(&f, box, res, mesh));
+		size_t nr_full_evaluations = f.nr_evaluations;
+		// the changed box covers the sphere at both locations and the cells whose crossings it can influence
+		double margin = 0.3 + 2 * 2.0 / (res - 1);
+		for (int frame = 0; frame < 4; ++frame) {
+			double old_x = f.x;
+			f.x -= 0.03;
+			std::vector<surface_extractor::box_type> changed(1, surface_extractor::box_type(
+				pnt_type(f.x - margin, -margin, -margin), pnt_type(old_x + margin, margin, margin)));
+			f.nr_evaluations = 0;
+			CHECK(e.extract_incremental(&f, box, res, changed, mesh));
+			CHECK(f.nr_evaluations < nr_full_evaluations / 4);
+			CHECK(reference.extract(&f, box, res, full));
+			CHECK(mesh.get_nr_triangles() == full.get_nr_triangles());
+			CHECK(sorted_positions(mesh) == sorted_positions(full));
+		}
+	}
+
+	// colors of marching cubes vertices are captured with the last refinement round of their edge
+	{
+		colored_sphere f;
+		surface_extractor e;
+		extracted_mesh plain, colored;
+		CHECK(e.extract(&f, box, res, plain));
+		CHECK(plain.colors.empty());
+		size_t plain_evaluations = f.nr_evaluations;
+		f.nr_evaluations = 0;
+		e.extract_colors = true;
+		CHECK(e.extract(&f, box, res, colored));
+		check_colors(colored);
+		CHECK(colored.positions.size() == plain.positions.size());
+		CHECK(colored.triangles == plain.triangles);
+		// only edges whose root was clamped or did not converge are evaluated once more
+		size_t colored_evaluations = f.nr_evaluations + f.nr_colored_evaluations;
+		CHECK(colored_evaluations <= plain_evaluations + colored.positions.size() / 10);
+
+		// rebuilding with dual contouring evaluates the colors at the cell vertices
+		e.dual_contouring = true;
+		extracted_mesh dc;
+		CHECK(e.rebuild_mesh(dc));
+		check_colors(dc);
+		// switching back restores the colors of the crossings
+		e.dual_contouring = false;
+		CHECK(e.rebuild_mesh(dc));
+		check_colors(dc);
+
+		// incremental updates keep the colors of untouched crossings and capture the new ones
+		std::vector<surface_extractor::box_type> changed(1, surface_extractor::box_type(pnt_type(0.2, 0.2, 0.2), pnt_type(0.8, 0.8, 0.8)));
+		CHECK(e.extract_incremental(&f, box, res, changed, dc));
+		check_colors(dc);
+	}
+
+	// streamed meshes receive the colors with their vertices
+	{
+		colored_sphere f;
+		surface_extractor e;
+		e.extract_colors = true;
+		extracted_mesh mesh;
+		extracted_mesh_sink sink(mesh);
+		CHECK(e.extract_streaming(&f, box, res, sink) > 0);
+		check_colors(mesh);
+
+		// obj files list the color after each vertex
+		std::ostringstream os;
+		mesh.write_obj(os);
+		std::istringstream is(os.str());
+		std::string tag;
+		double x, y, z, r, g, b;
+		is >> tag >> x >> y >> z >> r >> g >> b;
+		CHECK(tag == "v");
+		CHECK(std::abs(r - mesh.colors[0](0)) < 1e-5 && std::abs(b - mesh.colors[0](2)) < 1e-5);
+	}
+	return test_result();
+}
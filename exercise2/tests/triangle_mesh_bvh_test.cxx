@@ -0,0 +1,99 @@
+#include "check.h"
+#include "../triangle_mesh_bvh.h"
+#include "../mesh_distance_grid.h"
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+typedef triangle_mesh_bvh::pnt_type pnt_type;
+typedef triangle_mesh_bvh::vec_type vec_type;
+
+/// outwards oriented cube [-0.5,0.5]^3 with each face split into n x n quads of two triangles
+static void make_cube(unsigned n, std::vector<pnt_type>& P, std::vector<uint32_t>& F)
+{
+	for (int axis = 0; axis < 3; ++axis)
+		for (int side = 0; side < 2; ++side) {
+			int u = (axis + 1) % 3, v = (axis + 2) % 3;
+			uint32_t base = uint32_t(P.size());
+			for (unsigned j = 0; j <= n; ++j)
+				for (unsigned i = 0; i <= n; ++i) {
+					pnt_type p;
+					p(axis) = side ? 0.5 : -0.5;
+					p(u) = -0.5 + double(i) / n;
+					p(v) = -0.5 + double(j) / n;
+					P.push_back(p);
+				}
+			for (unsigned j = 0; j < n; ++j)
+				for (unsigned i = 0; i < n; ++i) {
+					uint32_t a = base + j*(n + 1) + i, b = a + 1, c = a + n + 1, d = c + 1;
+					// u x v points along +axis, so flip the orientation on the negative side
+					if (side)
+						F.insert(F.end(), { a, b, d, a, d, c });
+					else
+						F.insert(F.end(), { a, d, b, a, c, d });
+				}
+		}
+}
+
+/// exact signed distance to the cube
+static double cube_distance(const pnt_type& p)
+{
+	double outside = 0, inside = -1e300;
+	for (int c = 0; c < 3; ++c) {
+		double d = std::abs(p(c)) - 0.5;
+		if (d > 0)
+			outside += d*d;
+		inside = std::max(inside, d);
+	}
+	return outside > 0 ? std::sqrt(outside) : inside;
+}
+
+int main()
+{
+	std::vector<pnt_type> P;
+	std::vector<uint32_t> F;
+	make_cube(8, P, F);
+	triangle_mesh_bvh mesh;
+	mesh.set_mesh(P, F);
+	mesh.build();
+	CHECK(mesh.get_nr_triangles() == 6 * 8 * 8 * 2);
+
+	// signed distances, gradients and closest points agree with the analytic cube and a brute force search
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> coord(-1.2, 1.2);
+	for (int n = 0; n < 2000; ++n) {
+		pnt_type p(coord(rng), coord(rng), coord(rng));
+		double d = mesh.signed_distance(p);
+		CHECK(std::abs(d - cube_distance(p)) < 1e-9);
+		vec_type g;
+		CHECK(std::abs(mesh.signed_distance(p, g) - d) < 1e-12);
+		if (std::abs(d) > 1e-3)
+			CHECK(std::abs(g.length() - 1) < 1e-6);
+		triangle_mesh_bvh::query_result r;
+		CHECK(mesh.find_closest_point(p, r));
+		CHECK(std::abs(std::sqrt(r.sqr_distance) - std::abs(d)) < 1e-9);
+		// a bound below the distance finds nothing
+		CHECK(!mesh.find_closest_point(p, r, 0.99*d*d) || d*d < 1e-12);
+	}
+
+	// the jump flooded grid matches the exact distances up to the interpolation error
+	sampled_grid<float> grid;
+	grid.resize(sampled_grid<float>::box_type(sampled_grid<float>::pnt_type(-1, -1, -1), sampled_grid<float>::pnt_type(1, 1, 1)), 33, 33, 33);
+	CHECK(compute_mesh_distance_grid(mesh, grid));
+	double max_error = 0;
+	for (unsigned k = 0; k < 33; ++k)
+		for (unsigned j = 0; j < 33; ++j)
+			for (unsigned i = 0; i < 33; ++i) {
+				pnt_type p(-1 + i / 16.0, -1 + j / 16.0, -1 + k / 16.0);
+				max_error = std::max(max_error, std::abs(grid.interpolate(sampled_grid<float>::pnt_type(float(p(0)), float(p(1)), float(p(2)))) - cube_distance(p)));
+			}
+	CHECK(max_error < 1e-4);
+
+	// normalize centers the mesh and scales its longest side
+	mesh.normalize(4.0);
+	mesh.build();
+	triangle_mesh_bvh::box_type b = mesh.get_box();
+	CHECK(std::abs(b.get_extent()(0) - 4) < 1e-9);
+	CHECK(std::abs(mesh.signed_distance(pnt_type(0, 0, 0)) + 2) < 1e-9);
+	return test_result();
+}
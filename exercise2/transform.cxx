@@ -10,6 +10,7 @@ struct transformation : public implicit_group<T>
 {
 	typedef typename implicit_base<T>::vec_type vec_type;
 	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::clr_type clr_type;
 
 	bool show_axes;
 
@@ -76,6 +77,24 @@ struct transformation : public implicit_group<T>
 	{
 		ctx.pop_modelview_matrix();
 	}
+	/// fused evaluation of the child at the already transformed point q
+	T evaluate_child_and_color(const pnt_type& q, clr_type& clr) const
+	{
+		if (group::get_nr_children() == 0) {
+			clr = implicit_base<T>::color;
+			return 1;
+		}
+		T value = implicit_group<T>::get_implicit_child(0)->evaluate_and_color(q, clr);
+		clr = implicit_group<T>::select_color(0, clr, q);
+		return value;
+	}
+	/// GLSL translation of the child at the already transformed point expression q
+	std::string generate_child_glsl(glsl_generator& g, const std::string& q) const
+	{
+		if (group::get_nr_children() == 0)
+			return glsl_generator::literal(1);
+		return implicit_group<T>::get_implicit_child(0)->generate_glsl(g, q);
+	}
 };
 
 
@@ -84,6 +103,7 @@ struct rotation : public transformation<T>
 {
 	typedef typename transformation<T>::vec_type vec_type;
 	typedef typename transformation<T>::pnt_type pnt_type;
+	typedef typename transformation<T>::clr_type clr_type;
 
 	vec_type axis;
 	double   angle;
@@ -118,6 +138,19 @@ struct rotation : public transformation<T>
 		T ang = angle*.1745329252e-1;
 		return rotate(implicit_group<T>::get_implicit_child(0)->evaluate_gradient(rotate(p,-ang)),ang);
 	}
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const {
+		return transformation<T>::evaluate_child_and_color(rotate(p,angle*(-.1745329252e-1)), clr);
+	}
+	bool map_to_children(pnt_type& p) const {
+		p = rotate(p,angle*(-.1745329252e-1));
+		return true;
+	}
+	/// GLSL translation with the same rotation as rotate
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const {
+		std::string a = g.add_uniform(angle);
+		std::string n = g.add_uniform3(&axis(0));
+		return transformation<T>::generate_child_glsl(g, g.add_variable("vec3", "rotate_around_axis(" + p + ", " + n + ", -.1745329252e-1*" + a + ")"));
+	}
 
 	void create_gui()
 	{
@@ -142,6 +175,7 @@ struct translation : public transformation<T>
 {
 	typedef typename transformation<T>::vec_type vec_type;
 	typedef typename transformation<T>::pnt_type pnt_type;
+	typedef typename transformation<T>::clr_type clr_type;
 
 	vec_type delta;
 
@@ -165,6 +199,17 @@ struct translation : public transformation<T>
 			return vec_type(0,0,0);
 		return implicit_group<T>::get_implicit_child(0)->evaluate_gradient(p-delta);
 	}
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const {
+		return transformation<T>::evaluate_child_and_color(p-delta, clr);
+	}
+	bool map_to_children(pnt_type& p) const {
+		p -= delta;
+		return true;
+	}
+	/// GLSL translation of the inverse translation
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const {
+		return transformation<T>::generate_child_glsl(g, g.add_variable("vec3", p + " - " + g.add_uniform3(&delta(0))));
+	}
 
 	void create_gui()
 	{
@@ -190,6 +235,7 @@ struct scaling : public transformation<T>
 {
 	typedef typename transformation<T>::vec_type vec_type;
 	typedef typename transformation<T>::pnt_type pnt_type;
+	typedef typename transformation<T>::clr_type clr_type;
 
 	vec_type scale;
 	vec_type inv_scale;
@@ -228,6 +274,25 @@ struct scaling : public transformation<T>
 		vec_type g = implicit_group<T>::get_implicit_child(0)->evaluate_gradient(q);
 		return vec_type(g(0)*inv_scale(0),g(1)*inv_scale(1),g(2)*inv_scale(2));
 	}
+	/// the inverse scaling stretches the gradient of the child by at most the largest |1/s_i|
+	T get_lipschitz_bound() const {
+		T s = std::max(std::abs(inv_scale(0)), std::max(std::abs(inv_scale(1)), std::abs(inv_scale(2))));
+		return s*implicit_group<T>::get_lipschitz_bound();
+	}
+	/// fused evaluation of value and color at the inversely transformed point
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const {
+		pnt_type q(p(0)*inv_scale(0),p(1)*inv_scale(1),p(2)*inv_scale(2));
+		return transformation<T>::evaluate_child_and_color(q, clr);
+	}
+	/// apply the inverse scaling
+	bool map_to_children(pnt_type& p) const {
+		p = pnt_type(p(0)*inv_scale(0),p(1)*inv_scale(1),p(2)*inv_scale(2));
+		return true;
+	}
+	/// GLSL translation of the inverse scaling, bound to inv_scale which on_set keeps up to date
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const {
+		return transformation<T>::generate_child_glsl(g, g.add_variable("vec3", p + "*" + g.add_uniform3(&inv_scale(0))));
+	}
 	void create_gui()
 	{
 		provider::add_member_control(this, "sx", scale(0), "value_slider", "min=0;max=3;ticks=true;log=true");
@@ -253,6 +318,7 @@ struct uniform_scaling : public transformation<T>
 {
 	typedef typename transformation<T>::vec_type vec_type;
 	typedef typename transformation<T>::pnt_type pnt_type;
+	typedef typename transformation<T>::clr_type clr_type;
 
 	double scale;
 	double inv_scale;
@@ -285,6 +351,23 @@ struct uniform_scaling : public transformation<T>
 			return vec_type(0,0,0);
 		return inv_scale * (implicit_group<T>::get_implicit_child(0)->evaluate_gradient(inv_scale*p));
 	}
+	/// the inverse scaling stretches the gradient of the child by |1/s|
+	T get_lipschitz_bound() const {
+		return std::abs(inv_scale)*implicit_group<T>::get_lipschitz_bound();
+	}
+	/// fused evaluation of value and color at the inversely transformed point
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const {
+		return transformation<T>::evaluate_child_and_color(inv_scale*p, clr);
+	}
+	/// apply the inverse scaling
+	bool map_to_children(pnt_type& p) const {
+		p *= inv_scale;
+		return true;
+	}
+	/// GLSL translation of the inverse scaling
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const {
+		return transformation<T>::generate_child_glsl(g, g.add_variable("vec3", g.add_uniform(inv_scale) + "*" + p));
+	}
 	void create_gui()
 	{
 		provider::add_member_control(this, "s", scale, "value_slider", "min=0;max=3;ticks=true;log=true");
@@ -308,6 +391,7 @@ struct shear : public transformation<T>
 {
 	typedef typename transformation<T>::vec_type vec_type;
 	typedef typename transformation<T>::pnt_type pnt_type;
+	typedef typename transformation<T>::clr_type clr_type;
 
 	double h_xy, h_xz, h_yz;
 
@@ -336,6 +420,26 @@ struct shear : public transformation<T>
 		vec_type g = implicit_group<T>::get_implicit_child(0)->evaluate_gradient(q);
 		return vec_type(g(0),g(1)-h_xy*g(0),g(2)-h_yz*g(1)-h_xz*g(0));
 	}
+	/// bound the norm of the inverse shear matrix by its Frobenius norm
+	T get_lipschitz_bound() const {
+		return T(sqrt(3 + h_xy*h_xy + h_xz*h_xz + h_yz*h_yz))*implicit_group<T>::get_lipschitz_bound();
+	}
+	/// fused evaluation of value and color at the inversely transformed point
+	T evaluate_and_color(const pnt_type& p, clr_type& clr) const {
+		pnt_type q(p(0)-h_xy*p(1)-h_xz*p(2),p(1)-h_yz*p(2), p(2));
+		return transformation<T>::evaluate_child_and_color(q, clr);
+	}
+	/// apply the inverse shear
+	bool map_to_children(pnt_type& p) const {
+		p = pnt_type(p(0)-h_xy*p(1)-h_xz*p(2),p(1)-h_yz*p(2), p(2));
+		return true;
+	}
+	/// GLSL translation of the inverse shear
+	std::string generate_glsl(glsl_generator& g, const std::string& p) const {
+		std::string xy = g.add_uniform(h_xy), xz = g.add_uniform(h_xz), yz = g.add_uniform(h_yz);
+		return transformation<T>::generate_child_glsl(g, g.add_variable("vec3",
+			"vec3(" + p + ".x-" + xy + "*" + p + ".y-" + xz + "*" + p + ".z, " + p + ".y-" + yz + "*" + p + ".z, " + p + ".z)"));
+	}
 	void create_gui()
 	{
 		provider::add_view("shear", named::name)->set("color",0x88FF88);
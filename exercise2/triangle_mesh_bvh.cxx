@@ -0,0 +1,319 @@
+#include "triangle_mesh_bvh.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cmath>
+
+/// read vertices and faces from an obj file and triangulate polygons; returns false if no triangles were found
+bool triangle_mesh_bvh::read_obj(const std::string& file_name)
+{
+	std::ifstream is(file_name.c_str());
+	if (is.fail())
+		return false;
+	std::vector<pnt_type> P;
+	std::vector<uint32_t> F;
+	std::string line;
+	std::vector<int> face;
+	while (std::getline(is, line)) {
+		if (line.size() < 2 || line[1] != ' ')
+			continue;
+		std::istringstream ls(line.substr(2));
+		if (line[0] == 'v') {
+			pnt_type p;
+			if (ls >> p(0) >> p(1) >> p(2))
+				P.push_back(p);
+		}
+		else if (line[0] == 'f') {
+			face.clear();
+			std::string token;
+			while (ls >> token) {
+				// only the position index before an optional slash is used
+				int vi = atoi(token.c_str());
+				if (vi < 0)
+					vi += int(P.size());
+				else
+					--vi;
+				if (vi < 0 || vi >= int(P.size()))
+					break;
+				face.push_back(vi);
+			}
+			for (size_t i = 2; i < face.size(); ++i) {
+				F.push_back(face[0]);
+				F.push_back(face[i - 1]);
+				F.push_back(face[i]);
+			}
+		}
+	}
+	if (F.empty())
+		return false;
+	set_mesh(P, F);
+	return true;
+}
+
+/// set the mesh from vertex locations and triangle vertex indices
+void triangle_mesh_bvh::set_mesh(const std::vector<pnt_type>& _positions, const std::vector<uint32_t>& _triangles)
+{
+	positions = _positions;
+	triangles = _triangles;
+	nodes.clear();
+	leaf_triangles.clear();
+}
+
+/// return the bounding box of the mesh
+triangle_mesh_bvh::box_type triangle_mesh_bvh::get_box() const
+{
+	if (positions.empty())
+		return box_type(pnt_type(0, 0, 0), pnt_type(0, 0, 0));
+	pnt_type p0 = positions.front(), p1 = positions.front();
+	for (const auto& p : positions)
+		for (int c = 0; c < 3; ++c) {
+			p0(c) = std::min(p0(c), p(c));
+			p1(c) = std::max(p1(c), p(c));
+		}
+	return box_type(p0, p1);
+}
+
+/// uniformly scale and translate the mesh such that its bounding box is centered at the origin and its longest side has the given length
+void triangle_mesh_bvh::normalize(double size)
+{
+	box_type B = get_box();
+	vec_type e = B.get_extent();
+	double max_extent = std::max(e(0), std::max(e(1), e(2)));
+	if (max_extent <= 0)
+		return;
+	double scale = size / max_extent;
+	pnt_type c = B.get_center();
+	for (auto& p : positions)
+		p = scale*(p - c);
+}
+
+/// compute pseudo normals of faces, edges and vertices
+void triangle_mesh_bvh::compute_pseudo_normals()
+{
+	size_t nt = get_nr_triangles();
+	face_normals.resize(nt);
+	edge_normals.assign(3*nt, vec_type(0, 0, 0));
+	vertex_normals.assign(positions.size(), vec_type(0, 0, 0));
+	std::map<std::pair<uint32_t, uint32_t>, vec_type> edge_sums;
+	for (size_t t = 0; t < nt; ++t) {
+		const uint32_t* vi = &triangles[3*t];
+		vec_type n = cross(positions[vi[1]] - positions[vi[0]], positions[vi[2]] - positions[vi[0]]);
+		double l = n.length();
+		face_normals[t] = l > 0 ? (1.0 / l)*n : vec_type(0, 0, 0);
+		for (int c = 0; c < 3; ++c) {
+			// angle weighted vertex normals
+			vec_type e0 = positions[vi[(c + 1) % 3]] - positions[vi[c]];
+			vec_type e1 = positions[vi[(c + 2) % 3]] - positions[vi[c]];
+			double l0 = e0.length(), l1 = e1.length();
+			if (l0 > 0 && l1 > 0) {
+				double cos_angle = std::max(-1.0, std::min(1.0, dot(e0, e1) / (l0*l1)));
+				vertex_normals[vi[c]] += acos(cos_angle)*face_normals[t];
+			}
+			std::pair<uint32_t, uint32_t> key(std::min(vi[c], vi[(c + 1) % 3]), std::max(vi[c], vi[(c + 1) % 3]));
+			edge_sums[key] += face_normals[t];
+		}
+	}
+	for (size_t t = 0; t < nt; ++t) {
+		const uint32_t* vi = &triangles[3*t];
+		for (int c = 0; c < 3; ++c)
+			edge_normals[3*t + c] = edge_sums[std::pair<uint32_t, uint32_t>(std::min(vi[c], vi[(c + 1) % 3]), std::max(vi[c], vi[(c + 1) % 3]))];
+	}
+}
+
+/// recursively build the bvh for leaf_triangles[begin, end) and return the node index
+uint32_t triangle_mesh_bvh::build_node(uint32_t begin, uint32_t end, const std::vector<pnt_type>& centroids)
+{
+	uint32_t ni = uint32_t(nodes.size());
+	nodes.push_back(node());
+	pnt_type b0(1e300, 1e300, 1e300), b1(-1e300, -1e300, -1e300);
+	pnt_type c0(b0), c1(b1);
+	for (uint32_t i = begin; i < end; ++i) {
+		uint32_t t = leaf_triangles[i];
+		for (int j = 0; j < 3; ++j) {
+			const pnt_type& p = positions[triangles[3*t + j]];
+			for (int c = 0; c < 3; ++c) {
+				b0(c) = std::min(b0(c), p(c));
+				b1(c) = std::max(b1(c), p(c));
+			}
+		}
+		for (int c = 0; c < 3; ++c) {
+			c0(c) = std::min(c0(c), centroids[t](c));
+			c1(c) = std::max(c1(c), centroids[t](c));
+		}
+	}
+	nodes[ni].box_min = b0;
+	nodes[ni].box_max = b1;
+	if (end - begin <= 4) {
+		nodes[ni].first = begin;
+		nodes[ni].count = end - begin;
+		return ni;
+	}
+	// split at the centroid median along the longest axis of the centroid bounds
+	vec_type e = c1 - c0;
+	int axis = e(0) > e(1) ? (e(0) > e(2) ? 0 : 2) : (e(1) > e(2) ? 1 : 2);
+	uint32_t mid = (begin + end) / 2;
+	std::nth_element(leaf_triangles.begin() + begin, leaf_triangles.begin() + mid, leaf_triangles.begin() + end,
+		[&centroids, axis](uint32_t a, uint32_t b) { return centroids[a](axis) < centroids[b](axis); });
+	build_node(begin, mid, centroids);
+	uint32_t right = build_node(mid, end, centroids);
+	nodes[ni].first = right;
+	nodes[ni].count = 0;
+	return ni;
+}
+
+/// build pseudo normals and the bvh, must be called after changing the mesh
+void triangle_mesh_bvh::build()
+{
+	compute_pseudo_normals();
+	size_t nt = get_nr_triangles();
+	std::vector<pnt_type> centroids(nt);
+	leaf_triangles.resize(nt);
+	for (size_t t = 0; t < nt; ++t) {
+		leaf_triangles[t] = uint32_t(t);
+		centroids[t] = (1.0 / 3)*(positions[triangles[3*t]] + positions[triangles[3*t + 1]] + positions[triangles[3*t + 2]]);
+	}
+	nodes.clear();
+	nodes.reserve(2*nt / 4 + 1);
+	if (nt > 0)
+		build_node(0, uint32_t(nt), centroids);
+}
+
+/// compute the closest point on triangle t to p and the pseudo normal of its feature
+void triangle_mesh_bvh::closest_point_on_triangle(uint32_t t, const pnt_type& p, pnt_type& q, vec_type& pseudo_normal) const
+{
+	const uint32_t* vi = &triangles[3*t];
+	const pnt_type& a = positions[vi[0]];
+	const pnt_type& b = positions[vi[1]];
+	const pnt_type& c = positions[vi[2]];
+	vec_type ab = b - a, ac = c - a, ap = p - a;
+	double d1 = dot(ab, ap), d2 = dot(ac, ap);
+	if (d1 <= 0 && d2 <= 0) {
+		q = a;
+		pseudo_normal = vertex_normals[vi[0]];
+		return;
+	}
+	vec_type bp = p - b;
+	double d3 = dot(ab, bp), d4 = dot(ac, bp);
+	if (d3 >= 0 && d4 <= d3) {
+		q = b;
+		pseudo_normal = vertex_normals[vi[1]];
+		return;
+	}
+	double vc = d1*d4 - d3*d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+		q = a + (d1 / (d1 - d3))*ab;
+		pseudo_normal = edge_normals[3*t];
+		return;
+	}
+	vec_type cp = p - c;
+	double d5 = dot(ab, cp), d6 = dot(ac, cp);
+	if (d6 >= 0 && d5 <= d6) {
+		q = c;
+		pseudo_normal = vertex_normals[vi[2]];
+		return;
+	}
+	double vb = d5*d2 - d1*d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+		q = a + (d2 / (d2 - d6))*ac;
+		pseudo_normal = edge_normals[3*t + 2];
+		return;
+	}
+	double va = d3*d6 - d5*d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+		q = b + ((d4 - d3) / ((d4 - d3) + (d5 - d6)))*(c - b);
+		pseudo_normal = edge_normals[3*t + 1];
+		return;
+	}
+	double denom = 1.0 / (va + vb + vc);
+	q = a + (vb*denom)*ab + (vc*denom)*ac;
+	pseudo_normal = face_normals[t];
+}
+
+/// return squared distance from p to the box of node n
+static double sqr_box_distance(const cgv::math::fvec<double, 3>& p, const cgv::math::fvec<double, 3>& b0, const cgv::math::fvec<double, 3>& b1)
+{
+	double d = 0;
+	for (int c = 0; c < 3; ++c) {
+		if (p(c) < b0(c))
+			d += (b0(c) - p(c))*(b0(c) - p(c));
+		else if (p(c) > b1(c))
+			d += (p(c) - b1(c))*(p(c) - b1(c));
+	}
+	return d;
+}
+
+/// find the closest point on the mesh; only points closer than sqrt(max_sqr_distance) are considered
+bool triangle_mesh_bvh::find_closest_point(const pnt_type& p, query_result& result, double max_sqr_distance) const
+{
+	if (nodes.empty())
+		return false;
+	result.sqr_distance = max_sqr_distance;
+	bool found = false;
+	uint32_t stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	pnt_type q;
+	vec_type n;
+	while (top > 0) {
+		const node& N = nodes[stack[--top]];
+		if (sqr_box_distance(p, N.box_min, N.box_max) >= result.sqr_distance)
+			continue;
+		if (N.count > 0) {
+			for (uint32_t i = N.first; i < N.first + N.count; ++i) {
+				uint32_t t = leaf_triangles[i];
+				closest_point_on_triangle(t, p, q, n);
+				double d = (p - q).sqr_length();
+				if (d < result.sqr_distance) {
+					result.sqr_distance = d;
+					result.closest_point = q;
+					result.pseudo_normal = n;
+					result.triangle = t;
+					found = true;
+				}
+			}
+			continue;
+		}
+		// push farther child first such that the nearer child is visited next
+		uint32_t left = uint32_t(&N - &nodes.front()) + 1, right = N.first;
+		double dl = sqr_box_distance(p, nodes[left].box_min, nodes[left].box_max);
+		double dr = sqr_box_distance(p, nodes[right].box_min, nodes[right].box_max);
+		if (dl < dr) {
+			stack[top++] = right;
+			stack[top++] = left;
+		}
+		else {
+			stack[top++] = left;
+			stack[top++] = right;
+		}
+	}
+	return found;
+}
+
+/// return the signed distance to the mesh, which is negative inside
+double triangle_mesh_bvh::signed_distance(const pnt_type& p) const
+{
+	query_result r;
+	if (!find_closest_point(p, r))
+		return 1e300;
+	double d = sqrt(r.sqr_distance);
+	return dot(p - r.closest_point, r.pseudo_normal) < 0 ? -d : d;
+}
+
+/// return the signed distance and its gradient
+double triangle_mesh_bvh::signed_distance(const pnt_type& p, vec_type& gradient) const
+{
+	query_result r;
+	if (!find_closest_point(p, r)) {
+		gradient = vec_type(0, 0, 0);
+		return 1e300;
+	}
+	double d = sqrt(r.sqr_distance);
+	vec_type v = p - r.closest_point;
+	bool inside = dot(v, r.pseudo_normal) < 0;
+	if (d > 1e-12)
+		gradient = (inside ? -1.0 / d : 1.0 / d)*v;
+	else
+		gradient = cgv::math::normalize(r.pseudo_normal);
+	return inside ? -d : d;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cgv/math/fvec.h>
+#include <cgv/media/axis_aligned_box.h>
+
+/** triangle mesh with a bounding volume hierarchy over its triangles that answers closest
+    point and signed distance queries. The sign is determined from angle weighted pseudo
+    normals of the closest feature (face, edge or vertex), which requires a closed and
+    consistently oriented mesh to be exact. */
+class triangle_mesh_bvh
+{
+public:
+	/// type of 3d point
+	typedef cgv::math::fvec<double, 3> pnt_type;
+	/// type of 3d vector
+	typedef cgv::math::fvec<double, 3> vec_type;
+	/// type of bounding box
+	typedef cgv::media::axis_aligned_box<double, 3> box_type;
+
+	/// result of a closest point query
+	struct query_result
+	{
+		/// closest point on the mesh
+		pnt_type closest_point;
+		/// squared distance from the query point to the closest point
+		double sqr_distance;
+		/// index of the triangle containing the closest point
+		uint32_t triangle;
+		/// pseudo normal of the feature containing the closest point
+		vec_type pseudo_normal;
+	};
+
+protected:
+	/// bvh node that is a leaf if count > 0 and stores the index of the right child in first otherwise, the left child directly follows the node
+	struct node
+	{
+		pnt_type box_min, box_max;
+		uint32_t first;
+		uint32_t count;
+	};
+	/// vertex locations
+	std::vector<pnt_type> positions;
+	/// three vertex indices per triangle
+	std::vector<uint32_t> triangles;
+	/// per triangle face normal
+	std::vector<vec_type> face_normals;
+	/// per triangle and edge the sum of the adjacent face normals, edge e connects corner e and (e+1)%3
+	std::vector<vec_type> edge_normals;
+	/// per vertex angle weighted normal
+	std::vector<vec_type> vertex_normals;
+	/// bvh nodes with the root at index 0
+	std::vector<node> nodes;
+	/// triangle indices referenced by the bvh leaves
+	std::vector<uint32_t> leaf_triangles;
+
+	/// compute pseudo normals of faces, edges and vertices
+	void compute_pseudo_normals();
+	/// recursively build the bvh for leaf_triangles[begin, end) and return the node index
+	uint32_t build_node(uint32_t begin, uint32_t end, const std::vector<pnt_type>& centroids);
+	/// compute the closest point on triangle t to p and the pseudo normal of its feature
+	void closest_point_on_triangle(uint32_t t, const pnt_type& p, pnt_type& q, vec_type& pseudo_normal) const;
+
+public:
+	/// construct empty mesh
+	triangle_mesh_bvh() {}
+	/// read vertices and faces from an obj file and triangulate polygons; returns false if no triangles were found
+	bool read_obj(const std::string& file_name);
+	/// set the mesh from vertex locations and triangle vertex indices
+	void set_mesh(const std::vector<pnt_type>& _positions, const std::vector<uint32_t>& _triangles);
+	/// uniformly scale and translate the mesh such that its bounding box is centered at the origin and its longest side has the given length
+	void normalize(double size = 2.0);
+	/// build pseudo normals and the bvh, must be called after changing the mesh
+	void build();
+	/// return whether the mesh contains no triangles
+	bool empty() const { return triangles.empty(); }
+	/// return the number of triangles
+	size_t get_nr_triangles() const { return triangles.size() / 3; }
+	/// return the vertex locations
+	const std::vector<pnt_type>& get_positions() const { return positions; }
+	/// return the triangle vertex indices
+	const std::vector<uint32_t>& get_triangles() const { return triangles; }
+	/// return the bounding box of the mesh
+	box_type get_box() const;
+	/// find the closest point on the mesh; only points closer than sqrt(max_sqr_distance) are considered
+	bool find_closest_point(const pnt_type& p, query_result& result, double max_sqr_distance = 1e300) const;
+	/// return the signed distance to the mesh, which is negative inside
+	double signed_distance(const pnt_type& p) const;
+	/// return the signed distance and its gradient
+	double signed_distance(const pnt_type& p, vec_type& gradient) const;
+};
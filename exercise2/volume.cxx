@@ -0,0 +1,207 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <cgv/math/fvec.h>
+#include <cgv/utils/file.h>
+#include "implicit_primitive.h"
+#include "mapped_file.h"
+
+/** implicit primitive that samples an 8 bit volume written by the volume export of the
+    implicit surface drawable. The .vox file is memory mapped and its .hd header provides
+    the resolution and the box extent, which is centered at the reflected center. Bytes are
+    mapped back linearly such that 0 corresponds to zero_value and 255 to one_value. The
+    file is only mapped on first evaluation and pages are loaded on access. */
+template <typename T>
+struct volume : public implicit_primitive<T>
+{
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+
+	/// name of the .vox file, the header is expected in the file with extension .hd
+	std::string file_name;
+	/// function values corresponding to byte values 0 and 255
+	double zero_value, one_value;
+	/// center of the volume box
+	vec_type center;
+
+protected:
+	/// header and mapping of a loaded file, which is replaced as a whole when the file changes
+	struct volume_data
+	{
+		/// memory mapping of the voxel data
+		mapped_file vox;
+		/// number of voxels along each axis
+		unsigned size[3];
+		/// extent of the volume box and distance between adjacent voxels
+		vec_type extent, voxel_extent;
+		/// return the mapped function value of a voxel
+		T get_voxel(unsigned i, unsigned j, unsigned k, double zero_value, double one_value) const
+		{
+			unsigned char b = vox.get_data()[i + size_t(size[0])*(j + size_t(size[1])*k)];
+			return T(zero_value + (one_value - zero_value)*b*(1.0/255));
+		}
+	};
+	typedef std::shared_ptr<const volume_data> data_ptr;
+	/// data of the current file or empty if not loaded, published with atomic stores such that readers keep the mapping alive while they use it
+	mutable data_ptr data;
+	/// whether the file has been tried to load since the last change
+	mutable std::atomic<bool> load_attempted;
+	/// serializes loading and the reset after changes of the file name
+	mutable std::mutex load_mutex;
+
+	/// return the data of the current file, which is loaded on first call; returns an empty pointer if no data is available
+	data_ptr get_data() const
+	{
+		data_ptr d = std::atomic_load(&data);
+		if (d || load_attempted)
+			return d;
+		std::lock_guard<std::mutex> lock(load_mutex);
+		d = std::atomic_load(&data);
+		if (d || load_attempted)
+			return d;
+		d = load();
+		std::atomic_store(&data, d);
+		load_attempted = true;
+		return d;
+	}
+	/// parse three comma separated numbers following the colon of a header line
+	template <typename S>
+	static bool parse_triple(const std::string& line, S* values)
+	{
+		std::string rest = line.substr(line.find(':') + 1);
+		for (auto& c : rest)
+			if (c == ',')
+				c = ' ';
+		std::istringstream is(rest);
+		return bool(is >> values[0] >> values[1] >> values[2]);
+	}
+	/// read the header and map the voxel data into new data; returns an empty pointer on failure
+	data_ptr load() const
+	{
+		if (file_name.empty())
+			return data_ptr();
+		std::string hd_fn = cgv::utils::file::drop_extension(file_name) + ".hd";
+		std::ifstream is(hd_fn.c_str());
+		if (is.fail()) {
+			std::cerr << "volume: could not open header " << hd_fn << std::endl;
+			return data_ptr();
+		}
+		std::shared_ptr<volume_data> d(new volume_data());
+		bool size_read = false, spacing_read = false;
+		std::string line;
+		while (std::getline(is, line)) {
+			if (line.compare(0, 5, "Size:") == 0)
+				size_read = parse_triple(line, d->size);
+			else if (line.compare(0, 8, "Spacing:") == 0)
+				spacing_read = parse_triple(line, &d->extent(0));
+		}
+		if (!size_read || !spacing_read || d->size[0] < 2 || d->size[1] < 2 || d->size[2] < 2) {
+			std::cerr << "volume: invalid header " << hd_fn << std::endl;
+			return data_ptr();
+		}
+		for (int c = 0; c < 3; ++c)
+			d->voxel_extent(c) = d->extent(c) / (d->size[c] - 1);
+		if (!d->vox.open(file_name)) {
+			std::cerr << "volume: could not map " << file_name << std::endl;
+			return data_ptr();
+		}
+		if (d->vox.get_size() < size_t(d->size[0])*d->size[1]*d->size[2]) {
+			std::cerr << "volume: " << file_name << " is smaller than declared in header" << std::endl;
+			return data_ptr();
+		}
+		return d;
+	}
+	/// trilinear interpolation of the voxels of d; outside the box the distance to the box is added to the border value
+	T evaluate(const volume_data& d, const pnt_type& p) const
+	{
+		T t[3];
+		unsigned idx[3];
+		T outside_sqr_dist = 0;
+		for (int c = 0; c < 3; ++c) {
+			T x = p(c) - (center(c) - T(0.5)*d.extent(c));
+			if (x < 0) {
+				outside_sqr_dist += x*x;
+				x = 0;
+			}
+			else if (x > d.extent(c)) {
+				outside_sqr_dist += (x - d.extent(c))*(x - d.extent(c));
+				x = d.extent(c);
+			}
+			T u = x / d.voxel_extent(c);
+			idx[c] = std::min(unsigned(u), d.size[c] - 2);
+			t[c] = std::min(u - idx[c], T(1));
+		}
+		T v = 0;
+		for (int ci = 0; ci < 8; ++ci) {
+			unsigned di = ci & 1, dj = (ci >> 1) & 1, dk = (ci >> 2) & 1;
+			T w = (di ? t[0] : 1 - t[0]) * (dj ? t[1] : 1 - t[1]) * (dk ? t[2] : 1 - t[2]);
+			v += w*d.get_voxel(idx[0] + di, idx[1] + dj, idx[2] + dk, zero_value, one_value);
+		}
+		return v + sqrt(outside_sqr_dist);
+	}
+
+public:
+	volume() : zero_value(-1), one_value(1), center(0, 0, 0), load_attempted(false)
+	{
+		implicit_base<T>::gui_color = 0xFF88FF;
+	}
+	std::string get_type_name() const { return "volume"; }
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("file", file_name) &&
+			rh.reflect_member("zero", zero_value) &&
+			rh.reflect_member("one", one_value) &&
+			rh.reflect_member("cx", center(0)) &&
+			rh.reflect_member("cy", center(1)) &&
+			rh.reflect_member("cz", center(2)) &&
+			implicit_primitive<T>::self_reflect(rh);
+	}
+	void on_set(void* member_ptr)
+	{
+		if (member_ptr == &file_name) {
+			// evaluations in other threads keep the previous mapping until they finished
+			std::lock_guard<std::mutex> lock(load_mutex);
+			std::atomic_store(&data, data_ptr());
+			load_attempted = false;
+		}
+		implicit_primitive<T>::on_set(member_ptr);
+	}
+	/// trilinear interpolation of the mapped voxels; outside the box the distance to the box is added to the border value
+	T evaluate(const pnt_type& p) const
+	{
+		data_ptr d = get_data();
+		if (!d)
+			return 1;
+		return evaluate(*d, p);
+	}
+	/// central differences with a step of one voxel
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		data_ptr d = get_data();
+		if (!d)
+			return vec_type(0, 0, 0);
+		vec_type g;
+		for (int c = 0; c < 3; ++c) {
+			pnt_type q0(p), q1(p);
+			q0(c) -= d->voxel_extent(c);
+			q1(c) += d->voxel_extent(c);
+			g(c) = (evaluate(*d, q1) - evaluate(*d, q0)) / (2 * d->voxel_extent(c));
+		}
+		return g;
+	}
+	void create_gui()
+	{
+		provider::add_member_control(this, "file", file_name);
+		provider::add_member_control(this, "zero", zero_value, "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "one", one_value, "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "cx", center(0), "value_slider", "min=-3;max=3;ticks=true");
+		provider::add_member_control(this, "cy", center(1), "value_slider", "min=-3;max=3;ticks=true");
+		provider::add_member_control(this, "cz", center(2), "value_slider", "min=-3;max=3;ticks=true");
+		implicit_primitive<T>::create_gui();
+	}
+};
+
+scene_factory_registration<volume<double> > sfr_volume("volume");